@@ -9,6 +9,11 @@ rm -rf dist
 mkdir -p "${OUT_DIR}"
 
 cp "${BIN_PATH}" "${OUT_DIR}/"
+# 预编译模板包（若已用 MinesweeperTemplatePack 生成）
+if [ -f resources/templates.mstpk ]; then
+  mkdir -p "${OUT_DIR}/resources"
+  cp resources/templates.mstpk "${OUT_DIR}/resources/"
+fi
 # 复制常见依赖（路径按 MSYS2 默认安装目录）
 if [ -d /mingw64/bin ]; then
   cp /mingw64/bin/libopencv_*.dll "${OUT_DIR}/" || true
@@ -0,0 +1,37 @@
+#include "AllocCounter.h"
+#include <opencv2/core.hpp>
+
+namespace alloccount {
+
+#ifndef NDEBUG
+static thread_local uint64_t t_matAllocs = 0;
+
+// 仅计数，实际分配交给 OpenCV 标准分配器；释放由其 UMatData::currAllocator 直接处理
+class CountingAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        if (!data) ++t_matAllocs; // 包装外部内存（如 DIB）不算分配
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+    bool allocate(cv::UMatData* u, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override {
+        return cv::Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+    }
+    void deallocate(cv::UMatData* u) const override {
+        cv::Mat::getStdAllocator()->deallocate(u);
+    }
+};
+
+void Install() {
+    static CountingAllocator allocator;
+    cv::Mat::setDefaultAllocator(&allocator);
+}
+bool Enabled() { return true; }
+uint64_t ThreadMatAllocs() { return t_matAllocs; }
+#else
+void Install() {}
+bool Enabled() { return false; }
+uint64_t ThreadMatAllocs() { return 0; }
+#endif
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+
+// 调试构建下统计 cv::Mat 缓冲分配次数（含 OpenCV 内部临时 Mat），按线程计数。
+// 用于确认分析周期在稳态下不再分配；装了 FrameArena 时只计落到堆上的分配（帧内存切分不计）。
+// 发布构建中为空操作，计数恒为 0
+namespace alloccount {
+
+// 安装计数分配器为 cv::Mat 默认分配器；进程启动时调用一次
+void Install();
+bool Enabled();
+// 当前线程累计的 Mat 分配次数
+uint64_t ThreadMatAllocs();
+
+}
@@ -0,0 +1,813 @@
+#include "BoardLocator.h"
+#include "FrameArena.h"
+#include "ScratchPool.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+using namespace cv;
+
+// 本模块独有的临时缓冲（共享的灰度/HSV/边缘图来自 FrameContext）
+enum ScratchSlot { kClosed, kPeriodPyr, kAcfIn, kAcfSpec, kAcfPower, kAcfOut, kLocatePyr0 };
+enum ScratchIntsSlot { kProjRows, kProjCols, kTileProf, kRefineCore };
+
+static ScratchPool& scratch() {
+    static thread_local ScratchPool pool;
+    return pool;
+}
+
+// 在 edges（Canny 50/150 的 ROI 视图）的 [y0, y1] 行带内做纵向投影，求左右边界
+static Rect trimColumns(const Mat& edges, int y0, int y1) {
+    int W = edges.cols;
+    Mat e = edges(Rect(0, y0, W, y1 - y0 + 1));
+    std::vector<int>& vp = scratch().Ints(kProjCols, e.cols);
+    for (int x=0; x<e.cols; ++x) vp[x] = countNonZero(e.col(x));
+    int thrX = std::max(4, (y1 - y0 + 1) / 30);
+    int left = 0; while (left < (int)vp.size() && vp[left] < thrX) left++;
+    int right = (int)vp.size()-1; while (right > left && vp[right] < thrX) right--;
+    // 轻微内缩/外扩以避免吃掉边框
+    left = std::max(0, left - 2);
+    right = std::min((int)vp.size()-1, right + 2);
+    int x0 = left, x1 = right;
+    if (x1 - x0 < W/6) { x0 = 0; x1 = W-1; } // 保护：避免退化太窄
+    return Rect(x0, y0, std::max(1, x1 - x0 + 1), std::max(1, y1 - y0 + 1));
+}
+
+// ---- 网格周期估计 ----
+static const int kMinPeriodPx = 5;         // 小于此的“格子”没有意义
+static const int kCoarseMaxLen = 512;      // 金字塔顶层长度上限：整段自相关只在这一层做
+static const int kMaxPyrLevels = 8;
+static const float kHarmonicRatio = 0.6f;  // 周期 K/m 处的相关不低于峰值的该比例时，取较小的 K/m（避免选中倍周期）
+static const int kMaxFineHarmonic = 8;     // 原分辨率上复查的最大倍数（顶层混叠时兜底）
+static const float kMinPeakCorr = 0.1f;    // 归一化自相关峰值下限，低于视为无周期
+
+static float signalEnergy(const float* x, int n) {
+    double e = 0; for (int i=0; i<n; ++i) e += double(x[i]) * x[i];
+    return n > 0 ? float(e / n) : 0.f;
+}
+
+// 单个滞后的无偏归一化自相关（x 已去均值）
+static float lagCorr(const float* x, int n, int k, float energy) {
+    double s = 0; for (int i=0; i+k<n; ++i) s += double(x[i]) * x[i+k];
+    return float(s / (n - k) / energy);
+}
+
+// 周期信号的自相关在 K、2K、3K… 处都有峰，最高峰可能落在倍周期上：
+// 从大到小尝试 m，在 peak/m 附近找到足够高的峰即取之（corr 为平滑后的相关）
+template <class Corr>
+static int fundamentalLag(Corr corr, int peak, int kMin, float best, int maxHarmonic) {
+    for (int m=std::min(maxHarmonic, peak / std::max(1, kMin)); m>=2; --m) {
+        double g = double(peak) / m;
+        int lo = std::max(kMin, (int)std::floor(g) - 1), hi = (int)std::ceil(g) + 1;
+        int bk = -1; float bc = -1e30f;
+        for (int k=lo; k<=hi; ++k) { float c = corr(k); if (c > bc) { bc = c; bk = k; } }
+        if (bk > 0 && bc >= kHarmonicRatio * best) return bk;
+    }
+    return peak;
+}
+
+// Wiener–Khinchin：补零 FFT → 功率谱 → 逆变换得整段自相关，O(n log n)。
+// 在 [kMin, n/2) 内取峰，返回峰滞后；无可信峰返回 0
+static int fftPeakLag(const float* x, int n, int kMin) {
+    int kMax = n / 2;
+    if (kMax - 2 <= std::max(2, kMin)) return 0;
+    ScratchPool& pool = scratch();
+    int N = getOptimalDFTSize(2 * n); // 补零到 ≥2n，循环相关即线性相关
+    Mat buf = pool.Take(kAcfIn, Size(N, 1), CV_32F);
+    buf.setTo(0);
+    std::copy(x, x + n, buf.ptr<float>());
+    Mat spec = pool.Take(kAcfSpec, Size(N, 1), CV_32FC2);
+    dft(buf, spec, DFT_COMPLEX_OUTPUT);
+    Mat power = pool.Take(kAcfPower, Size(N, 1), CV_32FC2);
+    mulSpectrums(spec, spec, power, 0, true); // X·conj(X) = |X|²
+    Mat acf = pool.Take(kAcfOut, Size(N, 1), CV_32F);
+    idft(power, acf, DFT_REAL_OUTPUT | DFT_SCALE);
+    const float* r = acf.ptr<float>();
+    if (r[0] <= 0.f) return 0;
+    const float e0 = r[0] / n;
+    // 无偏归一化后做 [1,2,1] 平滑：非整数周期的峰会分散到相邻两个滞后上
+    auto raw = [&](int k) { return r[k] / (n - k) / e0; };
+    auto corr = [&](int k) { return 0.25f * (raw(k-1) + 2.f * raw(k) + raw(k+1)); };
+
+    const int k0 = std::max(2, kMin);
+    float best = 0.f; int peak = 0;
+    for (int k=k0; k<kMax-1; ++k) {
+        float c = corr(k);
+        if (c > best && c >= corr(k-1) && c > corr(k+1)) { best = c; peak = k; }
+    }
+    if (best < kMinPeakCorr) return 0;
+    int lag = fundamentalLag(corr, peak, k0, best, peak);
+    // 回到未平滑的相关上取邻域最高点
+    if (lag + 1 < kMax && raw(lag + 1) > raw(lag)) lag++;
+    else if (lag - 1 >= k0 && raw(lag - 1) > raw(lag)) lag--;
+    return lag;
+}
+
+// 投影的周期（像素，亚像素精度），失败返回 0。
+// 投影按 2:1 求和逐层降采样到不超过 kCoarseMaxLen，在顶层用 FFT 自相关找峰（顶层无峰则下探一层），
+// 再逐层把滞后 ×2、只在 ±2 范围内直接求相关细化，最后在原分辨率上抛物线插值。
+// 总耗时约为 O(n)，与窗口分辨率基本无关；周期上限只受 n/2 约束
+static double estimatePeriod(const std::vector<int>& p) {
+    const int n = (int)p.size();
+    if (n < 2 * kMinPeriodPx + 2) return 0.0;
+    int levels = 1;
+    while ((n >> (levels - 1)) > kCoarseMaxLen && levels < kMaxPyrLevels) levels++;
+    Mat pyr = scratch().Take(kPeriodPyr, Size(n, levels), CV_32F);
+
+    // 各层去均值，使自相关只反映周期结构
+    auto center = [](float* x, int len) {
+        double m = 0; for (int i=0; i<len; ++i) m += x[i];
+        m /= std::max(1, len);
+        for (int i=0; i<len; ++i) x[i] -= float(m);
+    };
+    float* l0 = pyr.ptr<float>(0);
+    for (int i=0; i<n; ++i) l0[i] = float(p[i]);
+    center(l0, n);
+    for (int l=1; l<levels; ++l) {
+        const float* src = pyr.ptr<float>(l - 1);
+        float* dst = pyr.ptr<float>(l);
+        int len = n >> l;
+        for (int i=0; i<len; ++i) dst[i] = src[2*i] + src[2*i + 1];
+        center(dst, len);
+    }
+
+    int lag = 0, level = levels - 1;
+    for (; level >= 0; --level) {
+        int kMin = std::max(2, (kMinPeriodPx + (1 << level) - 1) >> level);
+        lag = fftPeakLag(pyr.ptr<float>(level), n >> level, kMin);
+        if (lag > 0) break;
+    }
+    if (lag <= 0) return 0.0;
+
+    for (int l=level-1; l>=0; --l) {
+        const float* x = pyr.ptr<float>(l);
+        int len = n >> l;
+        float e = signalEnergy(x, len);
+        if (e <= 0.f) return 0.0;
+        int guess = lag * 2, best = guess;
+        float bestR = -1e30f;
+        for (int k=std::max(1, guess - 2); k<=std::min(len / 2, guess + 2); ++k) {
+            float r = lagCorr(x, len, k, e);
+            if (r > bestR) { bestR = r; best = k; }
+        }
+        lag = best;
+    }
+
+    const float* x = pyr.ptr<float>(0);
+    float e = signalEnergy(x, n);
+    if (e <= 0.f) return 0.0;
+    auto corr = [&](int k) { return lagCorr(x, n, k, e); };
+    // 周期短到顶层无法分辨时，顶层可能锁定在倍周期上：在原分辨率上复查少量倍数
+    if (level > 0) {
+        auto smooth = [&](int k) { return 0.25f * (corr(k-1) + 2.f * corr(k) + corr(k+1)); };
+        lag = fundamentalLag(smooth, lag, kMinPeriodPx, smooth(lag), kMaxFineHarmonic);
+    }
+    while (lag + 2 < n / 2 && corr(lag + 1) > corr(lag)) lag++;
+    while (lag > kMinPeriodPx && corr(lag - 1) > corr(lag)) lag--;
+    if (lag < kMinPeriodPx) return 0.0;
+
+    // 亚像素：对 lag-1/lag/lag+1 三点拟合抛物线取顶点
+    if (lag + 1 < n / 2) {
+        float a = corr(lag - 1), b = corr(lag), c = corr(lag + 1);
+        float denom = a - 2.f * b + c;
+        if (denom < 0.f) {
+            double d = std::clamp(0.5 * (a - c) / denom, -0.5, 0.5);
+            return lag + d;
+        }
+    }
+    return double(lag);
+}
+
+// ---- 金字塔多棋盘定位 ----
+// 灰度金字塔的每层按半步重叠的瓦片求列/行梯度投影，投影做短程自相关：横纵两向都有一致周期的瓦片
+// 视为网格瓦片，周期相近的相邻瓦片连成候选区域。每层只检出 4–16 px 的周期，逐层向上即覆盖更大的
+// 格子（相邻层范围重叠，同一棋盘重复检出时合并）。只有排名靠前的区域回到原分辨率，在其附近的
+// 小窗口内求精确格距与首末网格线，原分辨率上的工作量只与棋盘面积有关
+static const int kLocateTopSide = 640;    // 金字塔顶层长边上限
+static const int kLocateFineSide = 1600;  // 长边超过此值时最细只搜到 1/2 层（原图格子 ≥ 8 px）
+static const int kMaxLocateLevels = 6;
+static const int kTileSize = 48;          // 瓦片边长（该层像素）
+static const int kTileStep = kTileSize / 2; // 瓦片步长：边长 ≥ 71 px 的棋盘至少完整覆盖一个瓦片
+static const int kTileMinPeriod = 4;
+static const int kTileMaxPeriod = 16;
+static const float kTileMinCorr = 0.5f;   // 瓦片投影归一化自相关下限
+static const int kTileMinContrast = 6;    // 网格线处平均梯度下限（灰度级），滤掉 JPEG 块效应等弱周期
+static const int kMinBoardCells = 5;      // 候选每个方向至少的格数
+static const int kMinTrustedCells = 64;   // 直接采用候选的最少格数（标准棋盘至少 8×8），更小的先走轮廓法
+static const int kMinRegionPeriods = 4;   // 粗定位区域每个方向至少跨过的周期数（求精时再按格数复核）
+static const float kLineKeep = 0.4f;      // 线强不低于 底噪 + 该比例 ×（典型线强 − 底噪）时仍算棋盘内
+static const float kLineCoverStep = 0.1f; // 逐行/列查网格线是否贯通：比格内至少高出平均线强的该比例（且 ≥ 3）算“穿过”
+static const float kLineMinCover = 0.7f;  // 贯通比例下限；成段文字的边缘只落在部分行上
+static const int kLineCoverSamples = 64;  // 贯通检查抽样的行/列数
+
+struct GridTile { float px = 0.f, py = 0.f, corr = 0.f; bool seen = false; };
+// 一层上连通的网格瓦片（tiles 以瓦片步长为单位）
+struct GridRegion {
+    int level = 0;
+    Rect tiles;
+    float px = 0.f, py = 0.f, corr = 0.f;
+    double weight = 0.0; // 覆盖的原图面积 × 平均相关，决定求精顺序
+};
+
+// 瓦片投影（长 kTileSize，由 kTileSize 行/列的梯度累加）的周期；无可信周期返回 0
+static float tilePeriod(const int* prof, float& corr) {
+    const int n = kTileSize;
+    double mean = 0; int mx = 0;
+    for (int i=0; i<n; ++i) { mean += prof[i]; mx = std::max(mx, prof[i]); }
+    mean /= n;
+    if (mx - mean < double(kTileMinContrast) * n) return 0.f;
+    float x[kTileSize];
+    for (int i=0; i<n; ++i) x[i] = float(prof[i] - mean);
+    const float e = signalEnergy(x, n);
+    if (e <= 0.f) return 0.f;
+    float c[kTileMaxPeriod + 2] = {};
+    for (int k=kTileMinPeriod-1; k<=kTileMaxPeriod+1; ++k) c[k] = lagCorr(x, n, k, e);
+    float best = 0.f;
+    for (int k=kTileMinPeriod; k<=kTileMaxPeriod; ++k) best = std::max(best, c[k]);
+    if (best < kTileMinCorr) return 0.f;
+    // 倍周期处的相关与基周期相近：取最小的足够高的局部峰，抛物线插值到亚像素
+    for (int k=kTileMinPeriod; k<=kTileMaxPeriod; ++k) {
+        if (c[k] < 0.85f * best || c[k] < c[k-1] || c[k] < c[k+1]) continue;
+        corr = c[k];
+        float denom = c[k-1] - 2.f * c[k] + c[k+1];
+        return k + (denom < 0.f ? std::clamp(0.5f * (c[k-1] - c[k+1]) / denom, -0.5f, 0.5f) : 0.f);
+    }
+    return 0.f;
+}
+
+static bool similarPeriod(const GridTile& a, const GridTile& b) {
+    return std::abs(a.px - b.px) <= 0.15f * std::max(a.px, b.px) + 0.5f &&
+           std::abs(a.py - b.py) <= 0.15f * std::max(a.py, b.py) + 0.5f;
+}
+
+// 在金字塔第 level 层 g 上找网格区域，追加到 regions
+static void findGridRegions(const Mat& g, int level, std::vector<GridRegion>& regions) {
+    const int bw = g.cols / kTileStep, bh = g.rows / kTileStep; // 半瓦片带数
+    const int tw = bw - 1, th = bh - 1;
+    if (tw <= 0 || th <= 0) return;
+    const int w = bw * kTileStep, h = bh * kTileStep;
+    // colProf[行带][x] = 该行带内 |∂x|；rowProf[列带][y] = 该列带内 |∂y|，整层一遍算完，
+    // 瓦片投影为相邻两条带之和。两者共用一个槽位，只取一次
+    std::vector<int>& bands = scratch().Ints(kTileProf, size_t(bh) * w + size_t(bw) * h);
+    int* const colProf = bands.data();
+    int* const rowProf = colProf + size_t(bh) * w;
+    for (int y=0; y<h; ++y) {
+        const uchar* p = g.ptr<uchar>(y);
+        const uchar* q = g.ptr<uchar>(std::min(y + 1, g.rows - 1));
+        int* cp = &colProf[size_t(y / kTileStep) * w];
+        for (int bx=0; bx<bw; ++bx) {
+            int* rp = &rowProf[size_t(bx) * h + y];
+            for (int x=bx*kTileStep, xe=x+kTileStep; x<xe; ++x) {
+                cp[x] += std::abs(int(p[std::min(x + 1, g.cols - 1)]) - p[x]);
+                *rp += std::abs(int(q[x]) - p[x]);
+            }
+        }
+    }
+
+    static thread_local std::vector<GridTile> tiles;
+    tiles.assign(size_t(tw) * th, GridTile());
+    int prof[kTileSize];
+    for (int ty=0; ty<th; ++ty) {
+        for (int tx=0; tx<tw; ++tx) {
+            float cx = 0.f, cy = 0.f;
+            const int* c0 = &colProf[size_t(ty) * w + tx * kTileStep];
+            for (int i=0; i<kTileSize; ++i) prof[i] = c0[i] + c0[i + w];
+            float px = tilePeriod(prof, cx);
+            if (px <= 0.f) continue;
+            const int* r0 = &rowProf[size_t(tx) * h + ty * kTileStep];
+            for (int i=0; i<kTileSize; ++i) prof[i] = r0[i] + r0[i + h];
+            float py = tilePeriod(prof, cy);
+            if (py <= 0.f || std::max(px, py) > 1.25f * std::min(px, py)) continue; // 格子近似正方形
+            GridTile& t = tiles[size_t(ty) * tw + tx];
+            t.px = px; t.py = py; t.corr = std::min(cx, cy);
+        }
+    }
+
+    // 8 邻接且周期相近的网格瓦片连成区域
+    static thread_local std::vector<int> stack;
+    const double step = double(kTileStep << level);
+    for (int seed=0; seed<tw*th; ++seed) {
+        if (tiles[seed].px <= 0.f || tiles[seed].seen) continue;
+        int x0 = tw, y0 = th, x1 = -1, y1 = -1, count = 0;
+        double sumPx = 0, sumPy = 0, sumCorr = 0;
+        stack.assign(1, seed);
+        tiles[seed].seen = true;
+        while (!stack.empty()) {
+            const int i = stack.back(); stack.pop_back();
+            const GridTile& t = tiles[i];
+            const int tx = i % tw, ty = i / tw;
+            x0 = std::min(x0, tx); x1 = std::max(x1, tx);
+            y0 = std::min(y0, ty); y1 = std::max(y1, ty);
+            sumPx += t.px; sumPy += t.py; sumCorr += t.corr; count++;
+            for (int ny=std::max(0, ty-1); ny<=std::min(th-1, ty+1); ++ny) {
+                for (int nx=std::max(0, tx-1); nx<=std::min(tw-1, tx+1); ++nx) {
+                    GridTile& u = tiles[size_t(ny) * tw + nx];
+                    if (u.px <= 0.f || u.seen || !similarPeriod(t, u)) continue;
+                    u.seen = true;
+                    stack.push_back(ny * tw + nx);
+                }
+            }
+        }
+        GridRegion r;
+        r.level = level;
+        r.tiles = Rect(x0, y0, x1 - x0 + 1, y1 - y0 + 1);
+        r.px = float(sumPx / count); r.py = float(sumPy / count); r.corr = float(sumCorr / count);
+        r.weight = count * step * step * r.corr;
+        const int spanX = (r.tiles.width - 1) * kTileStep + kTileSize, spanY = (r.tiles.height - 1) * kTileStep + kTileSize;
+        if (spanX >= kMinRegionPeriods * r.px && spanY >= kMinRegionPeriods * r.py) regions.push_back(r);
+    }
+}
+
+// 网格线：prof 为原分辨率梯度投影（depth 行/列累加），[coreLo, coreHi) 为粗定位范围。先在核心内找周期
+// 步进采样之和最大的相位，再从核心中部的线向两侧延伸到线强明显减弱处（允许缺一条线，其后须连续两条线仍在）。
+// cover(pos, half, minStep) 返回该位置上梯度比两侧格内（±half）之一高出 minStep 的行/列比例，用于确认是贯通的直线。
+// 输出首末网格线位置与其间的格数
+template <class Cover>
+static bool gridLines(const std::vector<int>& prof, int depth, int coreLo, int coreHi, double period, Cover cover,
+                      int& first, int& last, int& cells) {
+    const int n = (int)prof.size();
+    if (period < 2.0 || coreHi - coreLo < 2 * period) return false;
+    auto at = [&](double pos) { return prof[std::clamp((int)std::lround(pos), 0, n - 1)]; };
+    auto peakAt = [&](double pos) {
+        const int c = (int)std::lround(pos);
+        int v = 0;
+        for (int i=std::max(0, c-1); i<=std::min(n-1, c+1); ++i) v = std::max(v, prof[i]);
+        return v;
+    };
+    double phase = coreLo;
+    long long bestSum = -1;
+    for (int f=0; f<(int)std::ceil(period); ++f) {
+        long long sum = 0;
+        for (double pos=coreLo+f; pos<coreHi; pos+=period) sum += at(pos);
+        if (sum > bestSum) { bestSum = sum; phase = coreLo + f; }
+    }
+    // 核心内线强与格内底噪的中位数
+    static thread_local std::vector<int> on, off;
+    on.clear(); off.clear();
+    for (double pos=phase; pos<coreHi; pos+=period) {
+        on.push_back(peakAt(pos));
+        off.push_back(at(pos + period / 2));
+    }
+    if (on.size() < 2) return false;
+    auto median = [](std::vector<int>& v) {
+        std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+        return double(v[v.size() / 2]);
+    };
+    const double lineRef = median(on), base = median(off);
+    if (lineRef < 1.5 * base + 1.0) return false;
+    const double thr = base + kLineKeep * (lineRef - base);
+    // 线须高于阈值、高于至少一侧的格内、是该格距内的主峰，且贯通大部分行/列：
+    // 成片文字等杂乱边缘不会被当作延续的网格线
+    const double rise = kLineKeep * (lineRef - base);
+    const double minStep = std::max(3.0, kLineCoverStep * lineRef / std::max(1, depth));
+    // 主峰只在朝棋盘内的半格里比较（inward 为 0 时两侧都比），棋盘外紧贴的杂物不影响最外一条线
+    const int half = (int)(period / 2);
+    auto present = [&](int c, int inward) {
+        const int line = prof[c];
+        // 出界的一侧不参与比较（钳位会取到线本身）
+        const int left = c - half >= 0 ? prof[c - half] : INT_MAX, right = c + half < n ? prof[c + half] : INT_MAX;
+        if (line < thr || line - std::min(left, right) < rise) return false;
+        const int lo = inward > 0 ? c + 3 : c - half, hi = inward < 0 ? c - 3 : c + half;
+        for (int i=std::max(0, lo); i<=std::min(n-1, hi); ++i)
+            if (std::abs(i - c) > 2 && prof[i] * 0.6 > line) return false;
+        return cover(c, half, minStep) >= kLineMinCover;
+    };
+    // 在预测位置 ±1 内取实际的线并逐格重新对齐：格距的估计误差（拉伸后的非整数格距）不会沿几十格累积。
+    // 贴着窗口边缘的线可能只剩一侧像素，预测位置允许略出界
+    auto lineNear = [&](double pos, int inward) {
+        const int c = (int)std::lround(pos);
+        int best = -1;
+        for (int i=std::max(0, c - 1); i<=std::min(n - 1, c + 1); ++i)
+            if (best < 0 || prof[i] > prof[best]) best = i;
+        return best >= 0 && present(best, inward) ? best : -1;
+    };
+    // 允许缺一条线（被光标、高亮遮住），但其后须连着两条。
+    // 紧贴截图边缘的棋盘（只截了棋盘本身）最外一条线落在边界上、没有梯度，按存在计
+    auto extend = [&](int c, int dir, int& steps) {
+        for (;;) {
+            const double pos = c + dir * period;
+            if (pos < 1.0 || pos > n - 2.0) {
+                if (pos > -1.5 && pos < n + 0.5) { c = dir < 0 ? 0 : n - 1; ++steps; }
+                return c;
+            }
+            const int next = lineNear(c + dir * period, -dir);
+            if (next >= 0) { c = next; ++steps; continue; }
+            const int skip = lineNear(c + 2 * dir * period, -dir);
+            const int after = skip >= 0 ? lineNear(skip + dir * period, -dir) : -1;
+            if (after < 0) return c;
+            c = after;
+            steps += 3;
+        }
+    };
+    // 从核心中部最近的一条确认的线出发
+    const int center = (int)std::lround(((coreLo + coreHi) * 0.5 - phase) / period);
+    int k = center, mid = -1;
+    while ((mid = lineNear(phase + k * period, 0)) < 0 && std::abs(k - center) <= kMinBoardCells)
+        k = k <= center ? 2 * center - k + 1 : 2 * center - k;
+    if (mid < 0) return false;
+    int below = 0, above = 0;
+    first = extend(mid, -1, below);
+    last = extend(mid, 1, above);
+    cells = below + above;
+    return cells >= kMinBoardCells;
+}
+
+// 回到原分辨率：在区域外扩一个瓦片（及一格）的窗口内，沿区域的行/列求梯度投影，得精确格距与首末网格线
+static bool refineRegion(const Mat& gray, const GridRegion& r, BoardCandidate& out) {
+    const Rect frame(0, 0, gray.cols, gray.rows);
+    const int step = kTileStep << r.level, tile = kTileSize << r.level;
+    const Rect core = Rect(r.tiles.x * step, r.tiles.y * step, (r.tiles.width - 1) * step + tile,
+                           (r.tiles.height - 1) * step + tile) & frame;
+    if (core.area() <= 0) return false;
+    const double coarseX = double(r.px) * (1 << r.level), coarseY = double(r.py) * (1 << r.level);
+    const int pad = tile + (int)std::ceil(std::max(coarseX, coarseY)) + 2;
+    const Rect win = Rect(core.x - pad, core.y - pad, core.width + 2 * pad, core.height + 2 * pad) & frame;
+
+    // vp、hp 在整个函数里都要用，不放 ScratchPool：下面的格距估计与交叉检查还要从池里取 kRefineCore
+    static thread_local std::vector<int> vp, hp;
+    vp.assign(win.width, 0);  // 核心各行的 |∂x|，列坐标相对 win
+    hp.assign(win.height, 0); // 核心各列的 |∂y|，行坐标相对 win
+    for (int y=core.y; y<core.br().y; ++y) {
+        const uchar* p = gray.ptr<uchar>(y);
+        for (int x=win.x; x<win.br().x; ++x) vp[x - win.x] += std::abs(int(p[std::min(x + 1, gray.cols - 1)]) - p[x]);
+    }
+    for (int y=win.y; y<win.br().y; ++y) {
+        const uchar* p = gray.ptr<uchar>(y);
+        const uchar* q = gray.ptr<uchar>(std::min(y + 1, gray.rows - 1));
+        int sum = 0;
+        for (int x=core.x; x<core.br().x; ++x) sum += std::abs(int(q[x]) - p[x]);
+        hp[y - win.y] = sum;
+    }
+    // 精确格距取核心段的全程自相关；与粗估相差过大（核心混入非棋盘内容）时沿用粗估
+    auto period = [&](const std::vector<int>& prof, int lo, int len, double coarse) {
+        std::vector<int>& seg = scratch().Ints(kRefineCore, len);
+        std::copy(prof.begin() + lo, prof.begin() + lo + len, seg.begin());
+        double p = estimatePeriod(seg);
+        return (p > 0.0 && std::abs(p - coarse) <= 0.3 * coarse) ? p : coarse;
+    };
+    const double px = period(vp, core.x - win.x, core.width, coarseX);
+    const double py = period(hp, core.y - win.y, core.height, coarseY);
+    if (std::max(px, py) > 1.15 * std::min(px, py)) return false;
+    // 贯通检查：竖线在核心中部抽样若干行，横线抽样若干列，看 ±1 px 内的最大梯度。
+    // 只取中部一半：核心由瓦片拼成，边上可能越出棋盘
+    const Rect mid(core.x + core.width / 4, core.y + core.height / 4, std::max(1, core.width / 2), std::max(1, core.height / 2));
+    const int rowStep = std::max(1, mid.height / kLineCoverSamples), colStep = std::max(1, mid.width / kLineCoverSamples);
+    auto coverX = [&](int c, int half, double minStep) {
+        int hit = 0, total = 0;
+        for (int y=mid.y; y<mid.br().y; y+=rowStep, ++total) {
+            const uchar* p = gray.ptr<uchar>(y);
+            auto step = [&](int at) {
+                int d = 0;
+                for (int x=std::max(0, win.x + at - 1); x<=std::min(gray.cols - 2, win.x + at + 1); ++x)
+                    d = std::max(d, std::abs(int(p[x + 1]) - p[x]));
+                return d;
+            };
+            const int line = step(c), inside = std::min(step(c - half), step(c + half));
+            hit += line >= inside + minStep;
+        }
+        return total ? double(hit) / total : 0.0;
+    };
+    auto coverY = [&](int c, int half, double minStep) {
+        int hit = 0, total = 0;
+        for (int x=mid.x; x<mid.br().x; x+=colStep, ++total) {
+            auto step = [&](int at) {
+                int d = 0;
+                for (int y=std::max(0, win.y + at - 1); y<=std::min(gray.rows - 2, win.y + at + 1); ++y)
+                    d = std::max(d, std::abs(int(gray.ptr<uchar>(y + 1)[x]) - gray.ptr<uchar>(y)[x]));
+                return d;
+            };
+            const int line = step(c), inside = std::min(step(c - half), step(c + half));
+            hit += line >= inside + minStep;
+        }
+        return total ? double(hit) / total : 0.0;
+    };
+    // 格子总是正方形：一个方向的格距被核心里混入的杂物带偏时，换用另一方向的格距再试
+    int x0, x1, cols, y0, y1, rows;
+    if (!gridLines(vp, core.height, core.x - win.x, core.br().x - win.x, px, coverX, x0, x1, cols) &&
+        !gridLines(vp, core.height, core.x - win.x, core.br().x - win.x, py, coverX, x0, x1, cols)) return false;
+    if (!gridLines(hp, core.width, core.y - win.y, core.br().y - win.y, py, coverY, y0, y1, rows) &&
+        !gridLines(hp, core.width, core.y - win.y, core.br().y - win.y, px, coverY, y0, y1, rows)) return false;
+    // 交叉检查：最外一行（列）的格带里，另一方向的网格线也须大多成立（线上梯度明显高于格中）。
+    // 沿文字行等恰好同周期的杂物延伸出去的行列在这里剥掉
+    auto bandHolds = [&](int lo, int hi, bool rowBand) {
+        const int a0 = rowBand ? x0 : y0, a1 = rowBand ? x1 : y1, n = rowBand ? cols : rows;
+        const double pitch = double(a1 - a0) / n;
+        std::vector<int>& prof = scratch().Ints(kRefineCore, a1 - a0 + 3); // 下标 s 对应 a0 + s - 1
+        for (int t=lo; t<hi; ++t) {
+            for (int s=0; s<(int)prof.size(); ++s) {
+                const int x = std::min(win.x + (rowBand ? a0 + s - 1 : t), gray.cols - 2);
+                const int y = std::min(win.y + (rowBand ? t : a0 + s - 1), gray.rows - 2);
+                if (x < 0 || y < 0) continue;
+                const uchar* p = gray.ptr<uchar>(y);
+                prof[s] += std::abs(rowBand ? int(p[x + 1]) - p[x] : int(gray.ptr<uchar>(y + 1)[x]) - p[x]);
+            }
+        }
+        int hit = 0;
+        for (int k=0; k<=n; ++k) {
+            const int c = (int)std::lround(k * pitch) + 1;
+            const int line = std::max({prof[c - 1], prof[c], prof[std::min(c + 1, (int)prof.size() - 1)]});
+            const int m = (int)std::lround((k < n ? k + 0.5 : k - 0.5) * pitch) + 1;
+            hit += line > 1.25 * prof[m] + (hi - lo);
+        }
+        return hit >= kLineMinCover * (n + 1);
+    };
+    for (bool trimmed=true; trimmed && rows >= kMinBoardCells && cols >= kMinBoardCells; ) {
+        trimmed = false;
+        const int rh = (y1 - y0) / rows, cw = (x1 - x0) / cols;
+        if (!bandHolds(y0 + 2, y0 + rh - 1, true)) { y0 += rh; rows--; trimmed = true; }
+        else if (!bandHolds(y1 - rh + 2, y1 - 1, true)) { y1 -= rh; rows--; trimmed = true; }
+        else if (!bandHolds(x0 + 2, x0 + cw - 1, false)) { x0 += cw; cols--; trimmed = true; }
+        else if (!bandHolds(x1 - cw + 2, x1 - 1, false)) { x1 -= cw; cols--; trimmed = true; }
+    }
+    if (rows < kMinBoardCells || cols < kMinBoardCells) return false;
+    // 与 trimColumns 一样外扩 2 px，保留最外侧网格线
+    out.rect = Rect(win.x + x0 - 2, win.y + y0 - 2, x1 - x0 + 5, y1 - y0 + 5) & frame;
+    out.pitch = 0.5 * (double(x1 - x0) / cols + double(y1 - y0) / rows);
+    out.rows = rows;
+    out.cols = cols;
+    out.score = double(r.corr) * out.rect.area();
+    return out.rect.area() > 0;
+}
+
+int BoardLocator::LocateBoards(FrameContext& ctx, std::vector<BoardCandidate>& boards, int maxBoards) {
+    boards.clear();
+    if (ctx.Frame().empty() || maxBoards <= 0) return 0;
+    const Mat& gray = ctx.Gray();
+    const int side = std::max(gray.cols, gray.rows);
+    int top = 0;
+    while (top + 1 < kMaxLocateLevels && (side >> top) > kLocateTopSide) top++;
+    const int fine = std::min(top, side > kLocateFineSide ? 1 : 0);
+
+    ScratchPool& pool = scratch();
+    Mat levels[kMaxLocateLevels];
+    levels[0] = gray;
+    for (int l=1; l<=top; ++l) {
+        const Mat& src = levels[l - 1];
+        levels[l] = pool.Take(kLocatePyr0 + l, Size((src.cols + 1) / 2, (src.rows + 1) / 2), CV_8UC1);
+        pyrDown(src, levels[l], levels[l].size());
+    }
+    static thread_local std::vector<GridRegion> regions;
+    regions.clear();
+    for (int l=top; l>=fine; --l) findGridRegions(levels[l], l, regions);
+    std::sort(regions.begin(), regions.end(), [](const GridRegion& a, const GridRegion& b) { return a.weight > b.weight; });
+
+    // 同一棋盘常在相邻两层各检出一次，不同棋盘不会相交：求精后相交的合并，
+    // 保留确认网格线更多（面积更大）的结果与较高的得分
+    const size_t refineLimit = size_t(maxBoards) * 3;
+    for (size_t i=0; i<regions.size() && i<refineLimit; ++i) {
+        BoardCandidate c;
+        if (!refineRegion(gray, regions[i], c)) continue;
+        bool merged = false;
+        for (BoardCandidate& b : boards) {
+            if ((b.rect & c.rect).area() <= 0) continue;
+            const double score = std::max(b.score, c.score);
+            if (c.rect.area() > b.rect.area()) b = c;
+            b.score = score;
+            merged = true;
+            break;
+        }
+        if (!merged) boards.push_back(c);
+    }
+    std::sort(boards.begin(), boards.end(), [](const BoardCandidate& a, const BoardCandidate& b) { return a.score > b.score; });
+    if ((int)boards.size() > maxBoards) boards.resize(maxBoards);
+    return (int)boards.size();
+}
+
+const BoardCandidate* BoardLocator::PickBoard(const std::vector<BoardCandidate>& boards, int index) {
+    if (index < 0 || index >= (int)boards.size()) return nullptr;
+    static thread_local std::vector<const BoardCandidate*> order;
+    order.clear();
+    for (const BoardCandidate& b : boards) order.push_back(&b);
+    // 按上边排序；上边落在当前行首块上半部的归为同一行，行内按左边排序
+    std::sort(order.begin(), order.end(), [](const BoardCandidate* a, const BoardCandidate* b) { return a->rect.y < b->rect.y; });
+    for (size_t i=0; i<order.size(); ) {
+        const Rect& head = order[i]->rect;
+        size_t j = i + 1;
+        while (j < order.size() && order[j]->rect.y < head.y + head.height / 2) ++j;
+        std::sort(order.begin() + i, order.begin() + j, [](const BoardCandidate* a, const BoardCandidate* b) { return a->rect.x < b->rect.x; });
+        i = j;
+    }
+    return order[index];
+}
+
+bool BoardLocator::ConfirmCandidate(const BoardCandidate& candidate, int rows, int cols) {
+    return rows == candidate.rows && cols == candidate.cols && rows * cols >= kMinTrustedCells;
+}
+
+BoardLocator::BoardLocator() {
+    m_hudTopRatioPercent.store(35);
+}
+
+bool BoardLocator::IdentifyGameBounds(FrameContext& ctx, cv::Rect& gameRect) {
+    const Mat& screenCapture = ctx.Frame();
+    if (screenCapture.empty()) return false;
+
+    // 预处理：平滑后边缘（共享缓存）+ 闭运算
+    const Mat& edges = ctx.Edges(FrameContext::kEdgesBlurred);
+    Mat dil = scratch().Take(kClosed, edges.size(), CV_8UC1);
+    static const Mat kernel = FrameArena::HeapCopy(getStructuringElement(MORPH_RECT, Size(3,3)));
+    morphologyEx(edges, dil, MORPH_CLOSE, kernel);
+
+    // 查找外部轮廓（容器按线程保留容量）
+    static thread_local std::vector<std::vector<Point>> contours;
+    static thread_local std::vector<Vec4i> hierarchy;
+    static thread_local std::vector<Point> approx;
+    findContours(dil, contours, hierarchy, RETR_EXTERNAL, CHAIN_APPROX_SIMPLE);
+
+    const int W = screenCapture.cols, H = screenCapture.rows;
+    const double imgArea = double(W) * double(H);
+    double bestScore = 0.0; Rect bestRect;
+    for (auto& c : contours) {
+        if (c.size() < 4) continue;
+        double per = arcLength(c, true);
+        approxPolyDP(c, approx, 0.02 * per, true);
+        if (approx.size() != 4) continue;
+        if (!isContourConvex(approx)) continue;
+        Rect r = boundingRect(approx);
+        // 放宽过滤阈值：网页棋盘在不同缩放下可能较小
+        if (r.width < 40 || r.height < 40) continue;
+        double area = double(r.area());
+        if (area > imgArea * 0.98) continue; // 排除几乎占满整个客户区的矩形
+        // 放宽贴边限制：允许接近边缘
+        double ar = double(r.width) / double(r.height);
+        if (ar < 0.4 || ar > 2.5) continue;
+
+        // 评分：面积 + 区域内边缘密度
+        double score = area;
+        Rect shrink = r; // 稍微向内收缩以减少外框干扰
+        shrink.x += 2; shrink.y += 2; shrink.width = std::max(1, shrink.width-4); shrink.height = std::max(1, shrink.height-4);
+        Mat roi = dil(shrink);
+        double edgeCount = cv::countNonZero(roi);
+        double density = edgeCount / double(shrink.area());
+        score *= (0.5 + std::min(1.5, density * 4));
+        if (score > bestScore) { bestScore = score; bestRect = r; }
+    }
+
+    if (bestScore <= 0.0) return false;
+    gameRect = bestRect;
+    return true;
+}
+
+bool BoardLocator::RefineBoardArea(FrameContext& ctx, const cv::Rect& roi, cv::Rect& gridRect) {
+    using namespace cv;
+    if (ctx.Frame().empty() || roi.area() <= 0) return false;
+
+    int H = roi.height; int W = roi.width;
+
+    // 先用 HSV 红色掩膜（已闭运算，聚合数码管数字块）检测顶部七段数码管，得到 HUD 区域底边
+    // 仅考虑上半部分，避免棋盘内颜色干扰
+    int topPct = std::clamp(m_hudTopRatioPercent.load(), 10, 70);
+    Rect topHalf(roi.x, roi.y, W, std::max(1, H*topPct/100));
+    Mat redTop = ctx.RedMask()(topHalf);
+    int hudBottom = -1;
+    // 水平投影，找到红色像素密集的带
+    std::vector<int>& projR = scratch().Ints(kProjRows, redTop.rows);
+    for (int y=0;y<redTop.rows;++y) projR[y] = countNonZero(redTop.row(y));
+    int thrR = std::max(5, W/40);
+    for (int y=0; y<redTop.rows; ++y) {
+        if (projR[y] > thrR) hudBottom = y; // 取最后一个超过阈值的行为更稳
+    }
+    if (hudBottom >= 0) {
+        int start = std::min(H-5, hudBottom + 4); // 在 HUD 下方留一点间隙
+        // 初始上下裁剪
+        int y0 = start, y1 = H - 1;
+        // 左右精裁剪：在 [y0, y1] 之间做纵向边缘投影
+        gridRect = trimColumns(ctx.Edges(FrameContext::kEdgesDefault)(roi), y0, y1);
+        m_lastHudMethod = L"red";
+        return true;
+    }
+
+    // 回退：边缘投影法
+    Mat edges = ctx.Edges(FrameContext::kEdgesDefault)(roi);
+    std::vector<int>& proj = scratch().Ints(kProjRows, edges.rows);
+    for (int y=0;y<edges.rows;++y) proj[y] = countNonZero(edges.row(y));
+    int start = 0, end = H-1;
+    auto val = [&](int y){ return (y>=0 && y<H)? proj[y] : 0; };
+    auto smooth = [&](int y){ return (val(y-1)+val(y)+val(y+1))/3; };
+    int threshHigh = std::max(10, W/20);
+    for (int y=std::max(0,H/50); y<H/2; ++y) if (smooth(y) > threshHigh) { start = std::max(0, y-2); break; }
+    for (int y=H-1; y>start+20; --y) if (smooth(y) > threshHigh) { end = std::min(H-1, y+2); break; }
+    if (end - start < H/6) { m_lastHudMethod = L"none"; return false; }
+    // 左右精裁剪：在 [start, end] 之间做纵向边缘投影
+    gridRect = trimColumns(edges, start, end);
+    m_lastHudMethod = L"edges";
+    return true;
+}
+
+// 单图接口：为该图建立临时 FrameContext（不与其他阶段共享预处理）
+bool BoardLocator::IdentifyGameBounds(const cv::Mat& screenCapture, cv::Rect& gameRect) {
+    FrameContext ctx(screenCapture);
+    return IdentifyGameBounds(ctx, gameRect);
+}
+
+bool BoardLocator::RefineBoardArea(const cv::Mat& roiImage, cv::Rect& gridRect) {
+    FrameContext ctx(roiImage);
+    return RefineBoardArea(ctx, cv::Rect(0, 0, roiImage.cols, roiImage.rows), gridRect);
+}
+
+bool BoardLocator::AnalyzeGridLayoutEx(const cv::Mat& boardImage, int& rows, int& cols, cv::Rect& innerRect) {
+    FrameContext ctx(boardImage);
+    return AnalyzeGridLayoutEx(ctx, cv::Rect(0, 0, boardImage.cols, boardImage.rows), rows, cols, innerRect);
+}
+
+bool BoardLocator::AnalyzeGridLayout(const cv::Mat& gameArea, int& rows, int& cols) {
+    cv::Rect inner;
+    if (AnalyzeGridLayoutEx(gameArea, rows, cols, inner)) return true;
+    // 失败兜底
+    rows = 16; cols = 16; return true;
+}
+
+bool BoardLocator::AnalyzeGridLayoutEx(FrameContext& ctx, const cv::Rect& roi, int& rows, int& cols, cv::Rect& innerRect) {
+    using namespace cv;
+    if (ctx.Frame().empty() || roi.area() <= 0) return false;
+
+    // 边缘检测并在内部收缩 3px，减少外框影响
+    Mat edges = ctx.Edges(FrameContext::kEdgesGrid)(roi);
+    int H = edges.rows, W = edges.cols;
+    int margin = std::max(1, std::min(W,H)/100 + 2);
+    Rect inner(margin, margin, std::max(1,W-2*margin), std::max(1,H-2*margin));
+    Mat e = edges(inner);
+
+    // 水平与垂直投影
+    std::vector<int>& hp = scratch().Ints(kProjRows, e.rows);
+    std::vector<int>& vp = scratch().Ints(kProjCols, e.cols);
+    for (int y=0; y<e.rows; ++y) hp[y] = countNonZero(e.row(y));
+    for (int x=0; x<e.cols; ++x) vp[x] = countNonZero(e.col(x));
+
+    double periodY = estimatePeriod(hp);
+    double periodX = estimatePeriod(vp);
+    if (periodY <= 0 || periodX <= 0) return false;
+    // 计数与相位对齐用整像素步长；总宽高按亚像素周期累计，非整数格宽不会随行列数累积误差
+    int stepY = std::max(1, (int)std::lround(periodY));
+    int stepX = std::max(1, (int)std::lround(periodX));
+
+    // 估计行列数：取投影中峰的数量（以周期为步长采样）
+    auto countPeaks = [](const std::vector<int>& p, int step){
+        int n = (int)p.size(); int cnt=0;
+        for (int i=step/2; i<n; i+=step){
+            int left = std::max(0, i - step/2), right = std::min(n-1, i + step/2);
+            int mx = 0; for (int j=left;j<=right;++j) mx = std::max(mx, p[j]);
+            if (mx > 0) cnt++;
+        }
+        return std::max(1, cnt);
+    };
+    int estRows = countPeaks(hp, stepY);
+    int estCols = countPeaks(vp, stepX);
+
+    // 将 inner 区域对齐到网格线，得到纯棋盘矩形：相位取按周期步进采样投影之和最大处；
+    // 最外一条网格线可能落在收缩掉的 margin 内，ROI 上该处仍有同等强度的线时退回一格
+    auto linePhase = [](const std::vector<int>& p, double period) {
+        const int n = (int)p.size();
+        int best = 0; long long bestSum = -1;
+        for (int f=0; f<std::max(1, (int)std::lround(period)); ++f) {
+            long long sum = 0;
+            for (double pos=f; pos<n - 0.5; pos+=period) sum += p[(int)std::lround(pos)];
+            if (sum > bestSum) { bestSum = sum; best = f; }
+        }
+        return best;
+    };
+    auto lineStrength = [&](int pos, bool row) {
+        int v = 0;
+        for (int i=pos-1; i<=pos+1; ++i) {
+            if (i < 0 || i >= (row ? H : W)) continue;
+            v = std::max(v, countNonZero(row ? edges.row(i) : edges.col(i)));
+        }
+        return v;
+    };
+    int y0 = inner.y + linePhase(hp, periodY);
+    int x0 = inner.x + linePhase(vp, periodX);
+    if (y0 - stepY >= 0 && 2 * lineStrength(y0 - stepY, true) >= lineStrength(y0, true)) y0 -= stepY;
+    if (x0 - stepX >= 0 && 2 * lineStrength(x0 - stepX, false) >= lineStrength(x0, false)) x0 -= stepX;
+    // 行列数：从首条网格线按周期走到线强明显减弱处（同色已开格之间的弱线可跳过一条）；
+    // 走不出一格时沿用峰计数
+    auto countCells = [&](int start, double period, bool row) {
+        const int limit = row ? H : W;
+        const int ref = lineStrength(start, row);
+        auto present = [&](int k) {
+            const double pos = start + k * period;
+            return pos <= limit - 1 && 4 * lineStrength((int)std::lround(pos), row) >= ref;
+        };
+        int k = 0;
+        for (;;) {
+            if (present(k + 1)) k += 1;
+            else if (present(k + 2)) k += 2;
+            else return k;
+        }
+    };
+    int hCells = countCells(y0, periodY, true);
+    int wCells = countCells(x0, periodX, false);
+    if (hCells < 1) hCells = estRows;
+    if (wCells < 1) wCells = estCols;
+    int hPx = (int)std::lround(hCells * periodY);
+    int wPx = (int)std::lround(wCells * periodX);
+    // 边界防护
+    if (y0 + hPx > H) hCells = std::max(1, int((H - y0) / periodY)), hPx = (int)std::lround(hCells * periodY);
+    if (x0 + wPx > W) wCells = std::max(1, int((W - x0) / periodX)), wPx = (int)std::lround(wCells * periodX);
+
+    rows = hCells; cols = wCells;
+    innerRect = Rect(inner.x + (x0 - inner.x), inner.y + (y0 - inner.y), wPx, hPx);
+    return true;
+}
+
+void BoardLocator::SetHudTopRatioPercent(int p) { m_hudTopRatioPercent.store(p); }
+int BoardLocator::GetHudTopRatioPercent() const { return m_hudTopRatioPercent.load(); }
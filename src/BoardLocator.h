@@ -0,0 +1,55 @@
+#ifndef BOARD_LOCATOR_H
+#define BOARD_LOCATOR_H
+
+#include "FrameContext.h"
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <atomic>
+#include <vector>
+
+// 金字塔定位得到的候选棋盘（帧内坐标）
+struct BoardCandidate {
+    cv::Rect rect;           // 首末网格线围成的网格区域（各向外扩 2 px），可直接交给 AnalyzeGridLayoutEx
+    double pitch = 0.0;      // 格距（像素，亚像素精度）
+    int rows = 0, cols = 0;  // 按网格线计数的行列（布局阶段复核）
+    double score = 0.0;      // 周期相关强度 × 面积
+};
+
+// 棋盘定位（纯图像处理，不依赖平台）：外框识别、HUD 剔除与网格布局。
+// FrameContext 版本共享同一帧的灰度/HSV/红色掩膜/边缘图，roi 为帧内坐标，
+// 输出矩形与单图版本一致（相对 roi 左上角）。单图版本为各自建立临时上下文
+class BoardLocator {
+public:
+    BoardLocator();
+
+    // 多棋盘定位：在灰度金字塔上按瓦片搜索横纵两向都有网格周期的区域，返回全部候选
+    // （按 score 从高到低，至多 maxBoards 个）；只有排名靠前的候选回到原分辨率求精确网格线。
+    // 返回候选数；为 0 时可退回 IdentifyGameBounds
+    int LocateBoards(FrameContext& ctx, std::vector<BoardCandidate>& boards, int maxBoards = 8);
+    // 按阅读顺序（自上而下、同一行内自左向右）取第 index 块棋盘，供多棋盘绑定；不存在返回 nullptr
+    static const BoardCandidate* PickBoard(const std::vector<BoardCandidate>& boards, int index);
+    // 候选能否直接采用：网格线计数与 AnalyzeGridLayoutEx 的行列一致，且格数不过少。
+    // 被截掉几行几列的候选上抽到的仍是真网格线，布局校验拦不住，只能靠两种计数互相印证
+    static bool ConfirmCandidate(const BoardCandidate& candidate, int rows, int cols);
+    // 原分辨率轮廓法：找面积与边缘密度最大的四边形外框（含 HUD），只返回一个
+    bool IdentifyGameBounds(FrameContext& ctx, cv::Rect& gameRect);
+    bool RefineBoardArea(FrameContext& ctx, const cv::Rect& roi, cv::Rect& gridRect);
+    bool AnalyzeGridLayoutEx(FrameContext& ctx, const cv::Rect& roi, int& rows, int& cols, cv::Rect& innerRect);
+
+    bool IdentifyGameBounds(const cv::Mat& screenCapture, cv::Rect& gameRect);
+    bool AnalyzeGridLayout(const cv::Mat& gameArea, int& rows, int& cols);
+    bool RefineBoardArea(const cv::Mat& roiImage, cv::Rect& gridRect);
+    // 更精确的网格布局识别，输出行列数以及裁剪后的纯棋盘内矩形
+    bool AnalyzeGridLayoutEx(const cv::Mat& boardImage, int& rows, int& cols, cv::Rect& innerRect);
+
+    const std::wstring& GetLastHudMethod() const { return m_lastHudMethod; }
+    // HUD 顶部高度比例（百分比，默认 35）
+    void SetHudTopRatioPercent(int p);
+    int GetHudTopRatioPercent() const;
+
+private:
+    std::wstring m_lastHudMethod; // "red" or "edges" or "none"
+    std::atomic<int> m_hudTopRatioPercent; // 35 by default
+};
+
+#endif
@@ -0,0 +1,420 @@
+#include "BoardPipeline.h"
+#include "DisplayWindow.h"
+#include "SessionRecorder.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "AllocCounter.h"
+#include <algorithm>
+#include <sstream>
+
+// 用户设置（全局热键调整，所有目标共用）
+extern std::atomic<bool> g_enableMouseMove;
+extern std::atomic<bool> g_enableAutoClick;
+extern std::atomic<int> g_clickIntervalMs;
+extern std::atomic<int> g_clickRandomMs;
+extern std::atomic<int> g_clickPosJitterPx;
+extern std::atomic<bool> g_showLatency;
+
+static const DWORD kRelayoutMinIntervalMs = 600; // 节流最小间隔
+static const int kLayoutVerifyFailLimit = 2;     // 已锁定布局连续校验失败多少帧后重新识别
+static const int kMaxSpeculationRounds = 8;      // 每帧推测展开的最大轮数
+// 自适应捕获节奏：画面变化或刚点击后快速捕获，静止时逐步退避
+static const int kCaptureFastMs = 33;
+static const int kCaptureIdleMs = 250;
+static const DWORD kCaptureFastAfterClickMs = 1000;
+// 画面无变化时的兜底分析间隔（刷新状态、核对未生效的点击）
+static const int kAnalysisHeartbeatMs = 2000;
+
+// 布局缓存键：窗口类名 + 标题（UTF-8）
+static std::string WindowLayoutKey(HWND hwnd) {
+    wchar_t title[256]{}; GetWindowTextW(hwnd, title, 255);
+    wchar_t cls[128]{}; GetClassNameW(hwnd, cls, 127);
+    std::wstring key = std::wstring(cls) + L"|" + title;
+    int n = WideCharToMultiByte(CP_UTF8, 0, key.c_str(), int(key.size()), nullptr, 0, nullptr, nullptr);
+    std::string out(n > 0 ? n : 0, '\0');
+    if (n > 0) WideCharToMultiByte(CP_UTF8, 0, key.c_str(), int(key.size()), &out[0], n, nullptr, nullptr);
+    return out;
+}
+
+// 当前全局点击参数
+static InputPacing CurrentPacing() {
+    InputPacing p;
+    p.intervalMs = std::max(0, g_clickIntervalMs.load());
+    p.randomMs = std::max(0, g_clickRandomMs.load());
+    p.posJitterPx = std::max(0, g_clickPosJitterPx.load());
+    return p;
+}
+
+BoardPipeline::BoardPipeline(HWND hwnd, GameAnalyzer& analyzer, WorkerPool& pool, LayoutCache& layoutCache,
+                             DisplayWindow& display, SessionRecorder& recorder, std::mutex& clickLock, int boardIndex)
+    : m_hwnd(hwnd), m_boardIndex(std::max(0, boardIndex)), m_analyzer(analyzer), m_pool(pool), m_layoutCache(layoutCache),
+      m_display(display), m_recorder(recorder),
+      m_input(hwnd), m_executor(m_input, 64, &clickLock) {
+    m_capture.SetGameWindow(hwnd);
+    m_ctx.SetAllocator(FrameArena::HeapAllocator());
+    m_layoutKey = WindowLayoutKey(hwnd);
+    if (m_boardIndex > 0) m_layoutKey += "#" + std::to_string(m_boardIndex);
+    m_state.rows = 16;
+    m_state.cols = 16;
+    m_state.mineCount = 40;
+    m_prevState = m_state;
+    m_executor.SetOnDispatch([this]{ m_lastClickTick.store(GetTickCount()); });
+}
+
+BoardPipeline::~BoardPipeline() {
+    Stop();
+}
+
+void BoardPipeline::Start() {
+    if (m_running.exchange(true)) return;
+    m_poolId = m_pool.Register();
+    m_executor.Start();
+    m_captureThread = std::thread(&BoardPipeline::CaptureLoop, this);
+}
+
+void BoardPipeline::Stop() {
+    if (!m_running.exchange(false)) return;
+    if (m_captureThread.joinable()) m_captureThread.join();
+    // 丢弃排队中的分析任务并等待正在执行的结束，之后不再有任务访问本对象
+    m_pool.Unregister(m_poolId);
+    m_executor.Clear();
+    m_executor.Stop();
+}
+
+void BoardPipeline::CaptureLoop() {
+    using clock = std::chrono::steady_clock;
+    auto lastReport = clock::now();
+    auto lastSubmit = clock::now();
+    int frames = 0;
+    double captureMsSum = 0.0;
+    int intervalMs = kCaptureFastMs;
+    m_detector.Reset();
+    trace::SetThreadName("capture " + std::to_string(m_poolId));
+    while (m_running) {
+        // 直接捕获到 back 槽对应的 DIB；分析任务持有的 front 槽不会被覆盖
+        CapturedFrame& slot = m_buffer.Back();
+        auto tc0 = clock::now();
+        bool captured = m_capture.CaptureGameArea(slot.image, &slot.rect, m_buffer.BackIndex());
+        slot.capturedAt = clock::now();
+        captureMsSum += std::chrono::duration<double, std::milli>(slot.capturedAt - tc0).count();
+        metrics::Record(metrics::Stage::Capture, tc0, slot.capturedAt);
+        bool changed = false;
+        if (captured) {
+            changed = m_detector.Update(slot.image, slot.rect);
+            // 录制仅入队 ROI 副本，编码写盘在录制器后台线程；多目标时只录显示目标
+            if (m_focused && m_recorder.IsRecording()) {
+                cv::Rect board = m_capture.GetBoardRegion();
+                cv::Rect local(board.x - slot.rect.x, board.y - slot.rect.y, board.width, board.height);
+                m_recorder.Submit(slot.image, local, slot.rect.tl());
+            }
+            slot.seq = ++m_captureSeq;
+            m_buffer.Publish();
+            metrics::Add(metrics::Counter::FramesCaptured);
+            // 时间线：帧的流从这里开始，经分析任务连到它产生的点击
+            TRACE_FLOW('s', trace::FlowId(m_poolId, slot.seq));
+            // 画面变化才提交分析任务（未开始的旧任务被新任务替换）；静止时只按心跳兜底
+            auto now = clock::now();
+            if (changed || now - lastSubmit >= std::chrono::milliseconds(kAnalysisHeartbeatMs)) {
+                m_pool.Submit(m_poolId, [this]{ AnalyzeLatest(); });
+                lastSubmit = now;
+            }
+            frames++;
+        }
+        auto now = clock::now();
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastReport).count();
+        if (ms >= 1000) {
+            m_captureFps.store(frames * 1000.0 / ms);
+            if (frames > 0) m_captureMs.store(captureMsSum / frames);
+            frames = 0;
+            captureMsSum = 0.0;
+            lastReport = now;
+        }
+        // 变化或刚点击过：快速捕获以尽快看到结果；否则按 1.5 倍退避到空闲节奏
+        DWORD sinceClick = GetTickCount() - m_lastClickTick.load();
+        if (changed || sinceClick < kCaptureFastAfterClickMs) intervalMs = kCaptureFastMs;
+        else intervalMs = std::min(kCaptureIdleMs, intervalMs * 3 / 2);
+        auto tc1 = clock::now();
+        if (trace::Enabled()) trace::Complete("capture_cycle", tc0, tc1);
+        auto spent = std::chrono::duration_cast<std::chrono::milliseconds>(tc1 - tc0).count();
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::max<long long>(1, intervalMs - spent)));
+    }
+}
+
+void BoardPipeline::LockLayout() {
+    m_layoutLocked = true;
+    m_verifyFailures = 0;
+    m_capture.SetBoardRegion(m_layout.region);
+    // 变化检测只盯网格区域，HUD 计时器跳动不会触发分析
+    m_detector.SetWatchRegion(m_layout.inner);
+    if (!m_focused) return;
+    // 显示窗口吸附到棋盘旁：region 为客户区坐标，转为屏幕坐标
+    POINT clientTopLeft{0,0}; ClientToScreen(m_hwnd, &clientTopLeft);
+    RECT screenRect{ clientTopLeft.x + m_layout.region.x, clientTopLeft.y + m_layout.region.y,
+                     clientTopLeft.x + m_layout.region.x + m_layout.region.width,
+                     clientTopLeft.y + m_layout.region.y + m_layout.region.height };
+    m_display.SnapNear(screenRect);
+}
+
+// 解除锁定：捕获回退整客户区，变化检测回到整帧
+void BoardPipeline::UnlockLayout() {
+    m_layout = BoardLayout();
+    m_layoutLocked = false;
+    m_verifyFailures = 0;
+    m_capture.SetBoardRegion(cv::Rect());
+    m_detector.SetWatchRegion(cv::Rect());
+}
+
+// 线程池任务：分析最新一帧（同一目标的任务由线程池串行执行）
+void BoardPipeline::AnalyzeLatest() {
+    TRACE_SPAN("analyze");
+    // 本周期的临时 Mat 从帧内存切分，函数返回时回绕（含各提前返回的路径）
+    FrameArena::Scope arena(m_arena);
+    // 无锁取最新帧：front 槽归分析任务所有，直到下一次 Acquire
+    if (m_buffer.Acquire()) m_haveFrame = true;
+    if (!m_haveFrame) return;
+    const CapturedFrame& frame = m_buffer.Front();
+    if (frame.seq == m_lastSeq) return;
+    m_lastSeq = frame.seq;
+    const uint64_t flow = trace::FlowId(m_poolId, frame.seq);
+    TRACE_FLOW('t', flow);
+    const uint64_t allocBase = alloccount::ThreadMatAllocs();
+    // 以下各阶段只使用 currentImage 的 ROI 视图，不拷贝像素
+    const cv::Mat& currentImage = frame.image;
+    const cv::Rect frameRect = frame.rect; // currentImage 在客户区中的位置；以下 ROI 均为客户区坐标
+    if (currentImage.empty()) return;
+    m_ctx.Reset(currentImage);
+    GameState& state = m_state;
+
+    // 客户区坐标 → currentImage 内坐标
+    auto local = [&](const cv::Rect& r) {
+        return cv::Rect(r.x - frameRect.x, r.y - frameRect.y, r.width, r.height);
+    };
+    RECT crc{}; GetClientRect(m_hwnd, &crc);
+    const cv::Size curSize(crc.right-crc.left, crc.bottom-crc.top);
+    // 窗口尺寸变化：放弃当前布局，换用该尺寸下缓存的布局或重新识别
+    if (m_layout.Valid() && m_layout.clientSize != curSize) UnlockLayout();
+    if (!m_layout.Valid()) m_layoutCache.Find(m_layoutKey, curSize, m_layout);
+
+    // 有布局（已锁定或来自缓存）：逐帧抽样校验网格线，代替每帧重新识别
+    if (m_layout.Valid()) {
+        bool verified;
+        {
+            STAGE_TIMER(LayoutVerify);
+            verified = LayoutCache::Verify(m_ctx.Gray(), frameRect.tl(), m_layout);
+        }
+        if (verified) {
+            m_verifyFailures = 0;
+            if (!m_layoutLocked) LockLayout();
+        } else if (!m_layoutLocked || ++m_verifyFailures >= kLayoutVerifyFailLimit) {
+            // 缓存布局首帧即不符，或已锁定布局连续不符：作废并重新识别
+            LOGI(m_layoutLocked ? "布局校验连续失败，重新识别" : "缓存布局与画面不符，重新识别");
+            metrics::Add(metrics::Counter::LayoutInvalidations);
+            m_layoutCache.Invalidate(m_layoutKey, curSize);
+            UnlockLayout();
+        }
+    }
+
+    DWORD now = GetTickCount();
+    bool throttled = (now - m_lastRelayoutTick < kRelayoutMinIntervalMs);
+    if (!m_layout.Valid() && !throttled) {
+        // 完整识别：金字塔定位取第 m_boardIndex 块棋盘；定位不到时（只对第 0 块）
+        // 退回轮廓法定位 → 细化（剔除顶部 HUD），再做网格布局
+        {
+            STAGE_TIMER(LocateBoards);
+            m_capture.LocateBoards(m_ctx, m_boards);
+        }
+        m_boardsSeen.store((int)m_boards.size());
+        const BoardCandidate* picked = BoardLocator::PickBoard(m_boards, m_boardIndex);
+        cv::Rect region;
+        bool found = false;
+        cv::Rect roi = frameRect;
+        int rows=0, cols=0; cv::Rect inner;
+        bool laidOut = false;
+        if (picked) {
+            // 候选为 currentImage 内坐标；ROI 捕获也只取这块棋盘
+            region = cv::Rect(picked->rect.x + frameRect.x, picked->rect.y + frameRect.y,
+                              picked->rect.width, picked->rect.height) & frameRect;
+            if (region.area() > 0) {
+                {
+                    STAGE_TIMER(GridLayout);
+                    laidOut = m_capture.AnalyzeGridLayoutEx(m_ctx, local(region), rows, cols, inner);
+                }
+                // 行列与布局分析对不上（截断的棋盘）或格数过少时不采用，退回轮廓法
+                if (laidOut && BoardLocator::ConfirmCandidate(*picked, rows, cols)) {
+                    found = true;
+                    roi = region;
+                } else {
+                    LOGD("定位候选 {}x{} 与布局 {}x{} 不符，退回轮廓法", picked->rows, picked->cols, rows, cols);
+                    laidOut = false;
+                }
+            }
+        }
+        if (!found && m_boardIndex == 0) {
+            {
+                STAGE_TIMER(IdentifyBounds);
+                found = m_capture.IdentifyGameBounds(m_ctx, region);
+            }
+            if (found) {
+                region.x += frameRect.x;
+                region.y += frameRect.y;
+                roi = region & frameRect;
+                if (roi.area() <= 0) roi = frameRect;
+            }
+            cv::Rect gridRect;
+            bool refined;
+            {
+                STAGE_TIMER(RefineBoard);
+                refined = m_capture.RefineBoardArea(m_ctx, local(roi), gridRect);
+            }
+            if (refined) {
+                // 叠加到客户区坐标
+                gridRect.x += roi.x;
+                gridRect.y += roi.y;
+                cv::Rect g = gridRect & frameRect;
+                if (g.area() > 0) roi = g;
+            }
+            {
+                STAGE_TIMER(GridLayout);
+                laidOut = m_capture.AnalyzeGridLayoutEx(m_ctx, local(roi), rows, cols, inner);
+            }
+        }
+        if (laidOut && rows>0 && cols>0) {
+            // 转回客户区坐标
+            inner.x += roi.x;
+            inner.y += roi.y;
+            m_layout.clientSize = curSize;
+            m_layout.region = found ? region : frameRect;
+            m_layout.gridRect = roi;
+            m_layout.inner = inner & frameRect;
+            m_layout.rows = rows; m_layout.cols = cols;
+            if (m_layout.Valid()) {
+                m_layoutCache.Store(m_layoutKey, m_layout);
+                metrics::Add(metrics::Counter::LayoutDetections);
+                LOGI("布局识别: {}x{} 格, 网格 {}x{} px", rows, cols, m_layout.inner.width, m_layout.inner.height);
+                LockLayout();
+                m_lastRelayoutTick = now;
+            }
+        }
+    }
+    // 布局已锁定：让捕获线程只拷贝棋盘区域（校验失败时捕获端会自行解除）
+    if (m_layoutLocked && m_capture.GetBoardRegion().area() <= 0) {
+        m_capture.SetBoardRegion(m_layout.region);
+    }
+    // 多棋盘绑定的其余各块没有整帧退路：找不到自己那块就不识别，免得点到别的棋盘上
+    if (!m_layoutLocked && m_boardIndex > 0) return;
+    cv::Rect roiToUse = frameRect;
+    if (m_layoutLocked) {
+        roiToUse = m_layout.inner & frameRect;
+        if (roiToUse.area() <= 0) roiToUse = frameRect;
+        state.rows = m_layout.rows; state.cols = m_layout.cols;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    bool recognized = m_analyzer.AnalyzeGameState(m_ctx, local(roiToUse), state);
+    metrics::Record(metrics::Stage::Recognize, t0, std::chrono::steady_clock::now());
+    if (!recognized) return;
+
+    auto tv0 = std::chrono::steady_clock::now();
+    // 多帧投票：若本帧识别为未知(9)，上一帧非未知，则沿用上一帧；若两帧不一致且都非未知，保留上一帧（保守）
+    if (m_prevState.rows == state.rows && m_prevState.cols == state.cols) {
+        uint64_t reclassified = 0;
+        const bool flags = m_prevState.ambiguous.size() == state.ambiguous.size();
+        for (int r=0;r<state.rows;++r){
+            for (int c=0;c<state.cols;++c){
+                int cur = state.grid[r][c];
+                int prv = m_prevState.grid[r][c];
+                if (cur != prv) reclassified++;
+                // 沿用上一帧的值时一并沿用其“只按主色判定”标记
+                if ((cur == 9 && prv != 9) || (cur != 9 && prv != 9 && cur != prv)) { // 稳定优先
+                    state.grid[r][c] = prv;
+                    const size_t i = size_t(r) * state.cols + c;
+                    if (flags) state.ambiguous[i] = m_prevState.ambiguous[i];
+                }
+            }
+        }
+        if (reclassified > 0) metrics::Add(metrics::Counter::CellsReclassified, reclassified);
+    }
+    m_prevState = state;
+    auto t1 = std::chrono::steady_clock::now();
+    metrics::Record(metrics::Stage::Vote, tv0, t1);
+    m_analyzeMs.store(std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count());
+
+    // 先用本帧（未叠加推测）核对已派发的点击与推测
+    m_executor.OnState(state, frame.capturedAt);
+    if (!m_speculation.Reconcile(state, std::chrono::steady_clock::now())) {
+        m_executor.Clear();
+        LOGI("推测与画面矛盾，已回滚待定格");
+    }
+    const bool autoClick = g_enableAutoClick.load();
+    std::vector<cv::Point> safeMoves;
+    std::vector<cv::Point> mines;
+    {
+        STAGE_TIMER(Solve);
+        if (autoClick) {
+            // 推测展开：已判安全的格子视为已翻开（数字未知），继续推理到没有新结论，
+            // 不等点击生效后的下一帧
+            auto tnow = std::chrono::steady_clock::now();
+            m_speculation.Overlay(state);
+            for (int round = 0; round < kMaxSpeculationRounds; ++round) {
+                std::vector<cv::Point> more = m_analyzer.FindSafeMoves(state, round == 0 ? &mines : nullptr);
+                if (more.empty()) break;
+                m_speculation.MarkPending(more, tnow);
+                m_speculation.Overlay(state);
+            }
+            safeMoves = m_speculation.Pending();
+        } else {
+            m_speculation.Clear();
+            safeMoves = m_analyzer.FindSafeMoves(state, &mines);
+        }
+    }
+    const bool unknownLeft = std::any_of(state.grid.begin(), state.grid.end(),
+        [](const std::vector<int>& row){ return std::find(row.begin(), row.end(), 9) != row.end(); });
+    metrics::CountSolveOutcome(safeMoves.size(), mines.size(), unknownLeft);
+    metrics::Record(metrics::Stage::FrameToDecision, std::chrono::steady_clock::now() - frame.capturedAt);
+    state.safeCells = safeMoves; // 供渲染高亮
+    LOGD("帧 {}: {}x{} 安全 {} 待定 {} 分析 {} ms", frame.seq, state.rows, state.cols, safeMoves.size(),
+         m_speculation.PendingCount(), m_analyzeMs.load());
+    if (autoClick) {
+        m_executor.SetPacing(CurrentPacing());
+        m_executor.Submit(roiToUse, state.rows, state.cols, safeMoves, false, flow);
+    } else {
+        m_executor.Clear();
+    }
+    m_cycleMatAllocs = alloccount::ThreadMatAllocs() - allocBase;
+    if (m_focused) PublishStatus(state, roiToUse);
+}
+
+// 更新辅助窗口与状态栏：窗口信息 + FPS/耗时 + 网格信息（仅显示目标）
+void BoardPipeline::PublishStatus(const GameState& state, const cv::Rect& roiToUse) {
+    m_display.Update(state);
+    wchar_t title[256]{}; GetWindowTextW(m_hwnd, title, 255);
+    wchar_t cls[128]{}; GetClassNameW(m_hwnd, cls, 127);
+    RECT rcClient{}; GetClientRect(m_hwnd, &rcClient);
+    int cellW = (state.cols>0)? (roiToUse.width / state.cols) : 0;
+    int cellH = (state.rows>0)? (roiToUse.height / state.rows) : 0;
+    std::wstringstream ss;
+    ss.setf(std::ios::fixed); ss.precision(1);
+    ss << L"窗口: " << title << L"  类: " << cls
+       << L"  客户区: " << (rcClient.right-rcClient.left) << L"x" << (rcClient.bottom-rcClient.top)
+       << L"\nROI: " << roiToUse.width << L"x" << roiToUse.height
+       << L"  Capture: " << m_capture.GetLastCaptureMethod()
+       << L"  HUD: " << m_capture.GetLastHudMethod()
+       << L"  Grid: " << state.rows << L"x" << state.cols
+       << L"  Cell: " << cellW << L"x" << cellH
+       << L"  Auto: " << (g_enableAutoClick.load()? L"ON" : L"OFF")
+       << L"  Intv: " << g_clickIntervalMs.load() << L"±" << g_clickRandomMs.load() << L"ms"
+       << L"  Jit: ±" << g_clickPosJitterPx.load() << L"px"
+       << L"  Mouse: " << (g_enableMouseMove.load()? L"ON" : L"OFF");
+    if (m_recorder.IsRecording())
+        ss << L"  Rec: " << m_recorder.GetFramesWritten() << L"帧/" << (m_recorder.GetBytesWritten() / 1024) << L"KB";
+    ss << L"  FPS: " << m_captureFps.load() << L"  捕获: " << m_captureMs.load() << L" ms  分析: " << m_analyzeMs.load()
+       << L" ms  (F8 选择 | Shift+F8 添加 | Ctrl+F8 切换 | Ctrl+Shift+F8 移除 | F9 鼠标 | F10 自动 | F11/F12 间隔 | F6/F7 随机 | F3/F4 坐标抖动 | F5 录制 | F2 延迟 | Ctrl+F2 转储 | +/- HUD%)";
+    InputExecutor::Stats is = m_executor.GetStats();
+    ss << L"  点击: " << is.dispatched << L" 确认 " << is.confirmed << L" 重试 " << is.retried << L" 取消 " << is.cancelled;
+    ss << L"  待定: " << m_speculation.PendingCount() << L" 回滚 " << m_speculation.GetStats().rolledBack;
+    ss << L"  线程池: " << m_pool.ThreadCount() << L" 线程 / 合并 " << m_pool.Coalesced();
+    ss << L"  帧内存: " << (m_arena.LastFrameBytes() / 1024) << L"/" << (m_arena.PeakBytes() / 1024) << L"KB";
+    if (alloccount::Enabled()) ss << L"  堆Mat分配/周期: " << m_cycleMatAllocs;
+    if (g_showLatency.load()) ss << L"\n" << metrics::FormatStatus();
+    m_display.SetStatusText(ss.str());
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include "WindowCapture.h"
+#include "GameAnalyzer.h"
+#include "Win32InputSink.h"
+#include "InputExecutor.h"
+#include "SpeculativeState.h"
+#include "FrameChangeDetector.h"
+#include "FrameArena.h"
+#include "FrameContext.h"
+#include "LayoutCache.h"
+#include "TripleBuffer.h"
+#include "WorkerPool.h"
+#include <windows.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class DisplayWindow;
+class SessionRecorder;
+
+// 三缓冲中的一帧；槽位 i 的像素即 WindowCapture 第 i 组 DIB，交接时不拷贝
+struct CapturedFrame {
+    cv::Mat image;
+    cv::Rect rect;     // image 在客户区中的位置（ROI 捕获时为棋盘区域）
+    uint64_t seq = 0;  // 帧序号，分析任务据此跳过同一帧
+    std::chrono::steady_clock::time_point capturedAt; // 捕获完成时刻，用于端到端延迟
+};
+
+// 单个游戏窗口的完整流水线：独立捕获线程 + 共享线程池上的分析任务 + 独立输入执行器。
+// 布局、投票、推测、统计等状态都属于对象本身；线程池保证同一目标的分析任务串行，
+// 因此分析状态不加锁。画面无变化时只按心跳提交任务，静止的棋盘几乎不占分析线程
+class BoardPipeline {
+public:
+    // analyzer / pool / layoutCache / clickLock 在所有目标间共享；
+    // clickLock 保证同一时刻只有一个目标在操作鼠标。
+    // boardIndex：同一窗口里有多块棋盘（网页多开、并排的练习盘）时绑定第几块（阅读顺序），
+    // 每块各建一条流水线，布局锁定后各自只捕获自己的棋盘区域
+    BoardPipeline(HWND hwnd, GameAnalyzer& analyzer, WorkerPool& pool, LayoutCache& layoutCache,
+                  DisplayWindow& display, SessionRecorder& recorder, std::mutex& clickLock, int boardIndex = 0);
+    ~BoardPipeline();
+
+    void Start();
+    void Stop();
+
+    HWND GetWindow() const { return m_hwnd; }
+    int BoardIndex() const { return m_boardIndex; }
+    // 最近一次完整识别时窗口里找到的棋盘数
+    int BoardsSeen() const { return m_boardsSeen.load(); }
+    WindowCapture& Capture() { return m_capture; }
+    // 显示目标：只有它更新辅助窗口内容/状态栏、吸附辅助窗口并写入会话录制
+    void SetFocused(bool on) { m_focused.store(on); }
+    bool IsFocused() const { return m_focused.load(); }
+
+private:
+    void CaptureLoop();
+    void AnalyzeLatest();
+    void LockLayout();
+    void UnlockLayout();
+    void PublishStatus(const GameState& state, const cv::Rect& roi);
+
+    const HWND m_hwnd;
+    const int m_boardIndex;
+    GameAnalyzer& m_analyzer;
+    WorkerPool& m_pool;
+    LayoutCache& m_layoutCache;
+    DisplayWindow& m_display;
+    SessionRecorder& m_recorder;
+
+    WindowCapture m_capture;
+    FrameChangeDetector m_detector;
+    TripleBuffer<CapturedFrame> m_buffer;
+    Win32InputSink m_input;
+    InputExecutor m_executor;
+
+    int m_poolId = 0;
+    std::thread m_captureThread;
+    std::atomic<bool> m_running{false};
+    std::atomic<bool> m_focused{false};
+    std::atomic<double> m_captureFps{0.0};
+    std::atomic<double> m_captureMs{0.0};    // 每帧捕获耗时（1 秒窗口平均）
+    std::atomic<double> m_analyzeMs{0.0};
+    std::atomic<DWORD> m_lastClickTick{0};
+    std::atomic<int> m_boardsSeen{0};
+    uint64_t m_captureSeq = 0;     // 仅捕获线程访问；跨 Stop/Start 延续，避免与已分析帧号重复
+
+    // 以下仅由分析任务访问
+    FrameArena m_arena;            // 每个分析周期为一帧，周期结束时回绕
+    FrameContext m_ctx;
+    std::string m_layoutKey;       // 布局缓存键：窗口类名 + 标题（第 N>0 块棋盘加 #N）
+    std::vector<BoardCandidate> m_boards; // 金字塔定位的候选，跨帧复用
+    BoardLayout m_layout;          // 当前布局（可能尚未通过校验）
+    bool m_layoutLocked = false;   // 已通过识别或校验，可用于识别与 ROI 捕获
+    int m_verifyFailures = 0;
+    DWORD m_lastRelayoutTick = 0;
+    GameState m_state;
+    GameState m_prevState;         // 上一帧识别结果用于投票
+    SpeculativeState m_speculation;
+    bool m_haveFrame = false;
+    uint64_t m_lastSeq = 0;
+    uint64_t m_cycleMatAllocs = 0; // 上一分析周期的 Mat 分配次数（仅调试构建统计）
+};
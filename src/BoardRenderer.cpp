@@ -0,0 +1,200 @@
+#include "BoardRenderer.h"
+#include "FrameArena.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+static const cv::Scalar kCanvasBg(255, 255, 255, 255);
+static const cv::Scalar kGridLine(200, 200, 200, 255);
+static const cv::Scalar kSafeHighlight(0, 200, 0, 255);
+static const cv::Scalar kMineHighlight(0, 0, 200, 255);
+static const int kMinGlyphCell = 6; // 格子小于此尺寸不画数字
+
+static const uint16_t kKeyValueMask = 0x0F;
+static const uint16_t kKeySafe = 0x10;
+static const uint16_t kKeyMine = 0x20;
+
+// 画布与缓存的图块跨帧保留，而 Update 常在分析线程的 FrameArena::Scope 内调用：固定用堆分配器
+static cv::Mat persistentMat(int rows, int cols, int type, const cv::Scalar& fill) {
+    cv::Mat m;
+    m.allocator = FrameArena::HeapAllocator();
+    m.create(rows, cols, type);
+    m.setTo(fill);
+    return m;
+}
+
+// 数字颜色（BGR）
+static cv::Scalar digitColor(int n) {
+    switch (n) {
+    case 1: return cv::Scalar(255, 0, 0, 255);
+    case 2: return cv::Scalar(0, 128, 0, 255);
+    case 3: return cv::Scalar(0, 0, 255, 255);
+    case 4: return cv::Scalar(128, 0, 0, 255);
+    case 5: return cv::Scalar(0, 0, 128, 255);
+    case 6: return cv::Scalar(128, 128, 0, 255);
+    case 8: return cv::Scalar(128, 128, 128, 255);
+    default: return cv::Scalar(0, 0, 0, 255);
+    }
+}
+
+// 背景色（BGR）：未知淡灰，待定淡绿，旗子淡黄，雷淡红
+static cv::Scalar cellBackground(int v) {
+    if (v == 9) return cv::Scalar(245, 245, 245, 255);
+    if (v == 11) return cv::Scalar(225, 245, 225, 255);
+    if (v == 10) return cv::Scalar(205, 250, 255, 255);
+    if (v == -1) return cv::Scalar(225, 228, 255, 255);
+    return kCanvasBg;
+}
+
+uint16_t BoardRenderer::CellKey(int value, bool safe, bool mine) {
+    if (value < -1 || value > 11) value = 9;
+    uint16_t key = uint16_t(value + 1);
+    if (safe) key |= kKeySafe;
+    if (mine) key |= kKeyMine;
+    return key;
+}
+
+bool BoardRenderer::SetViewport(const cv::Size& size) {
+    if (size == m_viewport) return false;
+    m_viewport = size;
+    m_valid = false;
+    return true;
+}
+
+bool BoardRenderer::Relayout(int rows, int cols) {
+    int cell = 0;
+    cv::Size size = m_viewport;
+    if (rows > 0 && cols > 0) {
+        if (size.width <= 0 || size.height <= 0) {
+            cell = kMaxCell;
+            size = cv::Size(cols * cell + 1, rows * cell + 1);
+        } else {
+            // 右/下边线多占 1 像素
+            int fit = std::min((size.width - 1) / cols, (size.height - 1) / rows);
+            cell = std::max(0, std::min(fit, kMaxCell));
+        }
+    }
+    size.width = std::max(0, size.width);
+    size.height = std::max(0, size.height);
+    cv::Point origin(0, 0);
+    if (cell > 0) origin = cv::Point((size.width - cols * cell - 1) / 2, (size.height - rows * cell - 1) / 2);
+
+    bool changed = rows != m_rows || cols != m_cols || cell != m_cell || origin != m_origin ||
+                   size != m_canvas.size();
+    if (!changed) return false;
+    if (cell != m_cell) {
+        for (auto& g : m_glyphs) g.release();
+        m_tiles.clear();
+    }
+    m_rows = rows; m_cols = cols;
+    m_cell = cell;
+    m_origin = origin;
+    if (size != m_canvas.size()) {
+        m_canvas.allocator = FrameArena::HeapAllocator();
+        m_canvas.create(size, CV_8UC4);
+    }
+    m_drawn.assign(size_t(rows) * size_t(cols), 0);
+    return true;
+}
+
+const cv::Mat& BoardRenderer::Glyph(int digit) {
+    cv::Mat& g = m_glyphs[digit];
+    if (!g.empty()) return g;
+    g = persistentMat(m_cell, m_cell, CV_8UC1, cv::Scalar(0));
+    const std::string text = std::to_string(digit);
+    const int font = cv::FONT_HERSHEY_SIMPLEX;
+    const int thickness = std::max(1, m_cell / 12);
+    int baseline = 0;
+    cv::Size unit = cv::getTextSize(text, font, 1.0, thickness, &baseline);
+    double scale = 0.55 * m_cell / std::max(1, unit.height);
+    cv::Size ts = cv::getTextSize(text, font, scale, thickness, &baseline);
+    cv::Point org((m_cell - ts.width) / 2, (m_cell + ts.height) / 2);
+    cv::putText(g, text, org, font, scale, cv::Scalar(255), thickness, cv::LINE_AA);
+    return g;
+}
+
+const cv::Mat& BoardRenderer::Tile(uint16_t key) {
+    auto it = m_tiles.find(key);
+    if (it != m_tiles.end()) return it->second;
+    const int v = int(key & kKeyValueMask) - 1;
+    const cv::Scalar bg = cellBackground(v);
+    cv::Mat tile = persistentMat(m_cell, m_cell, CV_8UC4, bg);
+    if (v >= 1 && v <= 8 && m_cell >= kMinGlyphCell) {
+        // 按覆盖度在背景与数字色之间混合
+        const cv::Mat& glyph = Glyph(v);
+        const cv::Scalar fg = digitColor(v);
+        for (int y = 0; y < m_cell; ++y) {
+            const uint8_t* a = glyph.ptr<uint8_t>(y);
+            uint8_t* p = tile.ptr<uint8_t>(y);
+            for (int x = 0; x < m_cell; ++x) {
+                if (!a[x]) continue;
+                for (int k = 0; k < 3; ++k)
+                    p[x * 4 + k] = cv::saturate_cast<uint8_t>((bg[k] * (255 - a[x]) + fg[k] * a[x]) / 255.0);
+            }
+        }
+    }
+    // 上/左边线属于本格，右/下边线由相邻格或整盘重绘补齐
+    tile.row(0).setTo(kGridLine);
+    tile.col(0).setTo(kGridLine);
+    // 高亮建议：2 像素边框，必雷覆盖安全
+    auto frame = [&](const cv::Scalar& col) {
+        cv::rectangle(tile, cv::Point(0, 0), cv::Point(m_cell - 1, m_cell - 1), col, 1);
+        if (m_cell > 3) cv::rectangle(tile, cv::Point(1, 1), cv::Point(m_cell - 2, m_cell - 2), col, 1);
+    };
+    if (key & kKeySafe) frame(kSafeHighlight);
+    if (key & kKeyMine) frame(kMineHighlight);
+    return m_tiles.emplace(key, tile).first->second;
+}
+
+cv::Rect BoardRenderer::Update(const GameState& state) {
+    m_stats.updates++;
+    const int rows = std::max(0, state.rows);
+    const int cols = std::max(0, state.cols);
+    const bool full = Relayout(rows, cols) || !m_valid;
+    m_valid = true;
+    const cv::Rect whole(0, 0, m_canvas.cols, m_canvas.rows);
+    if (full) {
+        m_stats.fullRedraws++;
+        if (!m_canvas.empty()) m_canvas.setTo(kCanvasBg);
+    }
+    if (m_cell <= 0) return full ? whole : cv::Rect();
+
+    // 建议高亮按格展开，bit0 安全、bit1 必雷
+    m_hint.assign(size_t(rows) * size_t(cols), 0);
+    for (const auto& p : state.safeCells)
+        if (p.x >= 0 && p.x < cols && p.y >= 0 && p.y < rows) m_hint[size_t(p.y) * cols + p.x] |= 1;
+    for (const auto& p : state.mineCells)
+        if (p.x >= 0 && p.x < cols && p.y >= 0 && p.y < rows) m_hint[size_t(p.y) * cols + p.x] |= 2;
+
+    cv::Rect dirty;
+    for (int r = 0; r < rows; ++r) {
+        const bool haveRow = r < int(state.grid.size());
+        for (int c = 0; c < cols; ++c) {
+            int v = 9;
+            if (haveRow && c < int(state.grid[r].size())) v = state.grid[r][c];
+            const size_t i = size_t(r) * cols + c;
+            const uint16_t key = CellKey(v, (m_hint[i] & 1) != 0, (m_hint[i] & 2) != 0);
+            if (!full && m_drawn[i] == key) continue;
+            const cv::Rect cellRc(m_origin.x + c * m_cell, m_origin.y + r * m_cell, m_cell, m_cell);
+            Tile(key).copyTo(m_canvas(cellRc));
+            m_drawn[i] = key;
+            dirty |= cellRc;
+            m_stats.cellsRedrawn++;
+        }
+    }
+    if (full) {
+        // 右/下收口边线
+        const int x1 = m_origin.x + cols * m_cell, y1 = m_origin.y + rows * m_cell;
+        cv::line(m_canvas, cv::Point(m_origin.x, y1), cv::Point(x1, y1), kGridLine);
+        cv::line(m_canvas, cv::Point(x1, m_origin.y), cv::Point(x1, y1), kGridLine);
+        return whole;
+    }
+    return dirty;
+}
+
+bool BoardRenderer::SavePng(const std::string& path) const {
+    if (m_canvas.empty()) return false;
+    cv::Mat bgr;
+    cv::cvtColor(m_canvas, bgr, cv::COLOR_BGRA2BGR);
+    return cv::imwrite(path, bgr);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "GameState.h"
+#include <opencv2/core.hpp>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 棋盘离屏渲染：画布为持久的 BGRA cv::Mat（可直接作为 32 位 DIB 上屏），
+// 每种“格值 + 高亮”组合的格子图块按当前格子尺寸光栅化一次后缓存，
+// Update 只重绘与上次不同的格子。不依赖 Win32，无界面下可导出 PNG
+class BoardRenderer {
+public:
+    static const int kMaxCell = 24; // 最大单元像素，避免 9x9 时过大
+
+    struct Stats {
+        uint64_t updates = 0;      // Update 调用次数
+        uint64_t fullRedraws = 0;  // 因视口/行列变化的整盘重绘
+        uint64_t cellsRedrawn = 0; // 实际重绘的格子数（含整盘重绘）
+    };
+
+    // 视口：画布尺寸，棋盘在其中居中；空尺寸表示按 kMaxCell 贴合棋盘。
+    // 返回是否变化（变化后下一次 Update 整盘重绘）
+    bool SetViewport(const cv::Size& size);
+    // 渲染 state；返回本次重绘区域的外接矩形（画布坐标），无变化时为空矩形
+    cv::Rect Update(const GameState& state);
+
+    const cv::Mat& Canvas() const { return m_canvas; }
+    bool SavePng(const std::string& path) const;
+    Stats GetStats() const { return m_stats; }
+
+private:
+    // 格子状态键：格值 + 建议高亮
+    static uint16_t CellKey(int value, bool safe, bool mine);
+    const cv::Mat& Tile(uint16_t key);
+    const cv::Mat& Glyph(int digit);
+    bool Relayout(int rows, int cols);
+
+    cv::Size m_viewport;
+    cv::Mat m_canvas;          // CV_8UC4
+    int m_rows = 0, m_cols = 0;
+    int m_cell = 0;
+    cv::Point m_origin;        // 棋盘左上角（画布坐标）
+    std::vector<uint16_t> m_drawn; // 画布上每格当前的状态键
+    bool m_valid = false;      // m_drawn 与画布一致
+    std::vector<uint8_t> m_hint;   // 每帧复用：0 无高亮，1 安全，2 必雷
+
+    // 以下随格子尺寸失效
+    std::array<cv::Mat, 9> m_glyphs;           // 数字 1–8 的灰度覆盖度（CV_8UC1）
+    std::unordered_map<uint16_t, cv::Mat> m_tiles; // 完整格子图块（CV_8UC4）
+    Stats m_stats;
+};
@@ -0,0 +1,497 @@
+#include "BoardSynthesizer.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static const size_t kMaxCachedTiles = 1024; // 格子尺寸频繁变化时整体丢弃
+
+// 七段数码管各数字点亮的段（bit0–6 依次为 a–g），10 为负号
+static const uint8_t kSegments[11] = { 0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F, 0x40 };
+
+struct ClassicPalette {
+    cv::Scalar face, light, shadow, line;
+    double bevel;    // 未打开格立体边宽（相对格子尺寸）
+};
+// WinXP 扫雷与 minesweeper.online 一类网页复刻：同为灰色立体风格，比例与灰度略有不同
+static const ClassicPalette kXpPalette = { {192, 192, 192}, {255, 255, 255}, {128, 128, 128}, {128, 128, 128}, 2.0 / 16 };
+static const ClassicPalette kWebClassicPalette = { {198, 198, 198}, {255, 255, 255}, {128, 128, 128}, {128, 128, 128}, 3.0 / 24 };
+
+// 数字颜色（BGR）
+static cv::Scalar classicDigit(int n) {
+    static const cv::Scalar c[9] = { {0, 0, 0}, {255, 0, 0}, {0, 128, 0}, {0, 0, 255}, {128, 0, 0},
+                                     {0, 0, 128}, {128, 128, 0}, {0, 0, 0}, {128, 128, 128} };
+    return c[std::min(std::max(n, 0), 8)];
+}
+static cv::Scalar win7Digit(int n) {
+    static const cv::Scalar c[9] = { {0, 0, 0}, {192, 80, 62}, {30, 120, 30}, {40, 40, 190}, {130, 30, 20},
+                                     {30, 30, 120}, {130, 120, 30}, {20, 20, 20}, {110, 110, 110} };
+    return c[std::min(std::max(n, 0), 8)];
+}
+static cv::Scalar webDigit(int n) {
+    static const cv::Scalar c[9] = { {0, 0, 0}, {210, 118, 25}, {60, 142, 56}, {47, 47, 211}, {162, 31, 123},
+                                     {0, 143, 255}, {167, 151, 0}, {66, 66, 66}, {158, 158, 158} };
+    return c[std::min(std::max(n, 0), 8)];
+}
+
+static int px(double v) { return std::max(1, int(std::lround(v))); }
+
+static void bevel(cv::Mat& m, const cv::Rect& r, int w, const cv::Scalar& topLeft, const cv::Scalar& bottomRight) {
+    for (int i = 0; i < w; ++i) {
+        const int x0 = r.x + i, y0 = r.y + i, x1 = r.x + r.width - 1 - i, y1 = r.y + r.height - 1 - i;
+        if (x1 <= x0 || y1 <= y0) break;
+        cv::line(m, cv::Point(x0, y0), cv::Point(x1 - 1, y0), topLeft);
+        cv::line(m, cv::Point(x0, y0), cv::Point(x0, y1 - 1), topLeft);
+        cv::line(m, cv::Point(x0 + 1, y1), cv::Point(x1, y1), bottomRight);
+        cv::line(m, cv::Point(x1, y0 + 1), cv::Point(x1, y1), bottomRight);
+    }
+}
+
+static void verticalGradient(cv::Mat& m, const cv::Rect& r, const cv::Scalar& top, const cv::Scalar& bottom) {
+    for (int y = 0; y < r.height; ++y) {
+        const double t = r.height > 1 ? double(y) / (r.height - 1) : 0.0;
+        cv::Mat row = m(cv::Rect(r.x, r.y + y, r.width, 1));
+        row.setTo(top * (1.0 - t) + bottom * t);
+    }
+}
+
+// 居中画数字；aa=false 时为像素字体般的硬边
+static void drawDigit(cv::Mat& tile, const cv::Rect& r, int digit, const cv::Scalar& color, bool aa, double weight) {
+    const std::string text = std::to_string(digit);
+    const int font = cv::FONT_HERSHEY_SIMPLEX;
+    const int thickness = std::max(1, int(std::lround(r.height * weight)));
+    int baseline = 0;
+    const cv::Size unit = cv::getTextSize(text, font, 1.0, thickness, &baseline);
+    const double scale = 0.6 * r.height / std::max(1, unit.height);
+    const cv::Size ts = cv::getTextSize(text, font, scale, thickness, &baseline);
+    const cv::Point org(r.x + (r.width - ts.width) / 2, r.y + (r.height + ts.height) / 2);
+    cv::putText(tile, text, org, font, scale, color, thickness, aa ? cv::LINE_AA : cv::LINE_8);
+}
+
+static void drawFlag(cv::Mat& tile, const cv::Rect& r, const cv::Scalar& cloth, const cv::Scalar& pole, bool aa) {
+    const int lt = aa ? cv::LINE_AA : cv::LINE_8;
+    const int cx = r.x + r.width / 2, top = r.y + r.height * 3 / 16;
+    const int bottom = r.y + r.height * 13 / 16;
+    const int poleW = std::max(1, r.width / 12);
+    cv::rectangle(tile, cv::Rect(cx, top, poleW, bottom - top), pole, cv::FILLED);
+    cv::rectangle(tile, cv::Rect(cx - r.width / 4, bottom - std::max(1, r.height / 10), r.width / 2 + poleW,
+                                 std::max(1, r.height / 10)), pole, cv::FILLED);
+    const cv::Point tri[3] = { {cx + poleW, top}, {cx + poleW, top + r.height * 5 / 16},
+                               {cx - r.width * 5 / 16, top + r.height * 5 / 32} };
+    cv::fillConvexPoly(tile, tri, 3, cloth, lt);
+}
+
+static void drawMine(cv::Mat& tile, const cv::Rect& r, const cv::Scalar& body, bool aa) {
+    const int lt = aa ? cv::LINE_AA : cv::LINE_8;
+    const cv::Point c(r.x + r.width / 2, r.y + r.height / 2);
+    const int rad = std::max(1, r.width * 5 / 16);
+    const int spike = std::max(1, r.width * 7 / 16);
+    const int t = std::max(1, r.width / 16);
+    cv::line(tile, c - cv::Point(spike, 0), c + cv::Point(spike, 0), body, t, lt);
+    cv::line(tile, c - cv::Point(0, spike), c + cv::Point(0, spike), body, t, lt);
+    const int d = spike * 7 / 10;
+    cv::line(tile, c - cv::Point(d, d), c + cv::Point(d, d), body, t, lt);
+    cv::line(tile, c - cv::Point(d, -d), c + cv::Point(d, -d), body, t, lt);
+    cv::circle(tile, c, rad, body, cv::FILLED, lt);
+    cv::circle(tile, c - cv::Point(rad / 3, rad / 3), std::max(1, rad / 3), cv::Scalar(255, 255, 255), cv::FILLED, lt);
+}
+
+static void paintClassic(cv::Mat& tile, const ClassicPalette& pal, int v, int variant) {
+    const int n = tile.rows;
+    const cv::Rect full(0, 0, n, n);
+    const bool opened = v != 9 && v != 10;
+    tile.setTo(opened && variant == 1 ? cv::Scalar(0, 0, 255) : pal.face);
+    if (!opened) {
+        bevel(tile, full, std::max(1, int(std::lround(n * pal.bevel))), pal.light, pal.shadow);
+        if (v == 10) drawFlag(tile, full, cv::Scalar(0, 0, 255), cv::Scalar(0, 0, 0), false);
+        return;
+    }
+    // 打开的格子只有左、上两条格线
+    cv::line(tile, cv::Point(0, 0), cv::Point(n - 1, 0), pal.line);
+    cv::line(tile, cv::Point(0, 0), cv::Point(0, n - 1), pal.line);
+    const cv::Rect inner(1, 1, n - 1, n - 1);
+    if (v >= 1 && v <= 8) drawDigit(tile, inner, v, classicDigit(v), false, 0.14);
+    else if (v == -1) drawMine(tile, inner, cv::Scalar(0, 0, 0), false);
+}
+
+static void paintWin7(cv::Mat& tile, int v, int variant) {
+    const int n = tile.rows;
+    const int gap = std::max(1, n / 20);
+    const cv::Rect face(0, 0, n - gap, n - gap);
+    tile.setTo(cv::Scalar(90, 50, 20)); // 格间缝隙透出的深蓝底
+    if (v == 9 || v == 10) {
+        verticalGradient(tile, face, cv::Scalar(250, 205, 130), cv::Scalar(205, 130, 50));
+        cv::rectangle(tile, face, cv::Scalar(255, 225, 170));
+        if (v == 10) drawFlag(tile, face, cv::Scalar(40, 40, 220), cv::Scalar(60, 40, 30), true);
+        return;
+    }
+    tile(face).setTo(variant == 1 ? cv::Scalar(90, 90, 230) : cv::Scalar(240, 226, 214));
+    cv::rectangle(tile, face, cv::Scalar(220, 200, 185));
+    if (v >= 1 && v <= 8) drawDigit(tile, face, v, win7Digit(v), true, 0.12);
+    else if (v == -1) drawMine(tile, face, cv::Scalar(40, 30, 30), true);
+}
+
+static void paintWeb(cv::Mat& tile, int v, int variant) {
+    const int n = tile.rows;
+    const cv::Rect full(0, 0, n, n);
+    const bool odd = (variant & 1) != 0;
+    if (v == 9 || v == 10) {
+        tile.setTo(odd ? cv::Scalar(73, 209, 162) : cv::Scalar(81, 215, 170));
+        if (v == 10) drawFlag(tile, full, cv::Scalar(54, 67, 242), cv::Scalar(30, 30, 30), true);
+        return;
+    }
+    if (v == -1) {
+        // 踩雷后各雷格底色各异，雷点为同色系深色
+        static const cv::Scalar kMineBg[4] = { {53, 57, 219}, {69, 194, 244}, {200, 160, 72}, {160, 90, 180} };
+        const cv::Scalar bg = kMineBg[variant & 3];
+        tile.setTo(bg);
+        cv::circle(tile, cv::Point(n / 2, n / 2), std::max(1, n * 5 / 16), bg * 0.55, cv::FILLED, cv::LINE_AA);
+        return;
+    }
+    tile.setTo(odd ? cv::Scalar(153, 184, 215) : cv::Scalar(159, 194, 229));
+    if (v >= 1 && v <= 8) drawDigit(tile, full, v, webDigit(v), true, 0.13);
+}
+
+const cv::Mat& BoardSynthesizer::Tile(Skin skin, int cell, int value, int variant) {
+    const uint64_t key = (uint64_t(skin) << 40) | (uint64_t(uint32_t(cell)) << 16) |
+                         (uint64_t(value + 1) << 4) | uint64_t(variant & 0xF);
+    auto it = m_tiles.find(key);
+    if (it != m_tiles.end()) return it->second;
+    if (m_tiles.size() >= kMaxCachedTiles) m_tiles.clear();
+    cv::Mat tile(cell, cell, CV_8UC3);
+    switch (skin) {
+    case Skin::ClassicXp: paintClassic(tile, kXpPalette, value, variant); break;
+    case Skin::WebClassic: paintClassic(tile, kWebClassicPalette, value, variant); break;
+    case Skin::Win7: paintWin7(tile, value, variant); break;
+    case Skin::WebFlat: paintWeb(tile, value, variant); break;
+    }
+    return m_tiles.emplace(key, std::move(tile)).first->second;
+}
+
+void BoardSynthesizer::RandomBoard(const Options& opt, GameState& truth) {
+    const int rows = std::max(1, opt.rows), cols = std::max(1, opt.cols);
+    const int cells = rows * cols;
+    const int mines = std::min(std::max(0, opt.mines), cells - 1);
+    truth.rows = rows;
+    truth.cols = cols;
+    truth.mineCount = mines;
+    truth.safeCells.clear();
+    truth.mineCells.clear();
+
+    // 部分洗牌布雷
+    m_order.resize(cells);
+    for (int i = 0; i < cells; ++i) m_order[i] = i;
+    m_mine.assign(cells, 0);
+    for (int i = 0; i < mines; ++i) {
+        const int j = i + int(m_rng() % uint64_t(cells - i));
+        std::swap(m_order[i], m_order[j]);
+        m_mine[m_order[i]] = 1;
+    }
+    auto count = [&](int r, int c) {
+        int n = 0;
+        for (int dr = -1; dr <= 1; ++dr)
+            for (int dc = -1; dc <= 1; ++dc) {
+                const int rr = r + dr, cc = c + dc;
+                if ((dr || dc) && rr >= 0 && rr < rows && cc >= 0 && cc < cols) n += m_mine[rr * cols + cc];
+            }
+        return n;
+    };
+
+    // 从随机非雷格连通展开（0 格向八邻域扩散），直到打开的非雷格达到目标比例
+    m_open.assign(cells, 0);
+    const int target = int(std::lround(std::min(1.0, std::max(0.0, opt.revealed)) * (cells - mines)));
+    int opened = 0;
+    for (int attempt = 0; opened < target && attempt < 4 * cells; ++attempt) {
+        const int start = int(m_rng() % uint64_t(cells));
+        if (m_mine[start] || m_open[start]) continue;
+        m_stack.assign(1, start);
+        m_open[start] = 1;
+        while (!m_stack.empty()) {
+            const int i = m_stack.back();
+            m_stack.pop_back();
+            opened++;
+            const int r = i / cols, c = i % cols;
+            if (count(r, c) != 0) continue;
+            for (int dr = -1; dr <= 1; ++dr)
+                for (int dc = -1; dc <= 1; ++dc) {
+                    const int rr = r + dr, cc = c + dc;
+                    if (rr < 0 || rr >= rows || cc < 0 || cc >= cols) continue;
+                    const int j = rr * cols + cc;
+                    if (!m_open[j] && !m_mine[j]) { m_open[j] = 1; m_stack.push_back(j); }
+                }
+        }
+    }
+
+    std::bernoulli_distribution flag(std::min(1.0, std::max(0.0, opt.flagged)));
+    truth.grid.resize(rows);
+    for (int r = 0; r < rows; ++r) {
+        truth.grid[r].resize(cols);
+        for (int c = 0; c < cols; ++c) {
+            const int i = r * cols + c;
+            int v;
+            if (m_open[i]) v = count(r, c);
+            else if (m_mine[i]) v = flag(m_rng) ? 10 : (opt.lost ? -1 : 9);
+            else v = 9;
+            truth.grid[r][c] = v;
+        }
+    }
+    int known = 0;
+    for (int i = 0; i < cells; ++i) known += m_open[i];
+    truth.exploredPercent = 100.f * known / float(cells);
+    truth.remainingMines = mines;
+}
+
+// 七段数码管计数器（三位，负数首位为负号）
+static void drawCounter(cv::Mat& m, const cv::Rect& box, int value) {
+    // 很窄的棋盘上 HUD 放不下时只画可见部分
+    const cv::Rect visible = box & cv::Rect(0, 0, m.cols, m.rows);
+    if (visible.area() <= 0) return;
+    m(visible).setTo(cv::Scalar(0, 0, 0));
+    value = std::min(999, std::max(-99, value));
+    int digits[3];
+    const int a = std::abs(value);
+    digits[0] = value < 0 ? 10 : a / 100;
+    digits[1] = (a / 10) % 10;
+    digits[2] = a % 10;
+    const int pad = std::max(1, box.height / 12);
+    const int w = (box.width - 2 * pad) / 3, h = box.height - 2 * pad;
+    const int t = std::max(1, w / 5);
+    for (int k = 0; k < 3; ++k) {
+        const int x = box.x + pad + k * w + 1, y = box.y + pad;
+        const int dw = w - 2, half = h / 2;
+        const cv::Rect seg[7] = {
+            { x + t, y, dw - 2 * t, t }, { x + dw - t, y + t, t, half - t }, { x + dw - t, y + half, t, half - t },
+            { x + t, y + h - t, dw - 2 * t, t }, { x, y + half, t, half - t }, { x, y + t, t, half - t },
+            { x + t, y + half - t / 2, dw - 2 * t, t },
+        };
+        for (int s = 0; s < 7; ++s) {
+            const bool lit = (kSegments[digits[k]] >> s) & 1;
+            cv::rectangle(m, seg[s], lit ? cv::Scalar(0, 0, 255) : cv::Scalar(0, 0, 96), cv::FILLED);
+        }
+    }
+}
+
+static void drawSmiley(cv::Mat& m, const cv::Rect& r, bool dead, const ClassicPalette& pal) {
+    const cv::Rect visible = r & cv::Rect(0, 0, m.cols, m.rows);
+    if (visible.area() <= 0) return;
+    m(visible).setTo(pal.face);
+    bevel(m, r, std::max(1, r.width / 12), pal.light, pal.shadow);
+    const cv::Point c(r.x + r.width / 2, r.y + r.height / 2);
+    const int rad = r.width * 6 / 16;
+    cv::circle(m, c, rad, cv::Scalar(0, 255, 255), cv::FILLED);
+    cv::circle(m, c, rad, cv::Scalar(0, 0, 0), 1);
+    const int ex = rad / 3, ey = rad / 4, e = std::max(1, rad / 6);
+    for (int s : { -1, 1 }) {
+        const cv::Point eye = c + cv::Point(s * ex, -ey);
+        if (dead) {
+            cv::line(m, eye - cv::Point(e, e), eye + cv::Point(e, e), cv::Scalar(0, 0, 0));
+            cv::line(m, eye - cv::Point(e, -e), eye + cv::Point(e, -e), cv::Scalar(0, 0, 0));
+        } else {
+            cv::circle(m, eye, std::max(1, e / 2 + 1), cv::Scalar(0, 0, 0), cv::FILLED);
+        }
+    }
+    const int mw = rad / 2;
+    cv::ellipse(m, c + cv::Point(0, dead ? rad / 2 : rad / 6), cv::Size(mw, mw / 2), 0,
+                dead ? 180 : 0, dead ? 360 : 180, cv::Scalar(0, 0, 0));
+}
+
+// 状态条上的图标 + 数字（Win7 底部、网页版顶部）
+static void drawBarItem(cv::Mat& m, cv::Point at, int h, int value, bool clock, const cv::Scalar& text) {
+    const int rad = std::max(2, h * 3 / 10);
+    const cv::Point c(at.x + rad, at.y + h / 2);
+    if (clock) {
+        cv::circle(m, c, rad, cv::Scalar(40, 200, 250), cv::FILLED, cv::LINE_AA);
+        cv::line(m, c, c - cv::Point(0, rad * 2 / 3), cv::Scalar(40, 40, 40), std::max(1, rad / 5), cv::LINE_AA);
+        cv::line(m, c, c + cv::Point(rad / 2, 0), cv::Scalar(40, 40, 40), std::max(1, rad / 5), cv::LINE_AA);
+    } else {
+        drawFlag(m, cv::Rect(at.x, at.y + h / 2 - rad, rad * 2, rad * 2), cv::Scalar(54, 67, 242),
+                 cv::Scalar(20, 20, 20), true);
+    }
+    const double scale = h / 60.0;
+    cv::putText(m, std::to_string(value), cv::Point(at.x + rad * 2 + h / 6, at.y + h * 7 / 10),
+                cv::FONT_HERSHEY_SIMPLEX, std::max(0.3, scale * 1.1), text, std::max(1, h / 20), cv::LINE_AA);
+}
+
+cv::Rect BoardSynthesizer::RenderClient(const GameState& truth, const Options& opt, int cell,
+                                        int minesLeft, int seconds) {
+    const int rows = truth.rows, cols = truth.cols;
+    const int gridW = cols * cell, gridH = rows * cell;
+    const double u = cell / 16.0; // 以 16 px 格子时的像素为单位
+    const bool classic = opt.skin == Skin::ClassicXp || opt.skin == Skin::WebClassic;
+    cv::Rect grid;
+    if (classic) {
+        const ClassicPalette& pal = opt.skin == Skin::ClassicXp ? kXpPalette : kWebClassicPalette;
+        const int border = px(3 * u), pad = px(6 * u), frame = px(3 * u), hudH = px(37 * u);
+        const cv::Size size(gridW + 2 * frame + 2 * pad + 2 * border, hudH + gridH + 2 * frame + 3 * pad + 2 * border);
+        m_client.create(size, CV_8UC3);
+        m_client.setTo(pal.face);
+        bevel(m_client, cv::Rect(0, 0, size.width, size.height), border, pal.light, pal.shadow);
+        const cv::Rect hud(border + pad, border + pad, gridW + 2 * frame, hudH);
+        bevel(m_client, hud, px(2 * u), pal.shadow, pal.light);
+        const cv::Size counter(px(41 * u), px(25 * u));
+        const int cy = hud.y + (hud.height - counter.height) / 2;
+        drawCounter(m_client, cv::Rect(cv::Point(hud.x + px(6 * u), cy), counter), minesLeft);
+        drawCounter(m_client, cv::Rect(cv::Point(hud.x + hud.width - px(6 * u) - counter.width, cy), counter), seconds);
+        const int face = px(26 * u);
+        drawSmiley(m_client, cv::Rect(hud.x + (hud.width - face) / 2, hud.y + (hud.height - face) / 2, face, face),
+                   opt.lost, pal);
+        const cv::Rect board(border + pad, hud.y + hud.height + pad, gridW + 2 * frame, gridH + 2 * frame);
+        bevel(m_client, board, frame, pal.shadow, pal.light);
+        grid = cv::Rect(board.x + frame, board.y + frame, gridW, gridH);
+    } else if (opt.skin == Skin::Win7) {
+        const int margin = px(20 * u), barH = px(40 * u);
+        const cv::Size size(gridW + 2 * margin, gridH + 2 * margin + barH);
+        m_client.create(size, CV_8UC3);
+        verticalGradient(m_client, cv::Rect(0, 0, size.width, size.height), cv::Scalar(170, 115, 60), cv::Scalar(110, 60, 25));
+        grid = cv::Rect(margin, margin, gridW, gridH);
+        cv::rectangle(m_client, grid + cv::Size(2, 2) - cv::Point(1, 1), cv::Scalar(90, 50, 20));
+        const int barY = grid.y + grid.height + margin / 2;
+        drawBarItem(m_client, cv::Point(grid.x + gridW / 4 - barH, barY), barH, seconds, true, cv::Scalar(255, 255, 255));
+        drawBarItem(m_client, cv::Point(grid.x + gridW * 3 / 4 - barH, barY), barH, minesLeft, false, cv::Scalar(255, 255, 255));
+    } else {
+        // 网页扁平版：顶部深绿状态条，棋盘无边框无格线
+        const int barH = std::max(12, cell * 2);
+        const cv::Size size(gridW, gridH + barH);
+        m_client.create(size, CV_8UC3);
+        m_client(cv::Rect(0, 0, gridW, barH)).setTo(cv::Scalar(48, 138, 74));
+        drawBarItem(m_client, cv::Point(gridW / 2 - barH * 2, 0), barH, minesLeft, false, cv::Scalar(255, 255, 255));
+        drawBarItem(m_client, cv::Point(gridW / 2 + barH / 2, 0), barH, seconds, true, cv::Scalar(255, 255, 255));
+        grid = cv::Rect(0, barH, gridW, gridH);
+    }
+
+    // 踩雷画面：随机一颗可见的雷标为引爆
+    int exploded = -1;
+    if (opt.lost) {
+        int visible = 0;
+        for (const auto& row : truth.grid) visible += int(std::count(row.begin(), row.end(), -1));
+        if (visible > 0) exploded = int(m_rng() % uint64_t(visible));
+    }
+    int mineIndex = 0;
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            const int v = truth.grid[r][c];
+            int variant = 0;
+            if (opt.skin == Skin::WebFlat) variant = v == -1 ? int((r * 7 + c * 3) & 3) : ((r + c) & 1);
+            else if (v == -1 && mineIndex == exploded) variant = 1;
+            if (v == -1) mineIndex++;
+            Tile(opt.skin, cell, v, variant).copyTo(m_client(cv::Rect(grid.x + c * cell, grid.y + r * cell, cell, cell)));
+        }
+    }
+    return grid;
+}
+
+cv::Point BoardSynthesizer::ComposeChrome(const cv::Mat& client, const Options& opt, cv::Mat& out) {
+    if (opt.chrome == Chrome::None) {
+        client.copyTo(out);
+        return cv::Point(0, 0);
+    }
+    // 非客户区总是按系统缩放绘制（即使客户区是拉伸得到的）
+    const double u = opt.dpiScale;
+    std::uniform_int_distribution<int> margin(px(8 * u), px(60 * u));
+    const int left = margin(m_rng), right = margin(m_rng), top = margin(m_rng), bottom = margin(m_rng);
+    const cv::Scalar white(255, 255, 255);
+    cv::Rect clientRect;
+    cv::Rect window;
+    if (opt.chrome == Chrome::Browser) {
+        // 浏览器：整宽的标签栏 + 地址栏，页面白底，游戏在页面中
+        const int tabs = px(34 * u), bar = px(38 * u);
+        const cv::Size size(client.cols + left + right, tabs + bar + top + client.rows + bottom);
+        out.create(size, CV_8UC3);
+        out.setTo(white);
+        out(cv::Rect(0, 0, size.width, tabs)).setTo(cv::Scalar(225, 222, 220));
+        out(cv::Rect(px(8 * u), px(6 * u), std::min(size.width - px(16 * u), px(220 * u)), tabs - px(6 * u))).setTo(white);
+        cv::putText(out, "Minesweeper", cv::Point(px(20 * u), tabs - px(10 * u)), cv::FONT_HERSHEY_SIMPLEX,
+                    0.45 * u, cv::Scalar(60, 60, 60), 1, cv::LINE_AA);
+        const cv::Rect address(px(80 * u), tabs + px(6 * u), std::max(1, size.width - px(100 * u)), bar - px(12 * u));
+        cv::rectangle(out, address, cv::Scalar(240, 240, 240), cv::FILLED);
+        cv::rectangle(out, address, cv::Scalar(200, 200, 200));
+        cv::line(out, cv::Point(0, tabs + bar - 1), cv::Point(size.width, tabs + bar - 1), cv::Scalar(210, 210, 210));
+        clientRect = cv::Rect(left, tabs + bar + top, client.cols, client.rows);
+        client.copyTo(out(clientRect));
+        return clientRect.tl();
+    }
+    const bool xp = opt.chrome == Chrome::Xp;
+    const int frame = px((xp ? 4 : 8) * u), title = px((xp ? 30 : 30) * u);
+    const cv::Size winSize(client.cols + 2 * frame, client.rows + title + frame);
+    const cv::Size size(winSize.width + left + right, winSize.height + top + bottom);
+    out.create(size, CV_8UC3);
+    // 桌面背景
+    if (xp) verticalGradient(out, cv::Rect(0, 0, size.width, size.height), cv::Scalar(200, 120, 60), cv::Scalar(40, 150, 60));
+    else verticalGradient(out, cv::Rect(0, 0, size.width, size.height), cv::Scalar(160, 90, 30), cv::Scalar(90, 40, 10));
+    window = cv::Rect(left, top, winSize.width, winSize.height);
+    if (xp) {
+        out(window).setTo(cv::Scalar(220, 80, 0));
+        verticalGradient(out, cv::Rect(window.x, window.y, window.width, title), cv::Scalar(240, 120, 20), cv::Scalar(200, 70, 0));
+    } else {
+        verticalGradient(out, window, cv::Scalar(240, 220, 195), cv::Scalar(225, 200, 170));
+        cv::rectangle(out, window, cv::Scalar(120, 90, 60));
+    }
+    cv::putText(out, "Minesweeper", cv::Point(window.x + px(28 * u), window.y + title * 2 / 3), cv::FONT_HERSHEY_SIMPLEX,
+                0.5 * u, xp ? white : cv::Scalar(20, 20, 20), 1, cv::LINE_AA);
+    // 标题栏按钮：关闭为红色
+    const int bw = px(xp ? 21 * u : 44 * u), bh = px(xp ? 21 * u : 19 * u);
+    for (int k = 0; k < 3; ++k) {
+        const cv::Rect b(window.x + window.width - frame - (k + 1) * (bw + px(2 * u)), window.y + (xp ? px(5 * u) : 1), bw, bh);
+        if (b.x <= window.x) break;
+        const cv::Scalar fill = k == 0 ? cv::Scalar(50, 60, 210) : (xp ? cv::Scalar(240, 130, 30) : cv::Scalar(235, 215, 190));
+        cv::rectangle(out, b, fill, cv::FILLED);
+        cv::rectangle(out, b, xp ? white : cv::Scalar(140, 110, 80));
+    }
+    clientRect = cv::Rect(window.x + frame, window.y + title, client.cols, client.rows);
+    client.copyTo(out(clientRect));
+    return clientRect.tl();
+}
+
+void BoardSynthesizer::Render(const GameState& truth, const Options& opt, Frame& out) {
+    if (&out.truth != &truth) out.truth = truth;
+    int flags = 0;
+    for (const auto& row : truth.grid) flags += int(std::count(row.begin(), row.end(), 10));
+    out.minesLeft = truth.mineCount - flags;
+    out.seconds = int(m_rng() % 1000);
+
+    const double dpi = std::max(0.5, opt.dpiScale);
+    const int cell = std::max(4, int(std::lround(opt.cellSize * (opt.bitmapStretch ? 1.0 : dpi))));
+    cv::Rect grid = RenderClient(truth, opt, cell, out.minesLeft, out.seconds);
+    const cv::Mat* client = &m_client;
+    out.cellPitch = cell;
+    if (opt.bitmapStretch && std::abs(dpi - 1.0) > 1e-6) {
+        cv::resize(m_client, m_stretched, cv::Size(int(std::lround(m_client.cols * dpi)), int(std::lround(m_client.rows * dpi))),
+                   0, 0, cv::INTER_LINEAR);
+        client = &m_stretched;
+        grid = cv::Rect(int(std::lround(grid.x * dpi)), int(std::lround(grid.y * dpi)),
+                        int(std::lround(grid.width * dpi)), int(std::lround(grid.height * dpi)));
+        out.cellPitch = cell * dpi;
+    }
+    const cv::Point origin = ComposeChrome(*client, opt, out.image);
+    out.client = cv::Rect(origin, client->size());
+    out.board = grid + origin;
+
+    if (opt.jpegQuality > 0) {
+        cv::imencode(".jpg", out.image, m_jpeg, { cv::IMWRITE_JPEG_QUALITY, std::min(100, opt.jpegQuality) });
+        out.image = cv::imdecode(m_jpeg, cv::IMREAD_COLOR);
+    }
+    if (opt.noiseSigma > 0.0) {
+        m_noise.create(out.image.size(), CV_16SC3);
+        cv::RNG rng(m_rng());
+        rng.fill(m_noise, cv::RNG::NORMAL, 0.0, opt.noiseSigma);
+        cv::add(out.image, m_noise, out.image, cv::noArray(), CV_8UC3);
+    }
+}
+
+const char* BoardSynthesizer::SkinName(Skin skin) {
+    switch (skin) {
+    case Skin::ClassicXp: return "xp";
+    case Skin::Win7: return "win7";
+    case Skin::WebFlat: return "web";
+    case Skin::WebClassic: return "webclassic";
+    }
+    return "?";
+}
+
+bool BoardSynthesizer::ParseSkin(const std::string& name, Skin& skin) {
+    for (int i = 0; i < kSkinCount; ++i) {
+        if (name == SkinName(Skin(i))) { skin = Skin(i); return true; }
+    }
+    return false;
+}
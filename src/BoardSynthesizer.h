@@ -0,0 +1,80 @@
+#pragma once
+#include "GameState.h"
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 合成棋盘截图：把逻辑棋盘按指定皮肤画成像素级截图并给出真值，
+// 无需真实游戏即可压测定位、布局与识别的吞吐和准确率（含 200×200 这类客户端不支持的尺寸）。
+// 格子图块按（皮肤, 像素尺寸, 格值）缓存，逐格只做拷贝，单线程每秒可生成数百张中等棋盘。
+// 每个实例只在一个线程上使用；同一种子与参数总是生成同一张图
+class BoardSynthesizer {
+public:
+    enum class Skin { ClassicXp, Win7, WebFlat, WebClassic };
+    enum class Chrome { None, Xp, Aero, Browser };
+    static const int kSkinCount = 4;
+
+    struct Options {
+        int rows = 16, cols = 30, mines = 99;
+        int cellSize = 16;          // 100% 缩放下的格子像素
+        double dpiScale = 1.0;      // 系统缩放比例（1.25、1.5…）
+        bool bitmapStretch = false; // 客户区按 100% 渲染后整体拉伸（未声明 DPI 感知的程序）：格距非整数、边缘发虚
+        Skin skin = Skin::ClassicXp;
+        Chrome chrome = Chrome::None; // None 时输出只含客户区（同 PrintWindow 截图）
+        double revealed = 0.4;      // 非雷格中打开的目标比例（按连通展开，实际略有出入）
+        double flagged = 0.3;       // 未打开的雷中插旗的比例
+        bool lost = false;          // 踩雷后的画面：显示全部雷
+        int jpegQuality = 0;        // > 0 时做一次 JPEG 编解码往返
+        double noiseSigma = 0.0;    // 高斯噪声标准差（灰度级）
+    };
+
+    struct Frame {
+        cv::Mat image;          // CV_8UC3
+        GameState truth;        // rows/cols/mineCount/grid 为真值：-1 雷，0–8，9 未打开，10 旗子
+        cv::Rect board;         // 网格区域（图像坐标）
+        cv::Rect client;        // 游戏客户区（图像坐标）
+        double cellPitch = 0.0; // 实际格距（像素，拉伸时非整数）
+        int minesLeft = 0;      // HUD 剩余雷数
+        int seconds = 0;        // HUD 计时
+    };
+
+    explicit BoardSynthesizer(uint64_t seed = 1) : m_rng(seed) {}
+
+    // 重新设定随机源：按帧序号设种子，多线程生成的结果与线程数无关
+    void Seed(uint64_t seed) { m_rng.seed(seed); }
+    std::mt19937_64& Rng() { return m_rng; }
+
+    // 随机局面：布雷后从随机格连通展开到目标比例，再按比例插旗
+    void RandomBoard(const Options& opt, GameState& truth);
+    // 把 truth 画成截图（truth.grid 须为 rows×cols）；HUD 数值随机
+    void Render(const GameState& truth, const Options& opt, Frame& out);
+    void Next(const Options& opt, Frame& out) {
+        RandomBoard(opt, out.truth);
+        Render(out.truth, opt, out);
+    }
+
+    static const char* SkinName(Skin skin);
+    static bool ParseSkin(const std::string& name, Skin& skin);
+
+private:
+    // variant：经典/Win7 皮肤 1 为踩中的雷；网页皮肤为棋盘格奇偶（雷格为底色序号 0–3）
+    const cv::Mat& Tile(Skin skin, int cell, int value, int variant);
+    // 画客户区到 m_client，返回网格区域（客户区坐标）
+    cv::Rect RenderClient(const GameState& truth, const Options& opt, int cell, int minesLeft, int seconds);
+    // 加窗口边框/浏览器外框并放到桌面背景上，返回客户区在 out 中的位置
+    cv::Point ComposeChrome(const cv::Mat& client, const Options& opt, cv::Mat& out);
+
+    std::mt19937_64 m_rng;
+    std::unordered_map<uint64_t, cv::Mat> m_tiles;
+    cv::Mat m_client;              // 客户区，跨帧复用
+    cv::Mat m_stretched;
+    cv::Mat m_noise;               // CV_16SC3
+    std::vector<uint8_t> m_jpeg;
+    std::vector<int> m_order;      // 布雷洗牌、展开栈
+    std::vector<int> m_stack;
+    std::vector<uint8_t> m_mine;
+    std::vector<uint8_t> m_open;
+};
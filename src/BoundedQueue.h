@@ -0,0 +1,65 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+// 有界阻塞队列（多生产者 / 多消费者）：满时 Push 阻塞、空时 Pop 阻塞，
+// 容量即阶段之间的背压，在途元素数（内存）与输入规模无关。
+// Close 后 Push 返回 false；Pop 取完剩余元素后返回 false
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : m_capacity(std::max<size_t>(1, capacity)) {}
+
+    bool Push(T item) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [&]{ return m_closed || m_items.size() < m_capacity; });
+        if (m_closed) return false;
+        m_items.push_back(std::move(item));
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    bool Pop(T& out) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [&]{ return m_closed || !m_items.empty(); });
+        if (m_items.empty()) return false;
+        out = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    // 不阻塞：队列为空时立即返回 false（用于把已就绪的元素攒成一批）
+    bool TryPop(T& out) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_items.empty()) return false;
+        out = std::move(m_items.front());
+        m_items.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+private:
+    const size_t m_capacity;
+    std::mutex m_mutex;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<T> m_items;
+    bool m_closed = false;
+};
@@ -0,0 +1,332 @@
+#include "ControlServer.h"
+#include "FramePipeline.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static const int kPollMs = 250;                       // 接受连接时检查停止标志的间隔
+static const size_t kMaxLine = 64 * 1024;             // 单条请求行上限
+static const size_t kMaxImageBytes = 64u << 20;       // analyze 载荷上限
+static const size_t kMaxInFlight = 256;               // 每个连接未应答请求数上限（读线程背压）
+static const size_t kMaxCoalesce = 256 * 1024;        // 合并发送的应答字节上限
+static const size_t kMaxClients = 32;
+
+// 以空白分隔；双引号包住的部分作为一个参数（不支持转义）
+static std::vector<std::string> tokenize(const std::string& line) {
+    std::vector<std::string> tokens;
+    size_t i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) ++i;
+        if (i >= line.size()) break;
+        std::string t;
+        if (line[i] == '"') {
+            size_t end = line.find('"', i + 1);
+            if (end == std::string::npos) end = line.size();
+            t = line.substr(i + 1, end - i - 1);
+            i = end + 1;
+        } else {
+            while (i < line.size() && line[i] != ' ' && line[i] != '\t') t += line[i++];
+        }
+        tokens.push_back(std::move(t));
+    }
+    return tokens;
+}
+
+// 路径按 UTF-8 解释，Windows 上也能打开非 ANSI 文件名
+static std::vector<uint8_t> readFile(const std::string& path) {
+    std::vector<uint8_t> data;
+    std::ifstream is(fs::u8path(path), std::ios::binary | std::ios::ate);
+    if (!is) return data;
+    const std::streamoff size = is.tellg();
+    if (size <= 0 || uint64_t(size) > kMaxImageBytes) return data;
+    data.resize(size_t(size));
+    is.seekg(0);
+    if (!is.read(reinterpret_cast<char*>(data.data()), size)) data.clear();
+    return data;
+}
+
+void ControlServer::Register(const std::string& cmd, Handler handler) {
+    m_handlers[cmd] = std::move(handler);
+}
+
+bool ControlServer::Start(uint16_t port, int workers) {
+    if (m_running.load()) return true;
+    if (!localsock::Startup()) return false;
+    m_listen = localsock::Listen(port, 16);
+    if (m_listen == localsock::kInvalid) {
+        LOGW("控制接口无法监听 127.0.0.1:{}", port);
+        localsock::Cleanup();
+        return false;
+    }
+    if (workers <= 0) workers = int(std::max(1u, std::thread::hardware_concurrency()));
+    m_port = port;
+    m_jobs = std::make_unique<BoundedQueue<Job>>(size_t(workers) * 4);
+    m_running.store(true);
+    for (int i = 0; i < workers; ++i) m_workers.emplace_back(&ControlServer::AnalyzeLoop, this, i);
+    m_acceptThread = std::thread(&ControlServer::AcceptLoop, this);
+    LOGI("控制接口: 127.0.0.1:{}（{} 个识别线程）", port, workers);
+    return true;
+}
+
+void ControlServer::Stop() {
+    if (!m_running.exchange(false)) return;
+    if (m_acceptThread.joinable()) m_acceptThread.join();
+    localsock::Close(m_listen);
+    m_listen = localsock::kInvalid;
+    {
+        // 先断开所有连接让读线程返回，再等各连接写完已受理请求的应答
+        std::lock_guard<std::mutex> lock(m_connMutex);
+        for (auto& c : m_connections) localsock::Shutdown(c->socket);
+        for (auto& c : m_connections) {
+            if (c->thread.joinable()) c->thread.join();
+            localsock::Close(c->socket);
+        }
+        m_connections.clear();
+    }
+    m_jobs->Close();
+    for (auto& t : m_workers) t.join();
+    m_workers.clear();
+    m_jobs.reset();
+    localsock::Cleanup();
+}
+
+void ControlServer::AcceptLoop() {
+    trace::SetThreadName("control");
+    while (m_running.load()) {
+        localsock::Handle client = localsock::Accept(m_listen, kPollMs);
+        std::lock_guard<std::mutex> lock(m_connMutex);
+        // 回收已断开的连接
+        for (auto it = m_connections.begin(); it != m_connections.end();) {
+            if (!(*it)->done.load()) { ++it; continue; }
+            (*it)->thread.join();
+            localsock::Close((*it)->socket);
+            it = m_connections.erase(it);
+        }
+        if (client == localsock::kInvalid) continue;
+        if (m_connections.size() >= kMaxClients) {
+            LOGW("控制接口连接数已达上限 {}，拒绝新连接", kMaxClients);
+            localsock::Close(client);
+            continue;
+        }
+        m_connections.push_back(std::make_unique<Connection>());
+        Connection& conn = *m_connections.back();
+        conn.socket = client;
+        conn.thread = std::thread(&ControlServer::Serve, this, std::ref(conn));
+    }
+}
+
+void ControlServer::Serve(Connection& conn) {
+    trace::SetThreadName("control client");
+    m_clients++;
+    // 读线程解析并受理请求，写线程按序取结果写回：读不等写，客户端可流水线发送
+    BoundedQueue<Pending> pending(kMaxInFlight);
+    std::thread writer(&ControlServer::WriteReplies, this, conn.socket, std::ref(pending));
+
+    std::string buf;
+    std::vector<char> chunk(64 * 1024);
+    auto fill = [&]() {
+        int n = localsock::Recv(conn.socket, chunk.data(), chunk.size());
+        if (n <= 0) return false;
+        buf.append(chunk.data(), size_t(n));
+        return true;
+    };
+    auto fail = [&](const std::string& id, const std::string& msg) {
+        std::promise<Reply> p;
+        p.set_value(Reply{ false, msg });
+        return pending.Push(Pending{ id, p.get_future() });
+    };
+    bool open = true;
+    while (open) {
+        size_t eol;
+        while (open && (eol = buf.find('\n')) == std::string::npos) {
+            if (buf.size() > kMaxLine) { fail("-", "request line too long"); open = false; }
+            else open = fill();
+        }
+        if (!open) break;
+        std::string line = buf.substr(0, eol);
+        buf.erase(0, eol + 1);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        std::vector<std::string> tokens = tokenize(line);
+        if (tokens.empty()) continue;
+        m_requests++;
+        if (tokens.size() < 2) { open = fail(tokens[0], "missing command"); continue; }
+
+        std::vector<uint8_t> payload;
+        if (tokens[1] == "analyze") {
+            // 载荷长度不可信时无法再对齐下一条请求：应答错误后断开
+            char* end = nullptr;
+            const unsigned long long size = tokens.size() == 3 ? std::strtoull(tokens[2].c_str(), &end, 10) : 0;
+            if (!end || *end != '\0' || size == 0 || size > kMaxImageBytes) {
+                fail(tokens[0], "analyze expects a byte count (1.." + std::to_string(kMaxImageBytes) + ")");
+                break;
+            }
+            while (open && buf.size() < size) open = fill();
+            if (!open) break;
+            payload.assign(buf.begin(), buf.begin() + std::ptrdiff_t(size));
+            buf.erase(0, size_t(size));
+        }
+        open = pending.Push(Pending{ tokens[0], Dispatch(tokens, &payload) });
+    }
+    pending.Close();
+    writer.join();
+    m_clients--;
+    conn.done.store(true);
+}
+
+void ControlServer::WriteReplies(localsock::Handle socket, BoundedQueue<Pending>& pending) {
+    std::string out;
+    bool alive = true;
+    Pending p;
+    bool have = pending.Pop(p);
+    while (have) {
+        // 阻塞等待队首，再把紧随其后且已就绪的应答并入同一次发送
+        out.clear();
+        do {
+            Reply r = Take(p.reply);
+            if (!r.ok) std::replace(r.body.begin(), r.body.end(), '\n', ' ');
+            out += p.id;
+            out += r.ok ? " ok " : " error ";
+            out += r.body;
+            out += '\n';
+            have = pending.TryPop(p);
+        } while (have && out.size() < kMaxCoalesce &&
+                 p.reply.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+        // 对端已断开时仍取完结果，读线程随后也会退出
+        if (alive) alive = localsock::SendAll(socket, out.data(), out.size());
+        if (!have) have = pending.Pop(p);
+    }
+}
+
+ControlServer::Reply ControlServer::Take(std::future<Reply>& reply) {
+    try {
+        return reply.get();
+    } catch (const std::future_error&) {
+        return Reply{ false, "server stopping" };
+    }
+}
+
+std::future<ControlServer::Reply> ControlServer::Dispatch(const std::vector<std::string>& tokens,
+                                                          std::vector<uint8_t>* payload) {
+    auto done = [](Reply r) {
+        std::promise<Reply> p;
+        p.set_value(std::move(r));
+        return p.get_future();
+    };
+    const std::string& cmd = tokens[1];
+    const std::vector<std::string> args(tokens.begin() + 2, tokens.end());
+    if (cmd == "ping") return done(Reply{ true, "\"pong\"" });
+    if (cmd == "help") return done(BuiltinHelp());
+    if (cmd == "stats") return done(BuiltinStats());
+    if (cmd == "analyze") return Submit(std::move(*payload), std::string());
+    if (cmd == "analyze-file") {
+        if (args.size() != 1) return done(Reply{ false, "usage: analyze-file <path>" });
+        return Submit({}, args[0]);
+    }
+    if (cmd == "analyze-files") {
+        if (args.empty()) return done(Reply{ false, "usage: analyze-files <path>..." });
+        // 整批先全部入队，由识别线程并行处理；写线程取结果时再按提交顺序拼成数组
+        std::vector<std::future<Reply>> parts;
+        parts.reserve(args.size());
+        for (const auto& path : args) parts.push_back(Submit({}, path));
+        return std::async(std::launch::deferred, [parts = std::move(parts)]() mutable {
+            std::string body = "[";
+            for (size_t i = 0; i < parts.size(); ++i) {
+                Reply r = Take(parts[i]);
+                if (i) body += ',';
+                if (r.ok) body += r.body;
+                else { body += "{\"ok\":0,\"error\":"; AppendJsonString(body, r.body); body += '}'; }
+            }
+            return Reply{ true, body + "]" };
+        });
+    }
+    auto it = m_handlers.find(cmd);
+    if (it == m_handlers.end()) return done(Reply{ false, "unknown command '" + cmd + "' (try help)" });
+    Reply r;
+    r.ok = it->second(args, r.body);
+    return done(std::move(r));
+}
+
+std::future<ControlServer::Reply> ControlServer::Submit(std::vector<uint8_t> encoded, std::string path) {
+    Job job;
+    job.encoded = std::move(encoded);
+    job.path = std::move(path);
+    std::future<Reply> reply = job.reply.get_future();
+    // 队列已关闭时 job 随之销毁，future 得到 broken_promise，由 Take 转为错误应答
+    m_jobs->Push(std::move(job));
+    return reply;
+}
+
+void ControlServer::AnalyzeLoop(int index) {
+    trace::SetThreadName("control analyze " + std::to_string(index));
+    // 每个识别线程一条流水线；相邻请求互不相关，每张图都重新定位
+    FramePipeline pipeline(m_analyzer, false);
+    Job job;
+    while (m_jobs->Pop(job)) {
+        auto t0 = std::chrono::steady_clock::now();
+        cv::Mat image;
+        {
+            STAGE_TIMER(Decode);
+            if (!job.path.empty()) job.encoded = readFile(job.path);
+            if (!job.encoded.empty()) image = cv::imdecode(job.encoded, cv::IMREAD_COLOR);
+        }
+        std::string r = "{";
+        if (!job.path.empty()) {
+            r += "\"file\":";
+            AppendJsonString(r, job.path);
+            r += ',';
+        }
+        if (image.empty()) {
+            r += "\"ok\":0,\"error\":\"decode\"}";
+        } else {
+            GameState state;
+            cv::Rect board;
+            pipeline.Reset();
+            const bool ok = pipeline.Process(image, state, board);
+            const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (ok) {
+                char buf[32];
+                std::snprintf(buf, sizeof(buf), "\"ok\":1,\"ms\":%.2f,", ms);
+                r += buf;
+                AppendBoardJson(r, state, board);
+                r += '}';
+                m_recognized++;
+            } else {
+                r += "\"ok\":0,\"error\":\"analyze\"}";
+            }
+        }
+        m_images++;
+        job.reply.set_value(Reply{ true, std::move(r) });
+        job = Job();
+    }
+}
+
+ControlServer::Reply ControlServer::BuiltinStats() const {
+    std::string r = "{\"clients\":" + std::to_string(m_clients.load())
+                  + ",\"requests\":" + std::to_string(m_requests.load())
+                  + ",\"images\":" + std::to_string(m_images.load())
+                  + ",\"recognized\":" + std::to_string(m_recognized.load())
+                  + ",\"workers\":" + std::to_string(m_workers.size()) + "}";
+    return Reply{ true, r };
+}
+
+ControlServer::Reply ControlServer::BuiltinHelp() const {
+    std::vector<std::string> names = { "analyze", "analyze-file", "analyze-files", "help", "ping", "stats" };
+    for (const auto& h : m_handlers) names.push_back(h.first);
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+    std::string r = "[";
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (i) r += ',';
+        AppendJsonString(r, names[i]);
+    }
+    return Reply{ true, r + "]" };
+}
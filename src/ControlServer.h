@@ -0,0 +1,92 @@
+#pragma once
+#include "BoundedQueue.h"
+#include "LocalSocket.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class GameAnalyzer;
+
+// 本机控制/查询接口：监听 127.0.0.1:port，行式文本协议，可流水线发送。
+//   请求  <id> <命令> [参数...]\n     （参数以空白分隔，含空格的参数用双引号）
+//   应答  <id> ok <JSON>\n  或  <id> error <说明>\n
+// 同一连接的应答严格按请求顺序返回；客户端无需等待上一条应答即可继续发送。
+// 内置命令：ping、help、stats、analyze <字节数>（其后紧跟编码图片的原始字节）、
+// analyze-file <路径>、analyze-files <路径>...（一次提交一批，返回 JSON 数组）。
+// 识别请求不论来自哪个连接，都汇入同一个有界任务队列，由 N 个识别线程各持一条
+// FramePipeline 并行处理；设置、目标等其余命令由宿主通过 Register 提供
+class ControlServer {
+public:
+    // args 不含命令名；成功返回 true 且 out 为 JSON，失败返回 false 且 out 为单行说明
+    using Handler = std::function<bool(const std::vector<std::string>& args, std::string& out)>;
+
+    explicit ControlServer(GameAnalyzer& analyzer) : m_analyzer(analyzer) {}
+    ~ControlServer() { Stop(); }
+    ControlServer(const ControlServer&) = delete;
+    ControlServer& operator=(const ControlServer&) = delete;
+
+    // 须在 Start 之前注册；处理函数在连接的读线程上调用，可能并发
+    void Register(const std::string& cmd, Handler handler);
+    // workers <= 0 时取硬件线程数；端口被占用等失败时返回 false
+    bool Start(uint16_t port, int workers = 0);
+    void Stop();
+    bool IsRunning() const { return m_running.load(); }
+    uint16_t Port() const { return m_port; }
+
+private:
+    struct Reply {
+        bool ok = false;
+        std::string body; // ok 时为 JSON，否则为说明
+    };
+    // 一次识别：encoded 为编码图片字节，path 非空时由识别线程自行读取
+    struct Job {
+        std::vector<uint8_t> encoded;
+        std::string path;
+        std::promise<Reply> reply;
+    };
+    struct Pending {
+        std::string id;
+        std::future<Reply> reply;
+    };
+    struct Connection {
+        localsock::Handle socket = localsock::kInvalid;
+        std::thread thread;
+        std::atomic<bool> done{false};
+    };
+
+    void AcceptLoop();
+    void Serve(Connection& conn);
+    void WriteReplies(localsock::Handle socket, BoundedQueue<Pending>& pending);
+    void AnalyzeLoop(int index);
+    // 按命令分派；识别类命令返回尚未完成的 future
+    std::future<Reply> Dispatch(const std::vector<std::string>& tokens, std::vector<uint8_t>* payload);
+    std::future<Reply> Submit(std::vector<uint8_t> encoded, std::string path);
+    // 取出结果；服务停止导致任务被丢弃时转为错误应答
+    static Reply Take(std::future<Reply>& reply);
+    Reply BuiltinStats() const;
+    Reply BuiltinHelp() const;
+
+    GameAnalyzer& m_analyzer;
+    std::map<std::string, Handler> m_handlers;
+    std::thread m_acceptThread;
+    std::vector<std::thread> m_workers;
+    std::unique_ptr<BoundedQueue<Job>> m_jobs;
+    std::mutex m_connMutex;
+    std::list<std::unique_ptr<Connection>> m_connections;
+    std::atomic<bool> m_running{false};
+    localsock::Handle m_listen = localsock::kInvalid;
+    uint16_t m_port = 0;
+    // stats
+    std::atomic<uint64_t> m_requests{0};
+    std::atomic<uint64_t> m_images{0};
+    std::atomic<uint64_t> m_recognized{0};
+    std::atomic<int> m_clients{0};
+};
@@ -1,4 +1,5 @@
 #include "DisplayWindow.h"
+#include "Metrics.h"
 #include <sstream>
 #include <vector>
 #include <algorithm>
@@ -11,6 +12,33 @@ DisplayWindow::DisplayWindow()
 DisplayWindow::~DisplayWindow() {
     if (m_bitmap) DeleteObject(m_bitmap);
     if (m_memoryDC) DeleteDC(m_memoryDC);
+    for (HFONT f : m_fonts) if (f) DeleteObject(f);
+}
+
+HFONT DisplayWindow::StatusFont(int height) {
+    height = std::max(kMinFontHeight, std::min(kMaxFontHeight, height));
+    return m_fonts[height - kMinFontHeight];
+}
+
+// 状态栏字体适配：优先换行，宽度仍超出则逐级缩小字体（18 → 11）；文本与宽度不变时沿用上次结果
+void DisplayWindow::FitStatus(HDC dc, const std::wstring& text, int width) {
+    if (text == m_fitText && width == m_fitWidth) return;
+    const RECT base{ 0, 0, width, 0 };
+    int chosen = kMinFontHeight;
+    int textH = 0;
+    for (int h = kMaxFontHeight; h >= kMinFontHeight; --h) {
+        HFONT prev = (HFONT)SelectObject(dc, StatusFont(h));
+        RECT measure = base;
+        DrawTextW(dc, text.c_str(), -1, &measure, DT_LEFT | DT_WORDBREAK | DT_CALCRECT);
+        SelectObject(dc, prev);
+        chosen = h;
+        textH = measure.bottom - measure.top;
+        if (measure.right - measure.left <= width) break;
+    }
+    m_fitText = text;
+    m_fitWidth = width;
+    m_fitFont = chosen;
+    m_fitHeight = textH;
 }
 
 void DisplayWindow::AutoAdjustForStatus() {
@@ -21,15 +49,15 @@ void DisplayWindow::AutoAdjustForStatus() {
     RECT statusRc{ rcClient.left + padX, rcClient.top + padTop, rcClient.right - padX, rcClient.bottom };
 
     // 选择一个适中的字体测量换行高度
-    HFONT hFont = CreateFontW(-14, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                              DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                              CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"");
-    HFONT old = (HFONT)SelectObject(hdc, hFont);
+    HFONT old = (HFONT)SelectObject(hdc, StatusFont(14));
     RECT measure = statusRc;
-    std::wstring status = m_statusText.empty() ? L"状态: 未绑定窗口" : m_statusText;
+    std::wstring status;
+    {
+        std::lock_guard<std::mutex> lock(m_renderMutex);
+        status = m_statusText.empty() ? L"状态: 未绑定窗口" : m_statusText;
+    }
     DrawTextW(hdc, status.c_str(), -1, &measure, DT_LEFT | DT_WORDBREAK | DT_CALCRECT);
     SelectObject(hdc, old);
-    DeleteObject(hFont);
     ReleaseDC(m_hwnd, hdc);
 
     int statusHeight = (measure.bottom - measure.top) + 8; // 文本高度 + 一点间距
@@ -75,156 +103,61 @@ LRESULT CALLBACK DisplayWindow::WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPAR
         return 0;
     }
     case WM_PAINT: {
+        TRACE_SPAN("paint");
         PAINTSTRUCT ps;
         HDC hdc = BeginPaint(hwnd, &ps);
         RECT rc; GetClientRect(hwnd, &rc);
-        // 使用内存 DC 进行绘制
         DisplayWindow* self = reinterpret_cast<DisplayWindow*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
-        HDC ddc = (self && self->m_memoryDC) ? self->m_memoryDC : hdc;
+        if (!self || !self->m_memoryDC) {
+            FillRect(hdc, &rc, (HBRUSH)(COLOR_WINDOW + 1));
+            EndPaint(hwnd, &ps);
+            return 0;
+        }
+        // 使用内存 DC 进行绘制；字体、适配结果与棋盘画布都已缓存，这里只做拼合与上屏
+        HDC ddc = self->m_memoryDC;
+        std::lock_guard<std::mutex> lock(self->m_renderMutex);
         FillRect(ddc, &rc, (HBRUSH)(COLOR_WINDOW + 1));
-        // 取 this 指针（上方已取）
+        SetBkMode(ddc, TRANSPARENT);
 
-    SetBkMode(ddc, TRANSPARENT);
-    // 状态栏文本（优先换行，次选缩小字体）
+        // 状态栏文本（优先换行，次选缩小字体）
         const int padX = 8, padTop = 4;
         RECT statusRc{ rc.left + padX, rc.top + padTop, rc.right - padX, rc.bottom };
-        std::wstring status = (self && !self->m_statusText.empty()) ? self->m_statusText : L"状态: 未绑定窗口";
-
-        // 基准字体高度从 18 逐步降低到 11
-    HFONT hOldFont = (HFONT)SelectObject(ddc, GetStockObject(DEFAULT_GUI_FONT));
-        HFONT hFontFit = NULL;
-        SIZE textSize{};
-        int chosenHeight = 14; // 默认
-        const int availWidth = statusRc.right - statusRc.left;
-        for (int h = 18; h >= 11; --h) {
-            HFONT hTry = CreateFontW(-h, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                                     DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                     CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"");
-            HFONT hPrev = (HFONT)SelectObject(ddc, hTry);
-            // 使用换行布局测量高度
-            RECT measureRc = statusRc;
-            DrawTextW(ddc, status.c_str(), -1, &measureRc, DT_LEFT | DT_WORDBREAK | DT_CALCRECT);
-            textSize.cx = (measureRc.right - measureRc.left);
-            textSize.cy = (measureRc.bottom - measureRc.top);
-            SelectObject(ddc, hPrev);
-            if (textSize.cx <= availWidth) { hFontFit = hTry; chosenHeight = h; break; }
-            DeleteObject(hTry);
-        }
-        if (!hFontFit) {
-            // 没有找到合适宽度的字体，则采用最小高度并依赖省略号
-            hFontFit = CreateFontW(-11, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
-                                   DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
-                                   CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"");
+        const std::wstring status = self->m_statusText.empty() ? L"状态: 未绑定窗口" : self->m_statusText;
+        self->FitStatus(ddc, status, statusRc.right - statusRc.left);
+        HFONT hPrevFont = (HFONT)SelectObject(ddc, self->StatusFont(self->m_fitFont));
+        RECT drawRc{ statusRc.left, statusRc.top, statusRc.right, statusRc.top + self->m_fitHeight };
+        DrawTextW(ddc, status.c_str(), -1, &drawRc, DT_LEFT | DT_WORDBREAK);
+        SelectObject(ddc, hPrevFont);
+
+        // 根据状态栏高度动态让出空间；高度变化时需整窗重绘
+        const int gridTop = padTop + std::max(22, self->m_fitHeight + 6);
+        if (gridTop != self->m_statusBand) {
+            self->m_statusBand = gridTop;
+            InvalidateRect(hwnd, NULL, FALSE);
         }
-    HFONT hPrevFont = (HFONT)SelectObject(ddc, hFontFit);
-        // 计算文本高度
-    TEXTMETRIC tm{}; GetTextMetricsW(ddc, &tm);
-    // 用多行绘制，计算实际高度
-    RECT drawRc{ statusRc.left, statusRc.top, statusRc.right, statusRc.bottom };
-    DrawTextW(ddc, status.c_str(), -1, &drawRc, DT_LEFT | DT_WORDBREAK | DT_CALCRECT);
-    int statusHeight = (drawRc.bottom - drawRc.top);
-    // 实际绘制
-    DrawTextW(ddc, status.c_str(), -1, &drawRc, DT_LEFT | DT_WORDBREAK);
-        // 恢复字体并清理
-    SelectObject(ddc, hPrevFont);
-        DeleteObject(hFontFit);
-
-        // 简易网格渲染
-        if (self && self->m_state.rows > 0 && self->m_state.cols > 0) {
-            // 根据状态栏高度动态让出空间
-            int gridTop = padTop + (int)std::max(22, (int)statusHeight + 6);
-            int w = (rc.right - rc.left) - 16; // padding
-            int h = (rc.bottom - rc.top) - gridTop - 16;
-            if (w < 10 || h < 10) { EndPaint(hwnd, &ps); return 0; }
-            // 计算单元格像素大小：优先适配可用空间，再限制最大像素大小以避免在小盘面时过大
-            int cols = self->m_state.cols;
-            int rows = self->m_state.rows;
-            int fitSize = std::min(w / std::max(1, cols), h / std::max(1, rows));
-            int maxCell = 24; // 最大单元像素，避免 9x9 时过大
-            int cell = std::max(1, std::min(fitSize, maxCell));
-            int gridW = cell * cols;
-            int gridH = cell * rows;
-            // 居中显示网格
-            int startX = rc.left + 8 + (w - gridW) / 2;
-            int startY = rc.top + gridTop + (h - gridH) / 2;
-
-            auto colorNum = [&](int n) -> COLORREF {
-                switch (n) {
-                case 1: return RGB(0,0,255);
-                case 2: return RGB(0,128,0);
-                case 3: return RGB(255,0,0);
-                case 4: return RGB(0,0,128);
-                case 5: return RGB(128,0,0);
-                case 6: return RGB(0,128,128);
-                case 7: return RGB(0,0,0);
-                case 8: return RGB(128,128,128);
-                default: return RGB(0,0,0);
-                }
-            };
-
-            HPEN gridPen = CreatePen(PS_SOLID, 1, RGB(200,200,200));
-            HGDIOBJ oldPen = SelectObject(ddc, gridPen);
-            // 网格线
-            for (int r = 0; r <= self->m_state.rows; ++r) {
-                int y = startY + r * cell;
-                MoveToEx(ddc, startX, y, NULL);
-                LineTo(ddc, startX + cell * self->m_state.cols, y);
-            }
-            for (int c = 0; c <= self->m_state.cols; ++c) {
-                int x = startX + c * cell;
-                MoveToEx(ddc, x, startY, NULL);
-                LineTo(ddc, x, startY + cell * self->m_state.rows);
-            }
 
-            // 单元格内容
-            for (int r = 0; r < self->m_state.rows; ++r) {
-                for (int c = 0; c < self->m_state.cols; ++c) {
-                    int v = 9;
-                    if (r < (int)self->m_state.grid.size() && c < (int)self->m_state.grid[r].size())
-                        v = self->m_state.grid[r][c];
-                    RECT cellRc{ startX + c*cell, startY + r*cell, startX + (c+1)*cell, startY + (r+1)*cell };
-                    // 背景色：未知淡灰，旗子淡黄，雷淡红
-                    COLORREF bg = RGB(255,255,255);
-                    if (v == 9) bg = RGB(245,245,245);
-                    else if (v == 10) bg = RGB(255,250,205);
-                    else if (v == -1) bg = RGB(255,228,225);
-                    HBRUSH b = CreateSolidBrush(bg);
-                    FillRect(ddc, &cellRc, b); DeleteObject(b);
-
-                    if (v >= 1 && v <= 8) {
-                        std::wstring t = std::to_wstring(v);
-                        SetTextColor(ddc, colorNum(v));
-                        DrawTextW(ddc, t.c_str(), -1, &cellRc, DT_CENTER | DT_VCENTER | DT_SINGLELINE);
-                    }
-                }
+        // 棋盘：视口变化时整盘重绘，否则直接使用 Update 增量维护的画布
+        const int w = (rc.right - rc.left) - 16; // padding
+        const int h = (rc.bottom - rc.top) - gridTop - 16;
+        if (self->m_state.rows > 0 && self->m_state.cols > 0 && w >= 10 && h >= 10) {
+            if (self->m_renderer.SetViewport(cv::Size(w, h))) self->m_renderer.Update(self->m_state);
+            self->m_boardOrigin = POINT{ rc.left + 8, rc.top + gridTop };
+            const cv::Mat& canvas = self->m_renderer.Canvas();
+            if (!canvas.empty()) {
+                BITMAPINFO bmi{};
+                bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+                bmi.bmiHeader.biWidth = canvas.cols;
+                bmi.bmiHeader.biHeight = -canvas.rows; // 自顶向下
+                bmi.bmiHeader.biPlanes = 1;
+                bmi.bmiHeader.biBitCount = 32;
+                bmi.bmiHeader.biCompression = BI_RGB;
+                SetDIBitsToDevice(ddc, self->m_boardOrigin.x, self->m_boardOrigin.y, canvas.cols, canvas.rows,
+                                  0, 0, 0, canvas.rows, canvas.data, &bmi, DIB_RGB_COLORS);
             }
-
-            // 高亮建议
-            auto drawHighlight = [&](const std::vector<cv::Point>& pts, COLORREF col) {
-                HPEN pen = CreatePen(PS_SOLID, 2, col);
-                HGDIOBJ old = SelectObject(ddc, pen);
-                HGDIOBJ oldBrush = SelectObject(ddc, GetStockObject(HOLLOW_BRUSH));
-                for (auto& p : pts) {
-                    if (p.y < 0 || p.y >= self->m_state.rows || p.x < 0 || p.x >= self->m_state.cols) continue;
-                    RECT cellHi{ startX + p.x*cell, startY + p.y*cell, startX + (p.x+1)*cell, startY + (p.y+1)*cell };
-                    Rectangle(ddc, cellHi.left, cellHi.top, cellHi.right, cellHi.bottom);
-                }
-                SelectObject(ddc, oldBrush);
-                SelectObject(ddc, old);
-                DeleteObject(pen);
-            };
-            drawHighlight(self->m_state.safeCells, RGB(0,200,0));
-            drawHighlight(self->m_state.mineCells, RGB(200,0,0));
-
-            SelectObject(ddc, oldPen);
-            DeleteObject(gridPen);
-        }
-
-        // 将内存缓冲拷贝到前台
-        if ((self && self->m_memoryDC) && (ddc != hdc)) {
-            BitBlt(hdc, 0, 0, rc.right-rc.left, rc.bottom-rc.top, ddc, 0, 0, SRCCOPY);
         }
 
+        // 将内存缓冲拷贝到前台（只有无效区域会真正更新）
+        BitBlt(hdc, 0, 0, rc.right-rc.left, rc.bottom-rc.top, ddc, 0, 0, SRCCOPY);
         EndPaint(hwnd, &ps);
         return 0;
     }
@@ -252,6 +185,13 @@ bool DisplayWindow::Create() {
 
     if (!m_hwnd) return false;
 
+    // 状态栏字体一次创建，之后各线程只读
+    for (int h = kMinFontHeight; h <= kMaxFontHeight; ++h) {
+        m_fonts[h - kMinFontHeight] = CreateFontW(-h, 0, 0, 0, FW_NORMAL, FALSE, FALSE, FALSE,
+                                                  DEFAULT_CHARSET, OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS,
+                                                  CLEARTYPE_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"");
+    }
+
     // 绑定 this 以便在 WndProc 中使用
     SetWindowLongPtr(m_hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
 
@@ -274,9 +214,34 @@ void DisplayWindow::ResizeBackBuffer(int w, int h) {
     ReleaseDC(m_hwnd, hdc);
 }
 
+// 在调用线程增量重绘画布，只让变化格子所在区域失效
 void DisplayWindow::Update(const GameState& state) {
-    m_state = state;
-    InvalidateRect(m_hwnd, NULL, FALSE);
+    cv::Rect dirty;
+    POINT origin{};
+    {
+        STAGE_TIMER(Render);
+        std::lock_guard<std::mutex> lock(m_renderMutex);
+        m_state = state;
+        dirty = m_renderer.Update(m_state);
+        origin = m_boardOrigin;
+    }
+    if (dirty.area() <= 0) return;
+    RECT rc{ origin.x + dirty.x, origin.y + dirty.y, origin.x + dirty.x + dirty.width, origin.y + dirty.y + dirty.height };
+    InvalidateRect(m_hwnd, &rc, FALSE);
+}
+
+void DisplayWindow::SetStatusText(const std::wstring& text) {
+    int band;
+    {
+        std::lock_guard<std::mutex> lock(m_renderMutex);
+        if (text == m_statusText) return;
+        m_statusText = text;
+        band = m_statusBand;
+    }
+    AutoAdjustForStatus();
+    // 只重绘状态栏一带；首次绘制前或高度变化时由 WM_PAINT 整窗重绘
+    RECT rc{ 0, 0, m_width, band };
+    InvalidateRect(m_hwnd, band > 0 ? &rc : NULL, FALSE);
 }
 
 void DisplayWindow::Render() {
@@ -2,8 +2,10 @@
 #define DISPLAY_WINDOW_H
 
 #include <windows.h>
+#include <mutex>
 #include <string>
 #include "GameState.h"
+#include "BoardRenderer.h"
 
 class DisplayWindow {
 public:
@@ -25,7 +27,7 @@ public:
     void SnapNear(const RECT& targetClientRectOnScreen);
 
     // 状态栏内容（外部更新）
-    void SetStatusText(const std::wstring& text) { m_statusText = text; AutoAdjustForStatus(); InvalidateRect(m_hwnd, NULL, FALSE); }
+    void SetStatusText(const std::wstring& text);
 
     HWND GetHandle() const { return m_hwnd; }
 
@@ -38,6 +40,23 @@ private:
     bool m_topMost = true;
     std::wstring m_statusText; // 状态栏文本
 
+    // 棋盘离屏画布：Update 在分析线程增量重绘，WM_PAINT 在界面线程上屏，二者经 m_renderMutex 互斥
+    BoardRenderer m_renderer;
+    std::mutex m_renderMutex;
+    POINT m_boardOrigin{0, 0};  // 画布在客户区中的左上角
+    int m_statusBand = 0;       // 状态栏占用高度（含上边距），仅状态文本变化时重绘这一带
+
+    // 状态栏字体按高度 11–18 缓存，适配结果按 文本 + 宽度 缓存
+    static const int kMinFontHeight = 11;
+    static const int kMaxFontHeight = 18;
+    HFONT m_fonts[kMaxFontHeight - kMinFontHeight + 1] = {};
+    std::wstring m_fitText;
+    int m_fitWidth = -1;
+    int m_fitFont = 14;
+    int m_fitHeight = 0;
+
+    HFONT StatusFont(int height);
+    void FitStatus(HDC dc, const std::wstring& text, int width);
     void ResizeBackBuffer(int w, int h);
     void AutoAdjustForStatus();
 
@@ -0,0 +1,212 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <new>
+
+// 单块上限；单次分配超过它的 1/4（如 4K 的 BGRA 整帧）转交堆，免得一次大图让 arena 长期占着大块
+static const size_t kMaxChunkBytes = size_t(64) << 20;
+static const size_t kMaxCarveBytes = kMaxChunkBytes / 4;
+static const size_t kMatAlign = 64; // 与 cv::fastMalloc 对齐一致，SIMD 路径不受影响
+
+// 引用计数 = 尚未释放的切分数 + arena 自身的 1 个引用；计数为 1 即空闲。
+// 释放可来自任意线程，只动计数：arena 丢掉自己的引用（析构或合并）后，最后一次释放回收本块
+struct FrameArena::Chunk {
+    uchar* base = nullptr;
+    size_t size = 0;
+    size_t used = 0;               // 仅持有者线程访问
+    std::atomic<int> refs{1};
+};
+
+static thread_local FrameArena* t_current = nullptr;
+static cv::MatAllocator* g_fallback = nullptr;
+static std::atomic<size_t> g_peakBytes{0};
+static std::atomic<size_t> g_reservedBytes{0};
+static std::atomic<uint64_t> g_oversized{0};
+
+static size_t alignUp(size_t v, size_t align) { return (v + align - 1) & ~(align - 1); }
+
+// Mat 头（UMatData）与数据切在同一块里，头在前；u->handle 记所在块
+class ArenaMatAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+        FrameArena* arena = t_current;
+        if (!arena || data) return g_fallback->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; --i) {
+            if (step) step[i] = total;
+            total *= sizes[i];
+        }
+        if (total > kMaxCarveBytes) {
+            g_oversized.fetch_add(1, std::memory_order_relaxed);
+            return g_fallback->allocate(dims, sizes, type, data, step, flags, usageFlags);
+        }
+        const size_t header = alignUp(sizeof(cv::UMatData), kMatAlign);
+        FrameArena::Chunk* chunk = nullptr;
+        uchar* block = static_cast<uchar*>(arena->Carve(header + total, kMatAlign, chunk));
+        cv::UMatData* u = new (block) cv::UMatData(this);
+        u->data = u->origdata = block + header;
+        u->size = total;
+        u->handle = chunk;
+        return u;
+    }
+    bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override {
+        return u != nullptr;
+    }
+    void deallocate(cv::UMatData* u) const override {
+        if (!u) return;
+        FrameArena::Chunk* chunk = static_cast<FrameArena::Chunk*>(u->handle);
+        u->~UMatData();
+        FrameArena::Release(chunk);
+    }
+};
+
+static ArenaMatAllocator g_matAllocator;
+
+void FrameArena::Install() {
+    if (g_fallback) return;
+    g_fallback = cv::Mat::getDefaultAllocator();
+    cv::Mat::setDefaultAllocator(&g_matAllocator);
+}
+
+cv::MatAllocator* FrameArena::HeapAllocator() {
+    return g_fallback ? g_fallback : cv::Mat::getDefaultAllocator();
+}
+
+cv::Mat FrameArena::HeapCopy(const cv::Mat& m) {
+    cv::Mat out;
+    out.allocator = HeapAllocator();
+    m.copyTo(out);
+    return out;
+}
+
+std::pmr::memory_resource* FrameArena::Resource() {
+    return t_current ? static_cast<std::pmr::memory_resource*>(t_current) : std::pmr::get_default_resource();
+}
+
+size_t FrameArena::GlobalPeakBytes() { return g_peakBytes.load(std::memory_order_relaxed); }
+size_t FrameArena::GlobalReservedBytes() { return g_reservedBytes.load(std::memory_order_relaxed); }
+uint64_t FrameArena::GlobalOversized() { return g_oversized.load(std::memory_order_relaxed); }
+
+FrameArena::Scope::Scope(FrameArena& arena) : m_arena(arena), m_prev(t_current) {
+    t_current = &arena;
+}
+
+FrameArena::Scope::~Scope() {
+    t_current = m_prev;
+    m_arena.Reset();
+}
+
+FrameArena::~FrameArena() {
+    // 仍被持有的块交给最后一次释放回收
+    for (Chunk* c : m_chunks) Release(c);
+}
+
+size_t FrameArena::ReservedBytes() const {
+    size_t total = 0;
+    for (const Chunk* c : m_chunks) total += c->size;
+    return total;
+}
+
+void FrameArena::FreeChunk(Chunk* chunk) {
+    g_reservedBytes.fetch_sub(chunk->size, std::memory_order_relaxed);
+    cv::fastFree(chunk->base);
+    delete chunk;
+}
+
+void FrameArena::Release(Chunk* chunk) {
+    if (chunk->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) FreeChunk(chunk);
+}
+
+bool FrameArena::Idle(const Chunk* chunk) {
+    return chunk->refs.load(std::memory_order_acquire) == 1;
+}
+
+void* FrameArena::Carve(size_t bytes, size_t align, Chunk*& owner) {
+    const size_t n = m_chunks.size();
+    for (size_t k = 0; k < n; ++k) {
+        const size_t index = (m_current + k) % n;
+        Chunk& c = *m_chunks[index];
+        // 当前块接着切；其余块只有全部释放后才能从头复用
+        if (k > 0) {
+            if (!Idle(&c)) continue;
+            c.used = 0;
+        }
+        const size_t offset = alignUp(c.used, align);
+        if (offset + bytes > c.size) continue;
+        c.used = offset + bytes;
+        c.refs.fetch_add(1, std::memory_order_relaxed);
+        m_current = index;
+        m_frameBytes += bytes;
+        owner = &c;
+        return c.base + offset;
+    }
+    // 新块至少翻倍，让帧内换块的次数随用量对数增长
+    size_t size = m_chunks.empty() ? m_initialBytes : std::min(kMaxChunkBytes, 2 * m_chunks.back()->size);
+    size = std::max(size, alignUp(bytes + align, kMatAlign));
+    Chunk* c = new Chunk;
+    c->base = static_cast<uchar*>(cv::fastMalloc(size));
+    c->size = size;
+    g_reservedBytes.fetch_add(size, std::memory_order_relaxed);
+    m_chunks.push_back(c);
+    m_current = m_chunks.size() - 1;
+    c->used = bytes;
+    c->refs.store(2, std::memory_order_relaxed);
+    m_frameBytes += bytes;
+    owner = c;
+    return c->base;
+}
+
+void FrameArena::Reset() {
+    m_lastFrameBytes = m_frameBytes;
+    m_peakBytes = std::max(m_peakBytes, m_frameBytes);
+    m_frameBytes = 0;
+    size_t seen = g_peakBytes.load(std::memory_order_relaxed);
+    while (m_peakBytes > seen && !g_peakBytes.compare_exchange_weak(seen, m_peakBytes, std::memory_order_relaxed)) {}
+
+    bool allIdle = true;
+    for (Chunk* c : m_chunks) {
+        if (Idle(c)) c->used = 0;
+        else allIdle = false;
+    }
+    // 多块且全部空闲：按单帧峰值（留 1/4 余量）合并为一块，下一帧不再换块
+    if (allIdle && m_chunks.size() > 1) {
+        const size_t want = std::max(m_initialBytes, m_peakBytes + m_peakBytes / 4);
+        const size_t size = std::min(kMaxChunkBytes, alignUp(want, kMatAlign));
+        // 空闲块只剩 arena 的引用，其他线程不会再碰：直接回收
+        for (Chunk* c : m_chunks) Release(c);
+        m_chunks.clear();
+        Chunk* c = new Chunk;
+        c->base = static_cast<uchar*>(cv::fastMalloc(size));
+        c->size = size;
+        g_reservedBytes.fetch_add(size, std::memory_order_relaxed);
+        m_chunks.push_back(c);
+    }
+    m_current = 0;
+    for (size_t i = 0; i < m_chunks.size(); ++i) {
+        if (Idle(m_chunks[i])) { m_current = i; break; }
+    }
+}
+
+// 与 Mat 一样在切分前部记下所在块：释放（可在任意线程）只读这个指针，不查 m_chunks。
+// 是否转交堆只由 bytes 决定，分配与释放两侧判断一致
+void* FrameArena::do_allocate(size_t bytes, size_t align) {
+    if (bytes > kMaxCarveBytes) {
+        g_oversized.fetch_add(1, std::memory_order_relaxed);
+        return std::pmr::get_default_resource()->allocate(bytes, align);
+    }
+    align = std::max(align, alignof(std::max_align_t));
+    const size_t header = alignUp(sizeof(Chunk*), align);
+    Chunk* chunk = nullptr;
+    uchar* block = static_cast<uchar*>(Carve(header + std::max<size_t>(bytes, 1), align, chunk));
+    uchar* p = block + header;
+    reinterpret_cast<Chunk**>(p)[-1] = chunk;
+    return p;
+}
+
+void FrameArena::do_deallocate(void* p, size_t bytes, size_t align) {
+    if (bytes > kMaxCarveBytes) {
+        std::pmr::get_default_resource()->deallocate(p, bytes, align);
+        return;
+    }
+    Release(reinterpret_cast<Chunk**>(p)[-1]);
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+// 帧内存区：分析一帧期间的临时 cv::Mat（含 OpenCV 内部临时图）与 STL 缓冲从几块大内存里顺序切分，
+// 帧结束时整体回绕，不经过通用堆；长时间运行时堆上不再有逐帧的分配与释放，碎片不会增长。
+// 按块计数：帧结束后仍被持有的 Mat 只让所在的块暂不回绕，内容不会被覆盖；
+// 帧内换过多块时，全部空闲后合并为一块，稳态下只有一块。
+// 分配只在持有者线程的 Scope 内发生；Mat 与 pmr 缓冲可在任意线程释放。
+// 跨帧保留的 Mat（FrameContext、ScratchPool、BoardRenderer 的画布与图块、函数内 static 核）固定用 HeapAllocator，
+// 不占帧内存：它们若从 arena 切分，会让所在的块永远无法回绕
+class FrameArena : public std::pmr::memory_resource {
+public:
+    static const size_t kDefaultBytes = size_t(1) << 20;
+
+    explicit FrameArena(size_t initialBytes = kDefaultBytes) : m_initialBytes(initialBytes) {}
+    ~FrameArena() override;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // 一帧：作用域内本线程用默认分配器创建的 Mat 从 arena 切分，Resource() 返回 arena；
+    // 析构时恢复外层设置并回绕（Reset）
+    class Scope {
+    public:
+        explicit Scope(FrameArena& arena);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        FrameArena& m_arena;
+        FrameArena* m_prev;
+    };
+
+    // 帧结束：记录本帧用量与峰值，空闲的块回绕
+    void Reset();
+
+    size_t FrameBytes() const { return m_frameBytes; }  // 本帧已切出的字节（含 Mat 头）
+    size_t PeakBytes() const { return m_peakBytes; }    // 历来单帧峰值
+    size_t LastFrameBytes() const { return m_lastFrameBytes; }
+    size_t ReservedBytes() const;                       // 当前持有的块总大小
+    size_t ChunkCount() const { return m_chunks.size(); }
+
+    // 装为 cv::Mat 默认分配器，包在原默认分配器（调试构建为 alloccount 的计数分配器）外层：
+    // 不在 Scope 内、包装外部内存或单次超过上限时原样转交。进程启动时调用一次，须在 alloccount::Install 之后
+    static void Install();
+    // 原默认分配器；跨帧保留的 Mat 在首次 create 前把 Mat::allocator 设为它
+    static cv::MatAllocator* HeapAllocator();
+    // 复制到 HeapAllocator 上，供函数内 static 等首次创建可能落在 Scope 内的常量 Mat
+    static cv::Mat HeapCopy(const cv::Mat& m);
+    // 本线程当前帧的 arena（无则为全局默认资源），供 std::pmr 容器做帧内临时缓冲
+    static std::pmr::memory_resource* Resource();
+    // 所有 arena 合计：历来单帧峰值中的最大值、当前持有的块总大小、超过上限转交堆的次数
+    static size_t GlobalPeakBytes();
+    static size_t GlobalReservedBytes();
+    static uint64_t GlobalOversized();
+
+private:
+    friend class ArenaMatAllocator;
+    struct Chunk;
+
+    // 从当前块切分；不够时复用已空闲的块或新开一块。owner 返回所在块（释放时计数）
+    void* Carve(size_t bytes, size_t align, Chunk*& owner);
+    static void Release(Chunk* chunk);
+    static bool Idle(const Chunk* chunk); // 只剩 arena 自身的引用
+    static void FreeChunk(Chunk* chunk);
+
+    void* do_allocate(size_t bytes, size_t align) override;
+    void do_deallocate(void* p, size_t bytes, size_t align) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    size_t m_initialBytes;
+    std::vector<Chunk*> m_chunks;
+    size_t m_current = 0;
+    size_t m_frameBytes = 0;
+    size_t m_lastFrameBytes = 0;
+    size_t m_peakBytes = 0;
+};
@@ -0,0 +1,47 @@
+#include "FrameChangeDetector.h"
+#include <opencv2/imgproc.hpp>
+#include <cmath>
+
+static const int kThumbWidth = 192;     // 缩略图宽度（30 列棋盘约 6px/格）
+static const double kDiffThreshold = 24; // 任一缩略像素通道差超过该值视为变化
+
+void FrameChangeDetector::SetWatchRegion(const cv::Rect& region) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (region == m_watch) return;
+    m_watch = region;
+    m_reset = true; // 区域变了，上一缩略图不可比
+}
+
+void FrameChangeDetector::Reset() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_reset = true;
+}
+
+bool FrameChangeDetector::Update(const cv::Mat& frame, const cv::Rect& frameRect) {
+    if (frame.empty()) return false;
+    cv::Rect watch;
+    bool reset;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        watch = m_watch;
+        reset = m_reset;
+        m_reset = false;
+    }
+    cv::Rect local(0, 0, frame.cols, frame.rows);
+    if (watch.area() > 0) {
+        cv::Rect r(watch.x - frameRect.x, watch.y - frameRect.y, watch.width, watch.height);
+        r &= local;
+        if (r.area() > 0) local = r;
+    }
+    cv::Mat src = frame(local);
+    int tw = std::min(kThumbWidth, src.cols);
+    int th = std::max(1, int(std::lround(double(src.rows) * tw / src.cols)));
+    cv::resize(src, m_thumb, cv::Size(tw, th), 0, 0, cv::INTER_AREA);
+
+    bool changed = true;
+    if (!reset && m_prevThumb.size() == m_thumb.size() && m_prevThumb.type() == m_thumb.type()) {
+        changed = cv::norm(m_thumb, m_prevThumb, cv::NORM_INF) > kDiffThreshold;
+    }
+    std::swap(m_thumb, m_prevThumb);
+    return changed;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <mutex>
+
+// 帧变化检测：把关注区域按面积平均缩成小缩略图，与上一帧逐像素比较最大差值。
+// 缩略图保证每格仍有若干像素，翻开/插旗会改变对应块的均值；压缩噪声被平均掉。
+class FrameChangeDetector {
+public:
+    // 关注区域（客户区坐标）；为空时检测整帧。分析线程将其设为棋盘网格以排除 HUD 计时器
+    void SetWatchRegion(const cv::Rect& region);
+    // 捕获线程调用；frameRect 为 frame 在客户区中的位置。返回与上一帧相比是否变化
+    bool Update(const cv::Mat& frame, const cv::Rect& frameRect);
+    void Reset();
+
+private:
+    std::mutex m_mutex;
+    cv::Rect m_watch;
+    bool m_reset = true;
+    // 以下仅由捕获线程访问
+    cv::Mat m_thumb;
+    cv::Mat m_prevThumb;
+};
@@ -0,0 +1,77 @@
+#include "FrameContext.h"
+#include "FrameArena.h"
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+
+void FrameContext::Reset(const cv::Mat& frame) {
+    m_frame = frame;
+    m_valid = 0;
+}
+
+void FrameContext::SetAllocator(cv::MatAllocator* allocator) {
+    for (Mat* m : { &m_gray, &m_bgr, &m_hsv, &m_mask1, &m_mask2, &m_red, &m_blur }) m->allocator = allocator;
+    for (Mat& m : m_edges) m.allocator = allocator;
+}
+
+const cv::Mat& FrameContext::Gray() {
+    // 单通道帧直接作为灰度图，不写入 m_gray 以免与帧内存别名
+    if (m_frame.channels() == 1) return m_frame;
+    if (!(m_valid & kHasGray)) {
+        cvtColor(m_frame, m_gray, m_frame.channels() == 4 ? COLOR_BGRA2GRAY : COLOR_BGR2GRAY);
+        m_valid |= kHasGray;
+    }
+    return m_gray;
+}
+
+const cv::Mat& FrameContext::Bgr() {
+    if (m_frame.channels() == 3) return m_frame;
+    if (!(m_valid & kHasBgr)) {
+        cvtColor(m_frame, m_bgr, m_frame.channels() == 4 ? COLOR_BGRA2BGR : COLOR_GRAY2BGR);
+        m_valid |= kHasBgr;
+    }
+    return m_bgr;
+}
+
+const cv::Mat& FrameContext::Hsv() {
+    if (!(m_valid & kHasHsv)) {
+        cvtColor(Bgr(), m_hsv, COLOR_BGR2HSV);
+        m_valid |= kHasHsv;
+    }
+    return m_hsv;
+}
+
+const cv::Mat& FrameContext::RedMask() {
+    if (!(m_valid & kHasRed)) {
+        const Mat& hsv = Hsv();
+        inRange(hsv, Scalar(0, 100, 80), Scalar(10, 255, 255), m_mask1);
+        inRange(hsv, Scalar(160, 100, 80), Scalar(180, 255, 255), m_mask2);
+        bitwise_or(m_mask1, m_mask2, m_red);
+        static const Mat kernel = FrameArena::HeapCopy(getStructuringElement(MORPH_RECT, Size(3,3)));
+        morphologyEx(m_red, m_red, MORPH_CLOSE, kernel);
+        m_valid |= kHasRed;
+    }
+    return m_red;
+}
+
+const cv::Mat& FrameContext::Edges(EdgeKind kind) {
+    const unsigned bit = kHasEdges0 << kind;
+    if (!(m_valid & bit)) {
+        Mat& dst = m_edges[kind];
+        switch (kind) {
+        case kEdgesBlurred:
+            GaussianBlur(Gray(), m_blur, Size(3,3), 0);
+            Canny(m_blur, dst, 50, 150);
+            break;
+        case kEdgesDefault:
+            Canny(Gray(), dst, 50, 150);
+            break;
+        case kEdgesGrid:
+        default:
+            Canny(Gray(), dst, 40, 120);
+            break;
+        }
+        m_valid |= bit;
+    }
+    return m_edges[kind];
+}
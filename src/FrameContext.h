@@ -0,0 +1,44 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+// 单帧预处理缓存：灰度、BGR、HSV、红色掩膜与各类边缘图在首次请求时对整帧计算一次，
+// 之后各阶段（定位、细化、HUD、布局、识别）取其 ROI 视图共享。
+// 对象可跨帧复用：Reset 只使缓存失效，底层缓冲保留，尺寸不变时不再分配。
+// 非线程安全，由持有它的分析线程独占使用。
+class FrameContext {
+public:
+    enum EdgeKind {
+        kEdgesBlurred, // 3x3 高斯平滑后 Canny(50,150)，外框定位
+        kEdgesDefault, // Canny(50,150)，HUD 下沿/左右边界
+        kEdgesGrid,    // Canny(40,120)，网格周期
+        kEdgeKindCount
+    };
+
+    FrameContext() = default;
+    explicit FrameContext(const cv::Mat& frame) { Reset(frame); }
+
+    // 切换到新帧（BGRA/BGR/灰度）；frame 需在本帧处理期间保持有效
+    void Reset(const cv::Mat& frame);
+    // 跨帧复用的上下文把各级缓冲固定到 allocator（FrameArena::HeapAllocator()），不占帧内存；
+    // 逐格识别等临时上下文不设，缓冲随帧回收
+    void SetAllocator(cv::MatAllocator* allocator);
+
+    const cv::Mat& Frame() const { return m_frame; }
+    const cv::Mat& Gray();
+    const cv::Mat& Bgr();
+    const cv::Mat& Hsv();
+    // HSV 红色两段（0–10、160–180）合并后做 3x3 闭运算，聚合七段数码管笔画
+    const cv::Mat& RedMask();
+    const cv::Mat& Edges(EdgeKind kind);
+
+private:
+    enum : unsigned {
+        kHasGray = 1u << 0, kHasBgr = 1u << 1, kHasHsv = 1u << 2, kHasRed = 1u << 3,
+        kHasEdges0 = 1u << 4 // 其后 kEdgeKindCount 位
+    };
+
+    cv::Mat m_frame;
+    unsigned m_valid = 0;
+    cv::Mat m_gray, m_bgr, m_hsv, m_mask1, m_mask2, m_red, m_blur;
+    cv::Mat m_edges[kEdgeKindCount];
+};
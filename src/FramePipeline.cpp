@@ -0,0 +1,146 @@
+#include "FramePipeline.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+bool FramePipeline::Process(const cv::Mat& frame, GameState& state, cv::Rect& board) {
+    auto t0 = std::chrono::steady_clock::now();
+    bool ok;
+    {
+        FrameArena::Scope arena(m_arena);
+        ok = ProcessImpl(frame, state, board);
+    }
+    metrics::Record(metrics::Stage::FrameToDecision, std::chrono::steady_clock::now() - t0);
+    return ok;
+}
+
+bool FramePipeline::ProcessImpl(const cv::Mat& frame, GameState& state, cv::Rect& board) {
+    if (frame.empty()) return false;
+    m_ctx.Reset(frame);
+    const cv::Rect full(0, 0, frame.cols, frame.rows);
+    if (m_lockLayout && m_locked) {
+        // 沿用布局前先做网格线抽样校验，不符则本帧重新识别
+        bool verified;
+        {
+            STAGE_TIMER(LayoutVerify);
+            verified = LayoutCache::Verify(m_ctx.Gray(), cv::Point(0, 0), m_layout);
+        }
+        if (!verified) {
+            m_locked = false;
+            metrics::Add(metrics::Counter::LayoutInvalidations);
+        }
+    }
+    if (!(m_lockLayout && m_locked)) {
+        // 先做金字塔定位（一帧多块棋盘时按序号取），定位不到再退回整帧轮廓法
+        {
+            STAGE_TIMER(LocateBoards);
+            m_locator.LocateBoards(m_ctx, m_boards);
+        }
+        cv::Rect roi;
+        int rows = 0, cols = 0; cv::Rect inner;
+        bool laidOut = false, confirmed = false;
+        if (const BoardCandidate* picked = BoardLocator::PickBoard(m_boards, m_boardIndex)) {
+            roi = picked->rect & full;
+            if (roi.area() > 0) {
+                STAGE_TIMER(GridLayout);
+                laidOut = m_locator.AnalyzeGridLayoutEx(m_ctx, roi, rows, cols, inner);
+            }
+            // 行列与布局分析对不上（截断的棋盘）或格数过少时不采用，退回轮廓法
+            confirmed = laidOut && BoardLocator::ConfirmCandidate(*picked, rows, cols);
+        }
+        if (!confirmed) {
+            if (m_boardIndex > 0) return false;
+            cv::Rect region;
+            bool found;
+            {
+                STAGE_TIMER(IdentifyBounds);
+                found = m_locator.IdentifyGameBounds(m_ctx, region);
+            }
+            roi = found ? (region & full) : full;
+            if (roi.area() <= 0) roi = full;
+            cv::Rect gridRect;
+            bool refined;
+            {
+                STAGE_TIMER(RefineBoard);
+                refined = m_locator.RefineBoardArea(m_ctx, roi, gridRect);
+            }
+            if (refined) {
+                gridRect.x += roi.x;
+                gridRect.y += roi.y;
+                cv::Rect g = gridRect & full;
+                if (g.area() > 0) roi = g;
+            }
+            {
+                STAGE_TIMER(GridLayout);
+                laidOut = m_locator.AnalyzeGridLayoutEx(m_ctx, roi, rows, cols, inner);
+            }
+        }
+        if (laidOut && rows > 0 && cols > 0) {
+            inner.x += roi.x;
+            inner.y += roi.y;
+            cv::Rect in = inner & full;
+            if (in.area() > 0) roi = in;
+            m_rows = rows; m_cols = cols;
+            m_layout.clientSize = full.size();
+            m_layout.inner = roi;
+            m_layout.rows = rows; m_layout.cols = cols;
+            m_locked = true;
+            metrics::Add(metrics::Counter::LayoutDetections);
+        }
+        m_board = roi;
+    }
+    board = m_board;
+    state.rows = m_rows > 0 ? m_rows : 16;
+    state.cols = m_cols > 0 ? m_cols : 16;
+    if (state.mineCount <= 0) state.mineCount = 40;
+    bool recognized;
+    {
+        STAGE_TIMER(Recognize);
+        recognized = m_analyzer.AnalyzeGameState(m_ctx, m_board, state);
+    }
+    if (!recognized) return false;
+    {
+        STAGE_TIMER(Solve);
+        state.safeCells = m_analyzer.FindSafeMoves(state, &m_mines);
+    }
+    const bool unknownLeft = std::any_of(state.grid.begin(), state.grid.end(),
+        [](const std::vector<int>& row){ return std::find(row.begin(), row.end(), 9) != row.end(); });
+    metrics::CountSolveOutcome(state.safeCells.size(), m_mines.size(), unknownLeft);
+    return true;
+}
+
+void AppendJsonString(std::string& out, const std::string& s) {
+    out += '"';
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') { out += '\\'; out += char(c); }
+        else if (c < 0x20) { char buf[8]; std::snprintf(buf, sizeof(buf), "\\u%04x", c); out += buf; }
+        else out += char(c);
+    }
+    out += '"';
+}
+
+static char cellChar(int v) {
+    if (v >= 0 && v <= 8) return char('0' + v);
+    if (v == 9) return '.';
+    if (v == 10) return 'F';
+    if (v == -1) return '*';
+    return '?';
+}
+
+void AppendBoardJson(std::string& out, const GameState& state, const cv::Rect& board) {
+    char buf[128];
+    std::snprintf(buf, sizeof(buf), "\"board\":[%d,%d,%d,%d],\"rows\":%d,\"cols\":%d,\"explored\":%.1f,\"cells\":\"",
+                  board.x, board.y, board.width, board.height, state.rows, state.cols, state.exploredPercent);
+    out += buf;
+    for (int y = 0; y < state.rows && y < (int)state.grid.size(); ++y) {
+        if (y > 0) out += '/';
+        for (int v : state.grid[y]) out += cellChar(v);
+    }
+    out += "\",\"safe\":[";
+    for (size_t k = 0; k < state.safeCells.size(); ++k) {
+        if (k > 0) out += ',';
+        out += '[' + std::to_string(state.safeCells[k].y) + ',' + std::to_string(state.safeCells[k].x) + ']';
+    }
+    out += ']';
+}
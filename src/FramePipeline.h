@@ -0,0 +1,61 @@
+#pragma once
+#include "BoardLocator.h"
+#include "FrameArena.h"
+#include "FrameContext.h"
+#include "GameAnalyzer.h"
+#include "GameState.h"
+#include "LayoutCache.h"
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// 无界面的逐帧流水线：定位 → 细化 → 布局 → 识别 → 求解（与 GUI 分析任务的步骤一致）。
+// 每个实例只在一个线程上使用；GameAnalyzer 只读，可在多个实例间共享
+class FramePipeline {
+public:
+    // analyzer 跨输入共享，避免每张图重新加载模板
+    FramePipeline(GameAnalyzer& analyzer, bool lockLayout) : m_analyzer(analyzer), m_lockLayout(lockLayout) {
+        m_ctx.SetAllocator(FrameArena::HeapAllocator());
+    }
+
+    // 忘掉已识别的布局（换到不相关的下一张图），保留各级缓冲
+    void Reset() {
+        m_locked = false;
+        m_board = cv::Rect();
+        m_rows = m_cols = 0;
+    }
+
+    // 一帧里有多块棋盘时处理第 index 块（阅读顺序，见 BoardLocator::PickBoard），默认 0
+    void SetBoardIndex(int index) { m_boardIndex = std::max(0, index); Reset(); }
+    int BoardIndex() const { return m_boardIndex; }
+    // 最近一次定位找到的棋盘数（沿用布局的帧不更新）
+    int BoardsFound() const { return (int)m_boards.size(); }
+
+    // 返回是否识别成功；state 输出识别结果与安全格，board 为网格区域（帧坐标）
+    bool Process(const cv::Mat& frame, GameState& state, cv::Rect& board);
+    // 本流水线的帧内存（临时 Mat / STL 缓冲）用量
+    const FrameArena& Arena() const { return m_arena; }
+
+private:
+    bool ProcessImpl(const cv::Mat& frame, GameState& state, cv::Rect& board);
+
+    BoardLocator m_locator;
+    FrameArena m_arena; // 每次 Process 为一帧，结束时回绕
+    FrameContext m_ctx;
+    GameAnalyzer& m_analyzer;
+    bool m_lockLayout;
+    int m_boardIndex = 0;
+    bool m_locked = false;
+    BoardLayout m_layout;
+    cv::Rect m_board;
+    int m_rows = 0, m_cols = 0;
+    std::vector<BoardCandidate> m_boards; // 跨帧复用
+    std::vector<cv::Point> m_mines; // 求解推出的必雷格（只用于计数），跨帧复用
+};
+
+// 识别结果的紧凑 JSON（批处理记录与控制接口共用）
+void AppendJsonString(std::string& out, const std::string& s);
+// 追加 "board":[x,y,w,h],"rows","cols","explored","cells","safe" 字段（不含外层花括号与前导逗号）。
+// cells 每格一个字符：0–8 数字，. 未打开，F 旗子，* 地雷；行间以 / 分隔。safe 为 [行,列]
+void AppendBoardJson(std::string& out, const GameState& state, const cv::Rect& board);
@@ -1,26 +1,45 @@
 #include "GameAnalyzer.h"
+#include "FrameArena.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "ScratchPool.h"
 #include <iostream>
-#include <atomic>
 #include <filesystem>
+#include <memory_resource>
 
 using namespace cv;
 
+static const char* kTemplatePackPath = "resources/templates.mstpk";
+static const double kMatchThreshold = 0.60;
+
+enum ScratchSlot { kPackPatch };
+
+static ScratchPool& scratch() {
+    static thread_local ScratchPool pool;
+    return pool;
+}
+
 GameAnalyzer::GameAnalyzer() {
-    LoadTemplates();
+    // 优先映射预编译模板包：启动与布局变化时都无需解码、缩放
+    if (m_pack.Open(kTemplatePackPath)) {
+        LOGI("模板包 {}：{} 个模板，{} 种皮肤，{} KB", kTemplatePackPath, m_pack.TemplateCount(),
+             m_pack.Skins().size(), m_pack.SizeBytes() / 1024);
+    } else {
+        LoadTemplates();
+    }
 }
 
 static inline bool colorNear(const Vec3b& bgr, const Vec3b& target, int tol) {
     return std::abs(bgr[0]-target[0])<=tol && std::abs(bgr[1]-target[1])<=tol && std::abs(bgr[2]-target[2])<=tol;
 }
 
-static int recognizeSimple(const Mat& cell) {
+// cellBgr/cellGray 为同一格在帧级 BGR/灰度图中的视图
+static int recognizeSimple(const Mat& cellBgr, const Mat& cellGray) {
     // 去掉一圈边界，避免格线干扰
-    int inset = std::max(1, std::min(cell.cols, cell.rows) / 16);
-    Rect inner(inset, inset, std::max(1, cell.cols - 2*inset), std::max(1, cell.rows - 2*inset));
-    Mat roi = cell(inner);
-
-    Mat bgr; if (roi.channels()==4) cvtColor(roi, bgr, COLOR_BGRA2BGR); else bgr = roi;
-    Mat gray; cvtColor(bgr, gray, COLOR_BGR2GRAY);
+    int inset = std::max(1, std::min(cellBgr.cols, cellBgr.rows) / 16);
+    Rect inner(inset, inset, std::max(1, cellBgr.cols - 2*inset), std::max(1, cellBgr.rows - 2*inset));
+    Mat bgr = cellBgr(inner);
+    Mat gray = cellGray(inner);
 
     // 判空：低方差 + 非覆盖蓝灰调（非常粗略）
     Scalar mean, stddev; meanStdDev(gray, mean, stddev);
@@ -57,25 +76,198 @@ static int recognizeSimple(const Mat& cell) {
     return 9; // 未知
 }
 
+// 模板包匹配：按名义格子尺寸取居中内圈，与所选尺度的全部模板比对，得分不足时回退（byColour 置位）
+static int recognizePacked(const TemplatePack::Scale& scale, int cellSize, const Mat& cellBgr, const Mat& cellGray,
+                           bool& byColour) {
+    byColour = false;
+    const int inner = TemplatePack::InnerSize(cellSize);
+    if (cellGray.cols >= inner && cellGray.rows >= inner) {
+        Mat patch = cellGray(Rect((cellGray.cols - inner) / 2, (cellGray.rows - inner) / 2, inner, inner));
+        if (inner != scale.size) {
+            // 超出模板包的尺寸范围（少见）：把块缩放到最近尺度
+            Mat scaled = scratch().Take(kPackPatch, Size(scale.size, scale.size), CV_8UC1);
+            resize(patch, scaled, scaled.size(), 0, 0, INTER_AREA);
+            patch = scaled;
+        }
+        double score = -1.0;
+        int v = TemplatePack::Match(scale, patch, &score);
+        if (score >= kMatchThreshold) return v;
+    }
+    byColour = true;
+    return recognizeSimple(cellBgr, cellGray);
+}
+
+// 稀疏探针：每格只读内圈上 N×N 分层采样点（与 recognizeSimple 相同的内圈），用与其相同的
+// 方差/均值/主色规则给出结论。均匀分层使探针统计量近似整格统计量；点数与格子像素无关。
+// 两半探针（棋盘格交错）结论不一、或统计量贴近阈值时回退整格分析
+static const int kSparseMinCell = 24;   // 更小的格子整格分析本就便宜
+static const int kProbeEscalate = -100;
+static const int kSkinSampleCells = 24; // 每帧判断皮肤风格时抽查的格子数
+
+struct ProbeLayout {
+    int lattice;    // N×N
+    int plainStep;  // “内部平整”允许的相邻内点灰度差
+};
+// 经典灰色立体皮肤：像素字形笔画 1–2 px，立体边只占内圈约 7%，外圈点落在立体边上
+static const ProbeLayout kClassicProbes = { 12, 10 };
+// 扁平皮肤（Win7 / 网页版）：笔画粗、无立体边，较稀的点阵即可，平整判定容忍渐变底色
+static const ProbeLayout kFlatProbes = { 8, 14 };
+
+struct ProbeGrid {
+    int n = 0;
+    int plainStep = 0;
+    std::vector<Point> offsets; // 相对格子左上角，行优先
+};
+
+static void buildProbeGrid(const ProbeLayout& layout, int cellW, int cellH, ProbeGrid& grid) {
+    const int inset = std::max(1, std::min(cellW, cellH) / 16);
+    const int w = std::max(1, cellW - 2 * inset), h = std::max(1, cellH - 2 * inset);
+    grid.n = layout.lattice;
+    grid.plainStep = layout.plainStep;
+    grid.offsets.resize(size_t(grid.n) * grid.n);
+    for (int i = 0; i < grid.n; ++i)
+        for (int j = 0; j < grid.n; ++j)
+            grid.offsets[size_t(i) * grid.n + j] = Point(inset + int((j + 0.5) * w / grid.n),
+                                                         inset + int((i + 0.5) * h / grid.n));
+}
+
+// 立体边：外圈上、左两边明显亮于下、右两边（未打开格凸起）
+static bool hasRaisedBevel(const Mat& grayBoard, Point cell, const ProbeGrid& g) {
+    int tl = 0, br = 0, count = 0;
+    for (int k = 1; k < g.n - 1; ++k) {
+        auto at = [&](int i, int j) {
+            const Point p = cell + g.offsets[size_t(i) * g.n + j];
+            return int(grayBoard.ptr<uchar>(p.y)[p.x]);
+        };
+        tl += at(0, k) + at(k, 0);
+        br += at(g.n - 1, k) + at(k, g.n - 1);
+        count += 2;
+    }
+    return count > 0 && (tl - br) > 40 * count;
+}
+
+// 与 recognizeSimple 相同的主色规则
+static int colourRule(int blue, int green, int red, int total) {
+    if (total <= 0) return 9;
+    if (blue > total * 0.06) return 1;
+    if (green > total * 0.06) return 2;
+    if (red > total * 0.06) return 3;
+    return 9;
+}
+
+static bool nearColourThreshold(int count, int total) {
+    const double f = double(count) / total;
+    return f > 0.04 && f < 0.09;
+}
+
+// 返回格值，或 kProbeEscalate 表示需要整格分析。
+// colourDecides=false（有模板包，数字由模板判定）时只对平整格下结论
+static int classifyProbes(const Mat& bgrBoard, const Mat& grayBoard, Point cell, const ProbeGrid& g, bool colourDecides) {
+    const int n = g.n;
+    double sum = 0.0, sumSq = 0.0;
+    int blue[2] = {0, 0}, green[2] = {0, 0}, red[2] = {0, 0}, total[2] = {0, 0};
+    int interiorChroma = 0, maxStep = 0;
+    thread_local std::vector<int> grays;
+    grays.resize(size_t(n) * n);
+    for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < n; ++j) {
+            const Point p = cell + g.offsets[size_t(i) * n + j];
+            const int v = grayBoard.ptr<uchar>(p.y)[p.x];
+            grays[size_t(i) * n + j] = v;
+            sum += v;
+            sumSq += double(v) * v;
+            const Vec3b c = bgrBoard.ptr<Vec3b>(p.y)[p.x];
+            const int maxc = std::max({c[0], c[1], c[2]}), minc = std::min({c[0], c[1], c[2]});
+            if (maxc - minc < 40) continue;
+            const int half = (i + j) & 1;
+            if (c[0] > c[1] + 20 && c[0] > c[2] + 20) blue[half]++;
+            else if (c[1] > c[0] + 20 && c[1] > c[2] + 20) green[half]++;
+            else if (c[2] > c[0] + 20 && c[2] > c[1] + 20) red[half]++;
+            total[half]++;
+            if (i > 0 && j > 0 && i < n - 1 && j < n - 1) interiorChroma++;
+        }
+    }
+    // 内部（去掉外圈）相邻点的最大灰度跳变：笔画造成跳变，渐变底色不会
+    for (int i = 1; i < n - 1; ++i) {
+        for (int j = 1; j < n - 1; ++j) {
+            const int v = grays[size_t(i) * n + j];
+            if (j + 1 < n - 1) maxStep = std::max(maxStep, std::abs(v - grays[size_t(i) * n + j + 1]));
+            if (i + 1 < n - 1) maxStep = std::max(maxStep, std::abs(v - grays[size_t(i + 1) * n + j]));
+        }
+    }
+    const bool plain = interiorChroma == 0 && maxStep <= g.plainStep;
+
+    const double count = double(n) * n;
+    const double mean = sum / count;
+    const double var = sumSq / count - mean * mean;
+    // 判空与 recognizeSimple 相同：低方差且亮度不在覆盖色区间；贴近阈值的交给整格
+    if (var < 15.0) {
+        if (var > 8.0 || (!colourDecides && var >= 4.0)) return kProbeEscalate;
+        if (!(mean > 120 && mean < 200)) {
+            if (std::abs(mean - 120) < 6 || std::abs(mean - 200) < 6) return kProbeEscalate;
+            return 0;
+        }
+    } else if (var < 25.0) {
+        return kProbeEscalate;
+    }
+    const int allTotal = total[0] + total[1];
+    if (allTotal == 0) return plain ? 9 : kProbeEscalate;
+    if (!colourDecides || allTotal < 4) return kProbeEscalate;
+    const int allBlue = blue[0] + blue[1], allGreen = green[0] + green[1], allRed = red[0] + red[1];
+    if (nearColourThreshold(allBlue, allTotal) || nearColourThreshold(allGreen, allTotal) ||
+        nearColourThreshold(allRed, allTotal)) return kProbeEscalate;
+    const int v = colourRule(allBlue, allGreen, allRed, allTotal);
+    if (colourRule(blue[0], green[0], red[0], total[0]) != v ||
+        colourRule(blue[1], green[1], red[1], total[1]) != v) return kProbeEscalate;
+    return v;
+}
+
 bool GameAnalyzer::AnalyzeGameState(const cv::Mat& gameImage, GameState& state) {
-    if (gameImage.empty()) return false;
+    FrameContext ctx(gameImage);
+    return AnalyzeGameState(ctx, cv::Rect(0, 0, gameImage.cols, gameImage.rows), state);
+}
+
+bool GameAnalyzer::AnalyzeGameState(FrameContext& ctx, const cv::Rect& board, GameState& state) {
+    if (ctx.Frame().empty() || board.area() <= 0) return false;
+    // 整帧 BGR/灰度各转换一次（与定位阶段共享），逐格只取视图
+    const Mat bgrBoard = ctx.Bgr()(board);
+    const Mat grayBoard = ctx.Gray()(board);
 
     if (state.rows <= 0 || state.cols <= 0) {
         state.rows = 16;
         state.cols = 16;
         state.mineCount = 40;
     }
-    state.grid.assign(state.rows, std::vector<int>(state.cols, 9));
+    // 尺寸不变时复用已有行缓冲
+    state.grid.resize(state.rows);
+    for (auto& row : state.grid) row.assign(state.cols, 9);
     state.remainingMines = state.mineCount;
     state.exploredPercent = 0.0f;
     state.safeCells.clear();
     state.mineCells.clear();
+    state.ambiguous.assign(size_t(state.rows) * state.cols, 0);
 
     // 按均匀网格切分并识别
-    int W = gameImage.cols, H = gameImage.rows;
+    int W = board.width, H = board.height;
     int cellW = std::max(1, W / state.cols);
     int cellH = std::max(1, H / state.rows);
     int known = 0;
+    // 尺度每帧只选一次（布局变化即换到对应尺寸的模板，无需重新生成）
+    const int cellSize = std::min(cellW, cellH);
+    const TemplatePack::Scale* scale = m_pack.Nearest(cellSize);
+    // 稀疏探针：按抽查格子是否有凸起立体边选择点阵（经典灰色皮肤 / 扁平皮肤），每帧一次
+    const bool sparse = SparseProbes() && cellSize >= kSparseMinCell;
+    thread_local ProbeGrid probes;
+    uint64_t probed = 0, escalated = 0;
+    if (sparse) {
+        buildProbeGrid(kClassicProbes, cellW, cellH, probes);
+        const int cells = state.rows * state.cols;
+        const int step = std::max(1, cells / kSkinSampleCells);
+        int sampled = 0, raised = 0;
+        for (int i = 0; i < cells; i += step, ++sampled)
+            if (hasRaisedBevel(grayBoard, Point((i % state.cols) * cellW, (i / state.cols) * cellH), probes)) raised++;
+        if (raised * 7 < sampled) buildProbeGrid(kFlatProbes, cellW, cellH, probes);
+    }
     for (int r=0;r<state.rows;++r){
         for (int c=0;c<state.cols;++c){
             int x = c*cellW;
@@ -83,69 +275,102 @@ bool GameAnalyzer::AnalyzeGameState(const cv::Mat& gameImage, GameState& state)
             Rect rc(x, y, (c==state.cols-1? W-x : cellW), (r==state.rows-1? H-y : cellH));
             rc &= Rect(0,0,W,H);
             if (rc.width<=0 || rc.height<=0) { state.grid[r][c]=9; continue; }
-            int v = recognizeSimple(gameImage(rc));
+            int v = kProbeEscalate;
+            // 无模板包时探针与整格分析都只按主色给数字
+            bool byColour = scale == nullptr;
+            if (sparse && rc.width >= cellW && rc.height >= cellH) {
+                v = classifyProbes(bgrBoard, grayBoard, rc.tl(), probes, scale == nullptr);
+                if (v == kProbeEscalate) escalated++;
+                else probed++;
+            }
+            if (v == kProbeEscalate)
+                v = scale ? recognizePacked(*scale, cellSize, bgrBoard(rc), grayBoard(rc), byColour)
+                          : recognizeSimple(bgrBoard(rc), grayBoard(rc));
             state.grid[r][c] = v;
+            if (byColour && v >= 1 && v <= 8) state.ambiguous[size_t(r) * state.cols + c] = 1;
             if (v!=9) known++;
         }
     }
     state.exploredPercent = 100.f * known / float(state.rows*state.cols);
+    if (probed) metrics::Add(metrics::Counter::CellsProbed, probed);
+    if (escalated) metrics::Add(metrics::Counter::CellsEscalated, escalated);
     return true;
 }
 
-std::vector<cv::Point> GameAnalyzer::FindSafeMoves(const GameState& state) {
-    // 占位：寻找所有已知为 0 的周围未知格，作为安全推荐
+std::vector<cv::Point> GameAnalyzer::FindSafeMoves(const GameState& state, std::vector<cv::Point>* mineCells) {
+    // 单点推理，反复执行到不再有新结论：数字 n 周围 雷/旗/已推出的雷 共 m 个、仍未知的格子 u 个，
+    //   n == m     → 这些未知格都安全；
+    //   n == m + u → 这些未知格都是雷（只用于后续推理）。
+    // 待定格（11）既不算未知也不算雷，推理可以越过尚未在画面中翻开的格子继续展开。
+    // 认错一个数字就会把雷判成安全并被自动点击：识别器分不清 1–8 时只用 0 格，分得清时也跳过只按主色判定的格子
+    enum : uint8_t { kUnknown, kSafe, kMine, kKnown };
     std::vector<cv::Point> out;
-    auto inside = [&](int r, int c){ return r>=0 && r<state.rows && c>=0 && c<state.cols; };
-    for (int r=0;r<state.rows;++r){
-        for (int c=0;c<state.cols;++c){
-            if (state.grid[r][c] == 0){
+    if (mineCells) mineCells->clear();
+    const int rows = std::min(state.rows, (int)state.grid.size());
+    const int cols = state.cols;
+    if (rows <= 0 || cols <= 0) return out;
+    auto inside = [&](int r, int c){ return r>=0 && r<rows && c>=0 && c<cols && c < (int)state.grid[r].size(); };
+    const bool allDigits = ResolvesAllDigits();
+    const bool flagged = state.ambiguous.size() == size_t(state.rows) * cols;
+    auto usable = [&](int r, int c, int n) {
+        if (n < 0 || n > 8) return false;
+        if (!allDigits) return n == 0;
+        return !(flagged && state.ambiguous[size_t(r) * cols + c]);
+    };
+    std::pmr::vector<uint8_t> mark(size_t(rows) * cols, kKnown, FrameArena::Resource());
+    for (int r=0;r<rows;++r)
+        for (int c=0;c<cols && c<(int)state.grid[r].size();++c)
+            if (state.grid[r][c] == 9) mark[size_t(r)*cols + c] = kUnknown;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int r=0;r<rows;++r){
+            for (int c=0;c<cols && c<(int)state.grid[r].size();++c){
+                int n = state.grid[r][c];
+                if (!usable(r, c, n)) continue;
+                int mines = 0, unknown = 0;
+                for (int dr=-1; dr<=1; ++dr){
+                    for (int dc=-1; dc<=1; ++dc){
+                        int nr=r+dr, nc=c+dc;
+                        if ((dr==0 && dc==0) || !inside(nr,nc)) continue;
+                        int v = state.grid[nr][nc];
+                        uint8_t m = mark[size_t(nr)*cols + nc];
+                        if (v == -1 || v == 10 || m == kMine) mines++;
+                        else if (m == kUnknown) unknown++;
+                    }
+                }
+                if (unknown == 0) continue;
+                uint8_t verdict;
+                if (n == mines) verdict = kSafe;
+                else if (n == mines + unknown) verdict = kMine;
+                else continue;
                 for (int dr=-1; dr<=1; ++dr){
                     for (int dc=-1; dc<=1; ++dc){
-                        if (dr==0 && dc==0) continue;
                         int nr=r+dr, nc=c+dc;
-                        if (inside(nr,nc) && state.grid[nr][nc]==9) out.emplace_back(nc,nr);
+                        if ((dr==0 && dc==0) || !inside(nr,nc)) continue;
+                        uint8_t& m = mark[size_t(nr)*cols + nc];
+                        if (m != kUnknown) continue;
+                        m = verdict;
+                        if (verdict == kSafe) out.emplace_back(nc,nr);
+                        else if (mineCells) mineCells->emplace_back(nc,nr);
                     }
                 }
+                changed = true;
             }
         }
     }
     return out;
 }
 
-extern std::atomic<bool> g_enableMouseMove;
-extern std::atomic<bool> g_enableAutoClick;
-
-void GameAnalyzer::PerformClick(HWND hwnd, int x, int y, bool rightClick) {
-    if (!hwnd) return;
-    if (!g_enableMouseMove.load()) return; // 用户关闭时不控制鼠标
-    // 将客户区坐标转换为屏幕坐标并模拟点击
-    POINT pt{ x, y };
-    ClientToScreen(hwnd, &pt);
-
-    INPUT inputMove{};
-    inputMove.type = INPUT_MOUSE;
-    inputMove.mi.dx = LONG(pt.x * (65535.0 / GetSystemMetrics(SM_CXSCREEN)));
-    inputMove.mi.dy = LONG(pt.y * (65535.0 / GetSystemMetrics(SM_CYSCREEN)));
-    inputMove.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
-
-    SendInput(1, &inputMove, sizeof(INPUT));
-    if (!g_enableAutoClick.load()) return; // 未开启自动点击则只移动
-
-    INPUT clickDown{}; clickDown.type = INPUT_MOUSE;
-    INPUT clickUp{};   clickUp.type   = INPUT_MOUSE;
-    if (rightClick) {
-        clickDown.mi.dwFlags = MOUSEEVENTF_RIGHTDOWN;
-        clickUp.mi.dwFlags   = MOUSEEVENTF_RIGHTUP;
-    } else {
-        clickDown.mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
-        clickUp.mi.dwFlags   = MOUSEEVENTF_LEFTUP;
-    }
-    SendInput(1, &clickDown, sizeof(INPUT));
-    SendInput(1, &clickUp, sizeof(INPUT));
-}
-
 int GameAnalyzer::RecognizeCell(const cv::Mat& cellImage) {
-    // 先尝试模板匹配（若已加载）
+    if (m_pack.IsOpen()) {
+        FrameContext ctx(cellImage);
+        const int cellSize = std::min(cellImage.cols, cellImage.rows);
+        bool byColour = false;
+        return recognizePacked(*m_pack.Nearest(cellSize), cellSize, ctx.Bgr(), ctx.Gray(), byColour);
+    }
+    // 先尝试模板匹配（若已加载源模板）
     int bestDigit = -1; double bestScore = -1.0;
     if (!m_numberTemplates.empty()) {
         // 内圈裁剪，减少格线影响
@@ -169,10 +394,11 @@ int GameAnalyzer::RecognizeCell(const cv::Mat& cellImage) {
             }
         }
         // 阈值判定
-        if (bestScore >= 0.60) return bestDigit;
+        if (bestScore >= kMatchThreshold) return bestDigit;
     }
     // 回退简单颜色/方差法
-    return recognizeSimple(cellImage);
+    FrameContext ctx(cellImage);
+    return recognizeSimple(ctx.Bgr(), ctx.Gray());
 }
 
 void GameAnalyzer::LoadTemplates() {
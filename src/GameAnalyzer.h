@@ -1,26 +1,42 @@
 #ifndef GAME_ANALYZER_H
 #define GAME_ANALYZER_H
 
-#include <windows.h>
 #include <opencv2/opencv.hpp>
+#include <atomic>
 #include <vector>
 #include "GameState.h"
+#include "FrameContext.h"
+#include "TemplatePack.h"
 
 class GameAnalyzer {
 public:
     GameAnalyzer();
 
     bool AnalyzeGameState(const cv::Mat& gameImage, GameState& state);
-    std::vector<cv::Point> FindSafeMoves(const GameState& state);
-    void PerformClick(HWND hwnd, int x, int y, bool rightClick = false);
+    // board 为 ctx 帧内的网格区域；共享帧级 BGR/灰度转换
+    bool AnalyzeGameState(FrameContext& ctx, const cv::Rect& board, GameState& state);
+    // mineCells 非空时输出本次推出的必雷格。
+    // 只有识别器分得清全部数字（已映射模板包）时才按数字做完整推理，且跳过 ambiguous 格；
+    // 否则只把 0 格周围的未知格判为安全
+    std::vector<cv::Point> FindSafeMoves(const GameState& state, std::vector<cv::Point>* mineCells = nullptr);
     
     // 公用：数字识别（模板匹配优先，失败回退）
     int RecognizeCell(const cv::Mat& cellImage);
+    // 是否已映射预编译模板包（resources/templates.mstpk）
+    bool HasTemplatePack() const { return m_pack.IsOpen(); }
+    // 识别结果能否区分 1–8：主色回退只给出 1/2/3
+    bool ResolvesAllDigits() const { return m_pack.IsOpen(); }
+    // 稀疏探针（默认开启）：大格子只读每格固定的一组点，探针结论不一时才整格分析
+    void SetSparseProbes(bool on) { m_sparseProbes.store(on, std::memory_order_relaxed); }
+    bool SparseProbes() const { return m_sparseProbes.load(std::memory_order_relaxed); }
 
 private:
     void LoadTemplates();
 
+    // 预编译模板包，只读，供各分析线程共享；缺失时回退到逐个加载的源模板
+    TemplatePack m_pack;
     std::vector<cv::Mat> m_numberTemplates;
+    std::atomic<bool> m_sparseProbes{true};
 };
 
 #endif
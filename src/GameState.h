@@ -1,13 +1,17 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <opencv2/core.hpp>
 
-// -1: 地雷, 0-8: 数字, 9: 未打开, 10: 旗子
+// -1: 地雷, 0-8: 数字, 9: 未打开, 10: 旗子, 11: 待定（已判安全并派发点击，画面尚未更新）
 struct GameState {
     int rows = 0;
     int cols = 0;
     int mineCount = 0;
     std::vector<std::vector<int>> grid;
+    // 行优先 rows×cols；1 表示该格数字只按主色判定（配色只分得出 1/2/3，4–8 与旗子会被认成其中之一），
+    // 求解时不作约束
+    std::vector<uint8_t> ambiguous;
     int remainingMines = 0;
     float exploredPercent = 0.0f;
     std::vector<cv::Point> safeCells;  // 建议的安全格
@@ -0,0 +1,194 @@
+#include "InputExecutor.h"
+#include "Metrics.h"
+#include <algorithm>
+
+static const int kSettleMs = 100;   // 点击后至少这么久的画面才用于核对
+static const int kMaxAttempts = 2;  // 含首次派发；仍未生效则取消
+
+// 左键期望翻开（不再是未打开/旗子），右键期望出现旗子
+static bool actionTookEffect(int v, bool rightClick) {
+    return rightClick ? v == 10 : (v != 9 && v != 10);
+}
+
+InputExecutor::InputExecutor(InputSink& sink, size_t capacity, std::mutex* dispatchLock)
+    : m_sink(sink), m_capacity(std::max<size_t>(1, capacity)), m_dispatchLock(dispatchLock) {}
+
+InputExecutor::~InputExecutor() {
+    Stop();
+}
+
+void InputExecutor::Start() {
+    if (m_thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = false;
+    }
+    m_thread = std::thread(&InputExecutor::Run, this);
+}
+
+void InputExecutor::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void InputExecutor::SetPacing(const InputPacing& pacing) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pacing = pacing;
+}
+
+void InputExecutor::SetOnDispatch(std::function<void()> cb) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_onDispatch = std::move(cb);
+}
+
+bool InputExecutor::Contains(const std::deque<Action>& list, const cv::Point& cell) const {
+    return std::any_of(list.begin(), list.end(), [&](const Action& a){ return a.cell == cell; });
+}
+
+void InputExecutor::Submit(const cv::Rect& board, int rows, int cols, const std::vector<cv::Point>& cells,
+                           bool rightClick, uint64_t flowId) {
+    if (rows <= 0 || cols <= 0 || board.area() <= 0) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (board != m_board || rows != m_rows || cols != m_cols) {
+            // 盘面几何变化：旧动作的坐标已失效
+            CancelAll();
+            m_board = board; m_rows = rows; m_cols = cols;
+        }
+        // 新一轮结果替换旧队列；只保留待重试的动作（排在最前）
+        std::deque<Action> next;
+        for (const Action& a : m_queue) if (a.attempts > 0) next.push_back(a);
+        for (const cv::Point& cell : cells) {
+            if (cell.x < 0 || cell.y < 0 || cell.x >= cols || cell.y >= rows) continue;
+            if (Contains(next, cell) || Contains(m_inflight, cell)) continue;
+            if (next.size() >= m_capacity) { m_stats.dropped++; continue; }
+            Action a;
+            a.cell = cell;
+            a.rightClick = rightClick;
+            a.flow = flowId;
+            next.push_back(a);
+        }
+        m_queue.swap(next);
+    }
+    m_cv.notify_one();
+}
+
+void InputExecutor::OnState(const GameState& state, Clock::time_point capturedAt) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_queue.empty() && m_inflight.empty()) return;
+    bool gameOver = false;
+    for (const auto& row : state.grid)
+        if (std::find(row.begin(), row.end(), -1) != row.end()) { gameOver = true; break; }
+    if (state.rows != m_rows || state.cols != m_cols || (int)state.grid.size() != state.rows || gameOver) {
+        CancelAll();
+        return;
+    }
+    auto cellValue = [&](const cv::Point& c) { return state.grid[c.y][c.x]; };
+    // 排队中的动作若格子已被其它操作翻开（如连锁展开），直接作废
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(),
+                                 [&](const Action& a){ return actionTookEffect(cellValue(a.cell), a.rightClick); }),
+                  m_queue.end());
+    for (auto it = m_inflight.begin(); it != m_inflight.end(); ) {
+        if (actionTookEffect(cellValue(it->cell), it->rightClick)) {
+            m_stats.confirmed++;
+            metrics::Add(metrics::Counter::ClicksVerified);
+            it = m_inflight.erase(it);
+            continue;
+        }
+        if (capturedAt < it->dispatchedAt + std::chrono::milliseconds(kSettleMs)) { ++it; continue; }
+        // 点击之后的画面仍未生效：重试或放弃
+        if (it->attempts < kMaxAttempts && !Contains(m_queue, it->cell)) {
+            m_stats.retried++;
+            metrics::Add(metrics::Counter::ClicksRetried);
+            m_queue.push_front(*it);
+        } else {
+            m_stats.cancelled++;
+            metrics::Add(metrics::Counter::ClicksCancelled);
+        }
+        it = m_inflight.erase(it);
+    }
+    if (!m_queue.empty()) m_cv.notify_one();
+}
+
+void InputExecutor::CancelAll() {
+    const size_t n = m_queue.size() + m_inflight.size();
+    m_stats.cancelled += n;
+    if (n > 0) metrics::Add(metrics::Counter::ClicksCancelled, n);
+    m_queue.clear();
+    m_inflight.clear();
+    m_epoch++;
+}
+
+void InputExecutor::Clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CancelAll();
+}
+
+InputExecutor::Stats InputExecutor::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+size_t InputExecutor::Outstanding() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.size() + m_inflight.size();
+}
+
+cv::Point InputExecutor::PixelFor(const Action& a) {
+    double cw = double(m_board.width) / m_cols;
+    double ch = double(m_board.height) / m_rows;
+    int x0 = int(a.cell.x * cw), x1 = int((a.cell.x + 1) * cw) - 1;
+    int y0 = int(a.cell.y * ch), y1 = int((a.cell.y + 1) * ch) - 1;
+    int x = int((a.cell.x + 0.5) * cw), y = int((a.cell.y + 0.5) * ch);
+    int posJ = std::max(0, m_pacing.posJitterPx);
+    if (posJ > 0) {
+        std::uniform_int_distribution<int> jp(-posJ, posJ);
+        x = std::clamp(x + jp(m_rng), std::min(x0 + 1, x1), std::max(x0 + 1, x1 - 1));
+        y = std::clamp(y + jp(m_rng), std::min(y0 + 1, y1), std::max(y0 + 1, y1 - 1));
+    }
+    return cv::Point(m_board.x + x, m_board.y + y);
+}
+
+void InputExecutor::Run() {
+    trace::SetThreadName("input");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        if (m_queue.empty()) { m_cv.wait(lock); continue; }
+        if (Clock::now() < m_nextAllowed) { m_cv.wait_until(lock, m_nextAllowed); continue; }
+
+        Action a = m_queue.front();
+        m_queue.pop_front();
+        const cv::Point px = PixelFor(a);
+        const uint64_t epoch = m_epoch;
+        auto onDispatch = m_onDispatch;
+        lock.unlock();
+        {
+            std::unique_lock<std::mutex> serial;
+            if (m_dispatchLock) {
+                // 其它目标正在点击时在此等待，时间线上显示为 click_wait
+                TRACE_SPAN("click_wait");
+                serial = std::unique_lock<std::mutex>(*m_dispatchLock);
+            }
+            STAGE_TIMER(Click);
+            TRACE_FLOW('t', a.flow);
+            m_sink.Click(px.x, px.y, a.rightClick);
+        }
+        if (onDispatch) onDispatch();
+        lock.lock();
+
+        a.dispatchedAt = Clock::now();
+        a.attempts++;
+        m_stats.dispatched++;
+        metrics::Add(metrics::Counter::ClicksIssued);
+        // 派发期间盘面已切换或被清空的动作不再核对
+        if (epoch == m_epoch) m_inflight.push_back(a);
+        int jitter = std::max(0, m_pacing.randomMs);
+        int eff = std::max(0, m_pacing.intervalMs);
+        if (jitter > 0) eff = std::max(0, eff + std::uniform_int_distribution<int>(-jitter, jitter)(m_rng));
+        m_nextAllowed = a.dispatchedAt + std::chrono::milliseconds(eff);
+    }
+}
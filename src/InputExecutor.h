@@ -0,0 +1,97 @@
+#pragma once
+#include "InputSink.h"
+#include "GameState.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// 点击节奏：基础间隔 ± 随机抖动，落点在格心 ± 坐标抖动（不越出本格）
+struct InputPacing {
+    int intervalMs = 200;
+    int randomMs = 50;
+    int posJitterPx = 1;
+};
+
+// 异步输入执行器：独立线程按节奏从有界队列派发点击，分析线程只负责提交与核对。
+//   Submit  —— 用最新一轮求解结果替换尚未派发的动作（已派发待核对的格子不重复提交）
+//   OnState —— 每识别出一帧调用：已派发动作对应格子已翻开/插旗即确认；
+//              点击后稳定时间之后的画面仍未变化则重试，超过次数或盘面几何变化则取消
+// 只依赖 InputSink，可配合 MockInputSink 在无桌面环境运行
+class InputExecutor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // dispatchLock：多个执行器共享同一鼠标时传入同一把锁，保证各目标的点击序列互不穿插
+    explicit InputExecutor(InputSink& sink, size_t capacity = 64, std::mutex* dispatchLock = nullptr);
+    ~InputExecutor();
+
+    void Start();
+    void Stop();
+
+    void SetPacing(const InputPacing& pacing);
+    // 每次派发后在执行线程回调（用于标记最近点击时间等）
+    void SetOnDispatch(std::function<void()> cb);
+
+    // board 为识别用网格区域（客户区坐标）；cells 为 (列, 行)；
+    // flowId 为产生这些动作的帧在时间线中的流 id（见 Trace.h），派发时连到对应点击
+    void Submit(const cv::Rect& board, int rows, int cols, const std::vector<cv::Point>& cells,
+                bool rightClick = false, uint64_t flowId = 0);
+    // capturedAt 为该状态对应画面的捕获时间，早于点击生效的画面不参与核对
+    void OnState(const GameState& state, Clock::time_point capturedAt);
+    // 清空队列与待核对动作（自动点击关闭、窗口切换时）
+    void Clear();
+
+    struct Stats {
+        uint64_t dispatched = 0;
+        uint64_t confirmed = 0;
+        uint64_t retried = 0;
+        uint64_t cancelled = 0;
+        uint64_t dropped = 0;   // 队列满被丢弃
+    };
+    Stats GetStats() const;
+    // 排队 + 待核对的动作数
+    size_t Outstanding() const;
+
+private:
+    struct Action {
+        cv::Point cell;
+        bool rightClick = false;
+        int attempts = 0;
+        uint64_t flow = 0;
+        Clock::time_point dispatchedAt;
+    };
+
+    void Run();
+    // 作废全部排队与待核对的动作（调用方持有 m_mutex）
+    void CancelAll();
+    bool Contains(const std::deque<Action>& list, const cv::Point& cell) const;
+    cv::Point PixelFor(const Action& a);
+
+    InputSink& m_sink;
+    const size_t m_capacity;
+    std::mutex* m_dispatchLock;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Action> m_queue;     // 待派发
+    std::deque<Action> m_inflight;  // 已派发、待画面确认
+    cv::Rect m_board;
+    int m_rows = 0, m_cols = 0;
+    InputPacing m_pacing;
+    Clock::time_point m_nextAllowed;
+    std::function<void()> m_onDispatch;
+    Stats m_stats;
+    uint64_t m_epoch = 0;           // 清空/几何变化时递增，派发中的动作据此判断是否还需核对
+    bool m_stop = false;
+
+    std::thread m_thread;
+    std::mt19937 m_rng{ std::random_device{}() }; // 仅执行线程使用
+};
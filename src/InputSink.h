@@ -0,0 +1,9 @@
+#pragma once
+
+// 点击输出接口：坐标为游戏客户区坐标，由平台实现负责换算与注入。
+// 核心库只依赖此接口；Win32 实现见 Win32InputSink，无界面模式可不注入或自行记录
+class InputSink {
+public:
+    virtual ~InputSink() = default;
+    virtual void Click(int x, int y, bool rightClick = false) = 0;
+};
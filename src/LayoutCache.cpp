@@ -0,0 +1,156 @@
+#include "LayoutCache.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+static const int kMaxSampledLines = 8;     // 每个方向最多采样的网格线数
+static const int kSamplesPerLine = 8;      // 每条线的采样点数（取格子中段）
+static const int kEdgeThreshold = 12;      // 相邻像素灰度差阈值
+static const double kMinLineHitRatio = 0.6;
+static const double kMinContrast = 0.25;   // 网格线命中率需高出对照采样的幅度
+
+LayoutCache::LayoutCache(fs::path file) : m_file(std::move(file)) {
+    Load();
+}
+
+bool LayoutCache::Find(const std::string& key, const cv::Size& clientSize, BoardLayout& out) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return false;
+    for (const BoardLayout& l : it->second) {
+        if (l.clientSize == clientSize && l.Valid()) { out = l; return true; }
+    }
+    return false;
+}
+
+void LayoutCache::Store(const std::string& key, const BoardLayout& layout) {
+    if (key.empty() || !layout.Valid()) return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& list = m_entries[key];
+    auto it = std::find_if(list.begin(), list.end(),
+                           [&](const BoardLayout& l){ return l.clientSize == layout.clientSize; });
+    if (it != list.end()) *it = layout;
+    else list.push_back(layout);
+    Save();
+}
+
+void LayoutCache::Invalidate(const std::string& key, const cv::Size& clientSize) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return;
+    auto& list = it->second;
+    size_t before = list.size();
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [&](const BoardLayout& l){ return l.clientSize == clientSize; }), list.end());
+    if (list.size() != before) Save();
+}
+
+// 在 (x, y) 附近 ±2 像素内沿 dx/dy 方向找最大相邻差
+static bool edgeNear(const cv::Mat& gray, int x, int y, int dx, int dy) {
+    int best = 0;
+    for (int d = -2; d <= 1; ++d) {
+        int x0 = x + d * dx, y0 = y + d * dy;
+        int x1 = x0 + dx, y1 = y0 + dy;
+        if (x0 < 0 || y0 < 0 || x1 >= gray.cols || y1 >= gray.rows) return false;
+        best = std::max(best, std::abs(int(gray.at<uchar>(y1, x1)) - int(gray.at<uchar>(y0, x0))));
+    }
+    return best >= kEdgeThreshold;
+}
+
+bool LayoutCache::Verify(const cv::Mat& gray, const cv::Point& frameOrigin, const BoardLayout& layout) {
+    if (gray.empty() || gray.type() != CV_8UC1 || !layout.Valid()) return false;
+    cv::Rect inner(layout.inner.x - frameOrigin.x, layout.inner.y - frameOrigin.y,
+                   layout.inner.width, layout.inner.height);
+    if ((inner & cv::Rect(0, 0, gray.cols, gray.rows)) != inner) return false;
+    const double cw = layout.CellWidth(), ch = layout.CellHeight();
+    if (cw < 4.0 || ch < 4.0) return false;
+
+    int hits = 0, control = 0, total = 0;
+    // vertical=true：竖线（沿 x 方向求差），沿 y 方向在格子中段采样
+    auto sampleLines = [&](bool vertical) {
+        int lines = vertical ? layout.cols - 1 : layout.rows - 1;
+        int along = vertical ? layout.rows : layout.cols;
+        if (lines <= 0) return;
+        int nLines = std::min(lines, kMaxSampledLines);
+        int nSamples = std::min(along, kSamplesPerLine);
+        for (int i = 0; i < nLines; ++i) {
+            int k = 1 + (lines * i) / nLines;                 // 第 k 条内部网格线
+            for (int j = 0; j < nSamples; ++j) {
+                int cell = (along * j) / nSamples;             // 采样所在的格子
+                if (vertical) {
+                    int x = inner.x + int(std::lround(k * cw));
+                    int y = inner.y + int(std::lround((cell + 0.5) * ch));
+                    hits += edgeNear(gray, x, y, 1, 0);
+                    control += edgeNear(gray, x + int(std::lround(cw / 4)), y, 1, 0);
+                } else {
+                    int y = inner.y + int(std::lround(k * ch));
+                    int x = inner.x + int(std::lround((cell + 0.5) * cw));
+                    hits += edgeNear(gray, x, y, 0, 1);
+                    control += edgeNear(gray, x, y + int(std::lround(ch / 4)), 0, 1);
+                }
+                total++;
+            }
+        }
+    };
+    sampleLines(true);
+    sampleLines(false);
+    if (total == 0) return false;
+    double hitRatio = double(hits) / total;
+    double controlRatio = double(control) / total;
+    return hitRatio >= kMinLineHitRatio && hitRatio >= controlRatio + kMinContrast;
+}
+
+// 文件格式：每行一个布局，制表符分隔
+//   key \t clientW clientH \t region(x y w h) \t gridRect(x y w h) \t inner(x y w h) \t rows cols
+static std::string sanitizeKey(std::string key) {
+    for (char& c : key) if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+    return key;
+}
+
+static std::ostream& operator<<(std::ostream& os, const cv::Rect& r) {
+    return os << r.x << ' ' << r.y << ' ' << r.width << ' ' << r.height;
+}
+
+static std::istream& operator>>(std::istream& is, cv::Rect& r) {
+    return is >> r.x >> r.y >> r.width >> r.height;
+}
+
+void LayoutCache::Load() {
+    m_entries.clear();
+    std::ifstream ifs(m_file);
+    if (!ifs) return;
+    std::string line;
+    while (std::getline(ifs, line)) {
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) continue;
+        std::string key = line.substr(0, tab);
+        std::istringstream is(line.substr(tab + 1));
+        BoardLayout l;
+        if (!(is >> l.clientSize.width >> l.clientSize.height >> l.region >> l.gridRect >> l.inner >> l.rows >> l.cols))
+            continue;
+        if (l.Valid()) m_entries[key].push_back(l);
+    }
+}
+
+void LayoutCache::Save() const {
+    std::error_code ec;
+    if (m_file.has_parent_path()) fs::create_directories(m_file.parent_path(), ec);
+    fs::path tmp = m_file; tmp += ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::trunc);
+        if (!ofs) { LOGE("无法写入布局缓存: " + tmp.string()); return; }
+        for (const auto& kv : m_entries) {
+            for (const BoardLayout& l : kv.second) {
+                ofs << sanitizeKey(kv.first) << '\t' << l.clientSize.width << ' ' << l.clientSize.height << '\t'
+                    << l.region << '\t' << l.gridRect << '\t' << l.inner << '\t' << l.rows << ' ' << l.cols << '\n';
+            }
+        }
+    }
+    // 先写临时文件再替换，避免中途退出留下半截文件
+    fs::rename(tmp, m_file, ec);
+    if (ec) LOGE("替换布局缓存失败: " + ec.message());
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 已锁定的棋盘布局（客户区坐标）
+struct BoardLayout {
+    cv::Size clientSize;  // 布局对应的客户区尺寸（缓存键之一）
+    cv::Rect region;      // 棋盘外框（含 HUD），捕获 ROI 以此为基准
+    cv::Rect gridRect;    // 剔除 HUD 后的棋盘区域
+    cv::Rect inner;       // 对齐到格子边界的纯网格区域
+    int rows = 0, cols = 0;
+
+    bool Valid() const { return rows > 0 && cols > 0 && inner.area() > 0; }
+    double CellWidth() const { return cols > 0 ? double(inner.width) / cols : 0.0; }
+    double CellHeight() const { return rows > 0 ? double(inner.height) / rows : 0.0; }
+};
+
+// 布局缓存：按 窗口键（UTF-8 的类名 + 标题）与客户区尺寸保存布局，逐帧用少量网格线采样校验，
+// 仅校验失败时才需要重新识别。内容持久化为文本文件，重启后首帧即可锁定布局。
+// 多个目标流水线共享同一实例，内部加锁
+class LayoutCache {
+public:
+    explicit LayoutCache(std::filesystem::path file);
+
+    bool Find(const std::string& key, const cv::Size& clientSize, BoardLayout& out) const;
+    // 写入/替换该窗口在该客户区尺寸下的布局并落盘
+    void Store(const std::string& key, const BoardLayout& layout);
+    void Invalidate(const std::string& key, const cv::Size& clientSize);
+
+    // 校验：gray 为帧灰度图，frameOrigin 为该帧在客户区中的左上角。
+    // 在若干条预期网格线上采样相邻像素差，并与格内 1/4 处的对照采样比较
+    static bool Verify(const cv::Mat& gray, const cv::Point& frameOrigin, const BoardLayout& layout);
+
+private:
+    void Load();
+    void Save() const; // 调用方持有 m_mutex
+
+    std::filesystem::path m_file;
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::vector<BoardLayout>> m_entries;
+};
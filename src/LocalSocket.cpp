@@ -0,0 +1,115 @@
+#include "LocalSocket.h"
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+#include <mutex>
+
+namespace localsock {
+
+#ifdef _WIN32
+using Native = SOCKET;
+static const int kSendFlags = 0;
+static std::mutex g_wsaMutex;
+static int g_wsaRefs = 0;
+#else
+using Native = int;
+static const int kSendFlags = MSG_NOSIGNAL; // 对端提前断开时不触发 SIGPIPE
+#endif
+
+static Native native(Handle s) { return Native(s); }
+
+bool Startup() {
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(g_wsaMutex);
+    if (g_wsaRefs == 0) {
+        WSADATA wsa;
+        if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+    }
+    g_wsaRefs++;
+#endif
+    return true;
+}
+
+void Cleanup() {
+#ifdef _WIN32
+    std::lock_guard<std::mutex> lock(g_wsaMutex);
+    if (g_wsaRefs > 0 && --g_wsaRefs == 0) WSACleanup();
+#endif
+}
+
+Handle Listen(uint16_t port, int backlog) {
+    Native s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (Handle(s) == kInvalid) return kInvalid;
+    int yes = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 只接受本机连接
+    if (::bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(s, backlog) != 0) {
+        Close(Handle(s));
+        return kInvalid;
+    }
+    return Handle(s);
+}
+
+Handle Accept(Handle listener, int timeoutMs) {
+    const Native l = native(listener);
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(l, &readable);
+    timeval tv{ timeoutMs / 1000, (timeoutMs % 1000) * 1000 };
+    if (::select(int(l) + 1, &readable, nullptr, nullptr, &tv) <= 0 || !FD_ISSET(l, &readable)) return kInvalid;
+    Native c = ::accept(l, nullptr, nullptr);
+    return Handle(c) == kInvalid ? kInvalid : Handle(c);
+}
+
+void Shutdown(Handle s) {
+    if (s == kInvalid) return;
+#ifdef _WIN32
+    ::shutdown(native(s), SD_BOTH);
+#else
+    ::shutdown(native(s), SHUT_RDWR);
+#endif
+}
+
+void Close(Handle s) {
+    if (s == kInvalid) return;
+#ifdef _WIN32
+    closesocket(native(s));
+#else
+    ::close(native(s));
+#endif
+}
+
+void SetRecvTimeout(Handle s, int ms) {
+#ifdef _WIN32
+    DWORD tv = DWORD(ms);
+#else
+    timeval tv{ ms / 1000, (ms % 1000) * 1000 };
+#endif
+    setsockopt(native(s), SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&tv), sizeof(tv));
+}
+
+int Recv(Handle s, char* buf, size_t len) {
+    return int(::recv(native(s), buf, int(len), 0));
+}
+
+bool SendAll(Handle s, const char* data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        int n = int(::send(native(s), data + sent, int(len - sent), kSendFlags));
+        if (n <= 0) return false;
+        sent += size_t(n);
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 本机回环 TCP 的最小封装（Winsock / BSD socket），供指标端点与控制接口使用。
+// 句柄统一为 uintptr_t，无效值为 kInvalid
+namespace localsock {
+
+using Handle = uintptr_t;
+static const Handle kInvalid = ~Handle(0);
+
+// Windows 上引用计数地初始化/释放 Winsock；其它平台为空操作
+bool Startup();
+void Cleanup();
+
+// 绑定 127.0.0.1:port 并监听；失败返回 kInvalid
+Handle Listen(uint16_t port, int backlog);
+// 等待至多 timeoutMs 接受一个连接；超时或出错返回 kInvalid
+Handle Accept(Handle listener, int timeoutMs);
+// 关闭读写两端：阻塞在 Recv 上的线程随即返回
+void Shutdown(Handle s);
+void Close(Handle s);
+
+void SetRecvTimeout(Handle s, int ms);
+// 返回读到的字节数；0 表示对端关闭，< 0 表示出错或超时
+int Recv(Handle s, char* buf, size_t len);
+bool SendAll(Handle s, const char* data, size_t len);
+
+}
@@ -1,24 +1,437 @@
 #include "Logger.h"
+#ifdef _WIN32
 #include <windows.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace logx {
 
-static void out(const std::string& level, const std::string& msg) {
-    std::string line = "[" + level + "] " + msg + "\n";
-    // console
-    std::cout << line;
-    // debugger
-    int wlen = MultiByteToWideChar(CP_UTF8, 0, line.c_str(), -1, nullptr, 0);
-    if (wlen > 0) {
-        std::wstring wbuf;
-        wbuf.resize(wlen);
-        MultiByteToWideChar(CP_UTF8, 0, line.c_str(), -1, &wbuf[0], wlen);
-        OutputDebugStringW(wbuf.c_str());
+static const size_t kRingBytes = 64 * 1024;         // 每线程环形缓冲（2 的幂）
+static const uint32_t kMaxRecordBytes = kRingBytes / 4;
+static const int kDrainIntervalMs = 10;             // 后台线程轮询间隔
+static const uint64_t kMaxFileBytes = 4ull << 20;   // 单个日志文件上限，超过即滚动
+static const int kKeepFiles = 3;                    // 保留 assistant.1.log … assistant.N.log
+static const char* kLogDir = "logs";
+static const char* kLogName = "assistant";
+
+static const char* kLevelNames[] = { "DEBUG", "INFO", "WARN", "ERROR" };
+
+namespace {
+
+enum RecordKind : uint8_t { kRecord = 1, kPad = 2 };
+
+// 环形缓冲内的记录头；其后为 count 个 {类型, 值} 槽（各 8 字节），
+// 字符串参数的值为长度，字节紧随其后并按 8 字节对齐
+struct RecordHeader {
+    uint32_t size;      // 含头部的总字节数（8 的倍数）
+    uint8_t kind;
+    uint8_t level;
+    uint8_t count;
+    uint8_t reserved;
+    uint64_t tsNs;      // system_clock 纳秒
+    const char* fmt;
+};
+
+size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+// 单生产者（所属线程）/ 单消费者（后台线程）的字节环形缓冲；满时丢弃，不阻塞调用线程
+class Ring {
+public:
+    explicit Ring(int id) : m_id(id), m_buf(new uint64_t[kRingBytes / 8]) {}
+
+    int Id() const { return m_id; }
+
+    // 预留 size 字节的连续空间（size 为 8 的倍数）；尾部不足时先写填充记录绕回
+    uint8_t* Reserve(uint32_t size) {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        size_t off = size_t(head & (kRingBytes - 1));
+        size_t toEnd = kRingBytes - off;
+        uint64_t need = size + (toEnd < size ? toEnd : 0);
+        if (head + need - m_cachedTail > kRingBytes) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head + need - m_cachedTail > kRingBytes) {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+        }
+        if (toEnd < size) {
+            RecordHeader* pad = reinterpret_cast<RecordHeader*>(Bytes() + off);
+            pad->size = uint32_t(toEnd);
+            pad->kind = kPad;
+            head += toEnd;
+            off = 0;
+        }
+        m_reserved = head;
+        return Bytes() + off;
     }
+    void Commit(uint32_t size) { m_head.store(m_reserved + size, std::memory_order_release); }
+
+    // 消费者：逐条回调已提交的记录
+    template <typename F>
+    void Drain(F&& fn) {
+        uint64_t tail = m_tail.load(std::memory_order_relaxed);
+        const uint64_t head = m_head.load(std::memory_order_acquire);
+        while (tail < head) {
+            const RecordHeader* h = reinterpret_cast<const RecordHeader*>(Bytes() + (tail & (kRingBytes - 1)));
+            if (h->kind == kRecord) fn(*h);
+            tail += h->size;
+        }
+        m_tail.store(tail, std::memory_order_release);
+    }
+
+    bool Empty() const {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+    uint64_t Dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    std::atomic<bool> orphaned{false}; // 所属线程已退出，取空后回收
+
+private:
+    uint8_t* Bytes() { return reinterpret_cast<uint8_t*>(m_buf.get()); }
+
+    const int m_id;
+    std::unique_ptr<uint64_t[]> m_buf;
+    alignas(64) std::atomic<uint64_t> m_head{0};
+    uint64_t m_reserved = 0;
+    uint64_t m_cachedTail = 0;    // 生产者缓存的消费位置，减少跨核读取
+    alignas(64) std::atomic<uint64_t> m_tail{0};
+    std::atomic<uint64_t> m_dropped{0};
+};
+
+std::string formatDouble(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.6g", v);
+    return buf;
+}
+
+// 把 "{}" 依次替换为参数；参数不足时原样保留
+std::string formatRecord(const RecordHeader& h) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&h) + sizeof(RecordHeader);
+    std::string out;
+    const char* f = h.fmt;
+    int used = 0;
+    while (*f) {
+        if (f[0] == '{' && f[1] == '}' && used < h.count) {
+            uint64_t type, value;
+            std::memcpy(&type, p, 8);
+            std::memcpy(&value, p + 8, 8);
+            p += 16;
+            switch (type) {
+            case detail::kInt: out += std::to_string(int64_t(value)); break;
+            case detail::kUint: out += std::to_string(value); break;
+            case detail::kDouble: { double d; std::memcpy(&d, &value, 8); out += formatDouble(d); break; }
+            default:
+                out.append(reinterpret_cast<const char*>(p), size_t(value));
+                p += align8(size_t(value));
+                break;
+            }
+            ++used;
+            f += 2;
+        } else {
+            out += *f++;
+        }
+    }
+    return out;
+}
+
+struct Entry {
+    uint64_t tsNs;
+    int thread;
+    int level;
+    std::string msg;
+};
+
+// 滚动文件：assistant.log 满 kMaxFileBytes 后依次改名为 .1/.2/…，最旧的删除
+class RotatingFile {
+public:
+    void Write(const std::string& line) {
+        if (!m_out.is_open() && !Open()) return;
+        m_out << line;
+        m_bytes += line.size();
+        if (m_bytes >= kMaxFileBytes) Rotate();
+    }
+    void Flush() { if (m_out.is_open()) m_out.flush(); }
+
+private:
+    std::filesystem::path PathOf(int index) const {
+        std::string name = kLogName;
+        if (index > 0) name += "." + std::to_string(index);
+        return std::filesystem::path(kLogDir) / (name + ".log");
+    }
+    bool Open() {
+        if (m_failed) return false;
+        std::error_code ec;
+        std::filesystem::create_directories(kLogDir, ec);
+        m_out.open(PathOf(0), std::ios::binary | std::ios::app);
+        if (!m_out) { m_failed = true; return false; }
+        m_bytes = uint64_t(std::filesystem::file_size(PathOf(0), ec));
+        if (ec) m_bytes = 0;
+        return true;
+    }
+    void Rotate() {
+        m_out.close();
+        std::error_code ec;
+        std::filesystem::remove(PathOf(kKeepFiles), ec);
+        for (int i = kKeepFiles - 1; i >= 0; --i)
+            std::filesystem::rename(PathOf(i), PathOf(i + 1), ec);
+        m_bytes = 0;
+        Open();
+    }
+
+    std::ofstream m_out;
+    uint64_t m_bytes = 0;
+    bool m_failed = false;
+};
+
+std::string formatTime(uint64_t tsNs) {
+    std::time_t sec = std::time_t(tsNs / 1000000000ull);
+    int ms = int((tsNs / 1000000ull) % 1000);
+    std::tm tmv{};
+#ifdef _WIN32
+    localtime_s(&tmv, &sec);
+#else
+    localtime_r(&sec, &tmv);
+#endif
+    char buf[48];
+    size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tmv);
+    std::snprintf(buf + n, sizeof(buf) - n, ".%03d", ms);
+    return buf;
+}
+
+// 写出一条：控制台与调试器保持原有 "[LEVEL] msg" 格式（Debug 只进文件），文件带时间与线程号
+void emit(RotatingFile& file, const Entry& e) {
+    const std::string line = std::string("[") + kLevelNames[e.level] + "] " + e.msg + "\n";
+    if (e.level >= int(Level::Info)) {
+        std::cout << line;
+#ifdef _WIN32
+        int wlen = MultiByteToWideChar(CP_UTF8, 0, line.c_str(), -1, nullptr, 0);
+        if (wlen > 0) {
+            std::wstring wbuf;
+            wbuf.resize(wlen);
+            MultiByteToWideChar(CP_UTF8, 0, line.c_str(), -1, &wbuf[0], wlen);
+            OutputDebugStringW(wbuf.c_str());
+        }
+#endif
+    }
+    file.Write(formatTime(e.tsNs) + " T" + std::to_string(e.thread) + " " + line);
+}
+
+class Backend {
+public:
+    Backend() : m_thread(&Backend::Run, this) {}
+
+    std::shared_ptr<Ring> NewRing() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto ring = std::make_shared<Ring>(m_nextId++);
+        m_rings.push_back(ring);
+        return ring;
+    }
+
+    void Flush() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        const uint64_t target = ++m_flushRequested;
+        m_wake.notify_all();
+        m_flushed.wait(lock, [&]{ return m_flushDone >= target || m_stopped; });
+    }
+
+    // 进程退出时（atexit）：写出剩余记录并停止后台线程，之后的日志同步写出
+    void Shutdown() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+    bool Stopped() const { return m_stoppedFlag.load(std::memory_order_acquire); }
+
+    uint64_t Dropped() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t n = m_droppedRetired;
+        for (auto& r : m_rings) n += r->Dropped();
+        return n;
+    }
+
+    // 后台线程停止后的同步路径
+    void WriteDirect(const Entry& e) {
+        std::lock_guard<std::mutex> lock(m_directMutex);
+        emit(m_file, e);
+        m_file.Flush();
+    }
+
+private:
+    void Run() {
+        std::vector<Entry> batch;
+        for (;;) {
+            uint64_t flushTarget;
+            bool stop;
+            std::vector<std::shared_ptr<Ring>> rings;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait_for(lock, std::chrono::milliseconds(kDrainIntervalMs),
+                                [&]{ return m_stop || m_flushRequested > m_flushDone; });
+                flushTarget = m_flushRequested;
+                stop = m_stop;
+                rings = m_rings;
+            }
+            // 各线程记录合并后按时间戳排序，跨线程顺序与实际发生顺序一致
+            batch.clear();
+            for (auto& ring : rings) {
+                ring->Drain([&](const RecordHeader& h) {
+                    batch.push_back(Entry{ h.tsNs, ring->Id(), h.level, formatRecord(h) });
+                });
+            }
+            std::stable_sort(batch.begin(), batch.end(),
+                             [](const Entry& a, const Entry& b) { return a.tsNs < b.tsNs; });
+            {
+                std::lock_guard<std::mutex> lock(m_directMutex);
+                for (const Entry& e : batch) emit(m_file, e);
+                if (!batch.empty()) { std::cout.flush(); m_file.Flush(); }
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                // 回收已退出线程的空缓冲
+                for (auto it = m_rings.begin(); it != m_rings.end();) {
+                    if ((*it)->orphaned.load() && (*it)->Empty()) {
+                        m_droppedRetired += (*it)->Dropped();
+                        it = m_rings.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                m_flushDone = flushTarget;
+                if (stop) {
+                    m_stopped = true;
+                    m_stoppedFlag.store(true, std::memory_order_release);
+                }
+            }
+            m_flushed.notify_all();
+            if (stop) return;
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_flushed;
+    std::vector<std::shared_ptr<Ring>> m_rings;
+    int m_nextId = 0;
+    uint64_t m_flushRequested = 0;
+    uint64_t m_flushDone = 0;
+    uint64_t m_droppedRetired = 0;
+    bool m_stop = false;
+    bool m_stopped = false;
+    std::atomic<bool> m_stoppedFlag{false};
+    std::mutex m_directMutex; // 文件写出：后台线程批量写与停止后的同步写互斥
+    RotatingFile m_file;
+    std::thread m_thread;
+};
+
+// 有意不析构：退出阶段的静态析构中仍可能写日志，由 atexit 停止后台线程后改走同步路径
+Backend& backend() {
+    static Backend* instance = [] {
+        Backend* b = new Backend();
+        std::atexit([] { backend().Shutdown(); });
+        return b;
+    }();
+    return *instance;
+}
+
+// 线程退出时把缓冲标记为可回收；剩余记录仍由后台线程写出
+struct ThreadRing {
+    std::shared_ptr<Ring> ring;
+    ~ThreadRing() { if (ring) ring->orphaned.store(true); }
+};
+thread_local ThreadRing t_ring;
+
+uint64_t nowNs() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+}
+
+namespace detail {
+
+void Submit(Level level, const char* fmt, const ArgView* args, int count) {
+    Backend& b = backend();
+    const uint64_t ts = nowNs();
+    if (b.Stopped()) {
+        // 退出阶段：后台线程已停止，直接格式化写出
+        std::string msg = fmt;
+        for (int i = 0; i < count; ++i) {
+            std::string v;
+            switch (args[i].type) {
+            case kInt: v = std::to_string(int64_t(args[i].bits)); break;
+            case kUint: v = std::to_string(args[i].bits); break;
+            case kDouble: { double d; std::memcpy(&d, &args[i].bits, 8); v = formatDouble(d); break; }
+            default: v.assign(args[i].str, args[i].len); break;
+            }
+            size_t pos = msg.find("{}");
+            if (pos == std::string::npos) break;
+            msg.replace(pos, 2, v);
+        }
+        b.WriteDirect(Entry{ ts, -1, int(level), msg });
+        return;
+    }
+    if (!t_ring.ring) t_ring.ring = b.NewRing();
+    Ring& ring = *t_ring.ring;
+
+    // 过长的字符串参数截断，保证单条记录不超过 kMaxRecordBytes
+    size_t size = sizeof(RecordHeader) + size_t(count) * 16;
+    uint32_t lens[kMaxArgs];
+    for (int i = 0; i < count; ++i) {
+        lens[i] = 0;
+        if (args[i].type != kStr) continue;
+        size_t room = kMaxRecordBytes > size ? kMaxRecordBytes - size : 0;
+        lens[i] = uint32_t(std::min<size_t>(args[i].len, room & ~size_t(7)));
+        size += align8(lens[i]);
+    }
+    uint8_t* p = ring.Reserve(uint32_t(size));
+    if (!p) return;
+    RecordHeader* h = reinterpret_cast<RecordHeader*>(p);
+    h->size = uint32_t(size);
+    h->kind = kRecord;
+    h->level = uint8_t(level);
+    h->count = uint8_t(count);
+    h->reserved = 0;
+    h->tsNs = ts;
+    h->fmt = fmt;
+    p += sizeof(RecordHeader);
+    for (int i = 0; i < count; ++i) {
+        const uint64_t type = args[i].type;
+        const uint64_t value = args[i].type == kStr ? uint64_t(lens[i]) : args[i].bits;
+        std::memcpy(p, &type, 8);
+        std::memcpy(p + 8, &value, 8);
+        p += 16;
+        if (args[i].type == kStr) {
+            std::memcpy(p, args[i].str, lens[i]);
+            p += align8(lens[i]);
+        }
+    }
+    ring.Commit(uint32_t(size));
+}
+
+}
+
+void Flush() {
+    Backend& b = backend();
+    if (!b.Stopped()) b.Flush();
 }
 
-void info(const std::string& msg) { out("INFO", msg); }
-void error(const std::string& msg) { out("ERROR", msg); }
+uint64_t Dropped() { return backend().Dropped(); }
 
 }
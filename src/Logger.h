@@ -1,12 +1,103 @@
 #pragma once
+#include <cstdint>
+#include <cstring>
 #include <string>
+#include <type_traits>
 
+// 编译期最低级别：低于它的 LOGx 整句被消去，参数也不会求值。
+// 0 Debug / 1 Info / 2 Warn / 3 Error；未定义时调试构建为 Debug，发布构建为 Info
+#ifndef LOGX_MIN_LEVEL
+#ifdef NDEBUG
+#define LOGX_MIN_LEVEL 1
+#else
+#define LOGX_MIN_LEVEL 0
+#endif
+#endif
+
+// 异步日志：调用线程只把（级别、时间戳、格式串指针、参数）写进本线程的无锁环形缓冲，
+// 后台线程按时间戳合并各线程记录、格式化并写控制台/调试器/滚动日志文件（logs/）。
+// 用法：LOGI("消息") / LOGI(std::string) / LOGI("布局 {}x{} 耗时 {} ms", rows, cols, ms)；
+// 带参数时格式串必须是字符串字面量（只保存指针），参数支持整数、浮点、枚举、C 字符串与 std::string
 namespace logx {
 
-void info(const std::string& msg);
-void error(const std::string& msg);
+enum class Level : uint8_t { Debug = 0, Info = 1, Warn = 2, Error = 3 };
+
+// 编译期级别判断。经由常量而非直接与宏比较：Debug 为 0 时 g++ -Wextra 会对每个调用点报 -Wtype-limits
+constexpr int kMinLevel = LOGX_MIN_LEVEL;
+constexpr bool Enabled(Level level) { return static_cast<int>(level) >= kMinLevel; }
+
+namespace detail {
+
+enum ArgType : uint8_t { kInt, kUint, kDouble, kStr };
+static const int kMaxArgs = 8;
+
+struct ArgView {
+    ArgType type;
+    uint64_t bits;       // 整数/浮点的位模式
+    const char* str;     // kStr：字节在提交时拷入环形缓冲
+    uint32_t len;
+};
+
+template <typename T> struct DependentFalse : std::false_type {};
+
+template <typename T>
+inline ArgView MakeArg(const T& v) {
+    if constexpr (std::is_same<T, bool>::value) {
+        return ArgView{kInt, uint64_t(v ? 1 : 0), nullptr, 0};
+    } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        return ArgView{kInt, uint64_t(int64_t(v)), nullptr, 0};
+    } else if constexpr (std::is_integral<T>::value) {
+        return ArgView{kUint, uint64_t(v), nullptr, 0};
+    } else if constexpr (std::is_enum<T>::value) {
+        return ArgView{kInt, uint64_t(int64_t(v)), nullptr, 0};
+    } else if constexpr (std::is_floating_point<T>::value) {
+        double d = double(v);
+        uint64_t bits;
+        std::memcpy(&bits, &d, sizeof(bits));
+        return ArgView{kDouble, bits, nullptr, 0};
+    } else if constexpr (std::is_same<T, std::string>::value) {
+        return ArgView{kStr, 0, v.data(), uint32_t(v.size())};
+    } else if constexpr (std::is_convertible<const T&, const char*>::value) {
+        const char* s = v;
+        return ArgView{kStr, 0, s ? s : "(null)", uint32_t(s ? std::strlen(s) : 6)};
+    } else {
+        static_assert(DependentFalse<T>::value, "logx: unsupported argument type");
+        return ArgView{};
+    }
+}
+
+void Submit(Level level, const char* fmt, const ArgView* args, int count);
 
 }
 
-#define LOGI(msg) ::logx::info(msg)
-#define LOGE(msg) ::logx::error(msg)
+// 纯文本：内容拷入环形缓冲
+inline void Write(Level level, const char* msg) {
+    detail::ArgView a = detail::MakeArg(msg);
+    detail::Submit(level, "{}", &a, 1);
+}
+inline void Write(Level level, const std::string& msg) {
+    detail::ArgView a = detail::MakeArg(msg);
+    detail::Submit(level, "{}", &a, 1);
+}
+// 格式化：fmt 为字面量，"{}" 依次替换为参数，格式化推迟到后台线程
+template <typename A0, typename... Args>
+inline void Write(Level level, const char* fmt, const A0& a0, const Args&... args) {
+    static_assert(sizeof...(Args) + 1 <= detail::kMaxArgs, "logx: too many arguments");
+    const detail::ArgView views[] = { detail::MakeArg(a0), detail::MakeArg(args)... };
+    detail::Submit(level, fmt, views, int(sizeof...(Args) + 1));
+}
+
+// 等待此前提交的记录全部写出（退出前、转储后等）
+void Flush();
+// 因环形缓冲已满而丢弃的记录数
+uint64_t Dropped();
+
+}
+
+#define LOGX_AT(level, ...) \
+    do { if constexpr (::logx::Enabled(level)) ::logx::Write(level, __VA_ARGS__); } while (0)
+
+#define LOGD(...) LOGX_AT(::logx::Level::Debug, __VA_ARGS__)
+#define LOGI(...) LOGX_AT(::logx::Level::Info, __VA_ARGS__)
+#define LOGW(...) LOGX_AT(::logx::Level::Warn, __VA_ARGS__)
+#define LOGE(...) LOGX_AT(::logx::Level::Error, __VA_ARGS__)
@@ -0,0 +1,70 @@
+#include "MappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <utility>
+
+MappedFile::MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        std::swap(m_file, other.m_file);
+        std::swap(m_mapping, other.m_mapping);
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+    }
+    return *this;
+}
+
+bool MappedFile::Open(const std::filesystem::path& p) {
+    Close();
+#ifdef _WIN32
+    // 允许录制进行中打开（写端仍持有文件）
+    HANDLE f = CreateFileW(p.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz{};
+    if (!GetFileSizeEx(f, &sz) || sz.QuadPart <= 0) { CloseHandle(f); return false; }
+    HANDLE mp = CreateFileMappingW(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mp) { CloseHandle(f); return false; }
+    void* view = MapViewOfFile(mp, FILE_MAP_READ, 0, 0, 0);
+    if (!view) { CloseHandle(mp); CloseHandle(f); return false; }
+    m_file = f;
+    m_mapping = mp;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = size_t(sz.QuadPart);
+    return true;
+#else
+    // 映射建立后即可关闭描述符，映射本身保持有效
+    int fd = ::open(p.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (::fstat(fd, &st) != 0 || st.st_size <= 0) { ::close(fd); return false; }
+    void* view = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+    m_data = static_cast<const uint8_t*>(view);
+    m_size = size_t(st.st_size);
+    return true;
+#endif
+}
+
+void MappedFile::Close() {
+#ifdef _WIN32
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_mapping) CloseHandle(m_mapping);
+    if (m_file) CloseHandle(m_file);
+#else
+    if (m_data) ::munmap(const_cast<uint8_t*>(m_data), m_size);
+#endif
+    m_file = nullptr;
+    m_mapping = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+}
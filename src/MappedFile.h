@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// 只读内存映射文件（Win32: CreateFileMapping；POSIX: mmap），仅可移动
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // 映射整个文件；空文件或打不开返回 false。写端仍持有文件时也可打开（录制进行中回放）
+    bool Open(const std::filesystem::path& p);
+    void Close();
+
+    bool IsOpen() const { return m_data != nullptr; }
+    const uint8_t* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+
+private:
+    void* m_file = nullptr;       // Win32 句柄；POSIX 下映射后即关闭描述符，不保留
+    void* m_mapping = nullptr;
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+};
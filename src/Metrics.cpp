@@ -0,0 +1,224 @@
+#include "Metrics.h"
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <locale>
+#include <sstream>
+
+namespace metrics {
+
+static const char* kStageNames[] = {
+    "capture", "decode", "validate", "locate_boards", "identify_bounds", "refine_board",
+    "grid_layout", "layout_verify", "recognize", "vote", "solve", "click", "render", "frame_to_decision"
+};
+static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) == size_t(Stage::Count), "stage names");
+
+// 状态栏用的短名
+static const wchar_t* kStageShort[] = {
+    L"Cap", L"Dec", L"Val", L"Loc", L"Bnd", L"Ref", L"Lay", L"Chk", L"Rec", L"Vote", L"Sol", L"Clk", L"Drw", L"E2E"
+};
+
+static LatencyHistogram g_histograms[size_t(Stage::Count)];
+static std::atomic<uint64_t> g_counters[size_t(Counter::Count)];
+
+// 计数器在 Prometheus 中的指标族与标签；同族的计数器须相邻
+struct CounterInfo {
+    const char* family;
+    const char* labels;
+    const char* help;
+};
+static const CounterInfo kCounters[] = {
+    {"minesweeper_frames_captured_total", "", "Frames captured successfully."},
+    {"minesweeper_capture_method_total", "method=\"printwindow\"", "Captures by method; bitblt is the fallback."},
+    {"minesweeper_capture_method_total", "method=\"bitblt\"", nullptr},
+    {"minesweeper_cells_reclassified_total", "", "Cells whose recognized value changed from the previous frame."},
+    {"minesweeper_solver_outcomes_total", "outcome=\"safe\"", "Solver runs by outcome."},
+    {"minesweeper_solver_outcomes_total", "outcome=\"mine\"", nullptr},
+    {"minesweeper_solver_outcomes_total", "outcome=\"guess\"", nullptr},
+    {"minesweeper_clicks_total", "result=\"issued\"", "Clicks by result."},
+    {"minesweeper_clicks_total", "result=\"verified\"", nullptr},
+    {"minesweeper_clicks_total", "result=\"retried\"", nullptr},
+    {"minesweeper_clicks_total", "result=\"cancelled\"", nullptr},
+    {"minesweeper_layout_detections_total", "", "Full board layout detections."},
+    {"minesweeper_layout_invalidations_total", "", "Locked or cached layouts rejected by verification."},
+    {"minesweeper_probe_cells_total", "result=\"decided\"", "Cells classified from sparse probes, or escalated to full-cell analysis."},
+    {"minesweeper_probe_cells_total", "result=\"escalated\"", nullptr},
+};
+static_assert(sizeof(kCounters) / sizeof(kCounters[0]) == size_t(Counter::Count), "counter table");
+
+// 导出用的直方图边界（秒）；内部桶按上界归入，误差在桶宽（约 6%）以内
+static const double kPromBounds[] = {
+    0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5
+};
+
+const char* StageName(Stage s) { return kStageNames[size_t(s)]; }
+
+static int msb64(uint64_t v) {
+    int n = 0;
+    if (v >> 32) { v >>= 32; n += 32; }
+    if (v >> 16) { v >>= 16; n += 16; }
+    if (v >> 8)  { v >>= 8;  n += 8; }
+    if (v >> 4)  { v >>= 4;  n += 4; }
+    if (v >> 2)  { v >>= 2;  n += 2; }
+    if (v >> 1)  { n += 1; }
+    return n;
+}
+
+int LatencyHistogram::BucketOf(uint64_t ns) {
+    const uint64_t cap = (uint64_t(1) << (kMaxShift + kSubBits + 1)) - 1;
+    if (ns > cap) ns = cap;
+    if (ns < uint64_t(kSub)) return int(ns);
+    int shift = msb64(ns) - kSubBits;
+    int sub = int((ns >> shift) & (kSub - 1));
+    return kSub + shift * kSub + sub;
+}
+
+uint64_t LatencyHistogram::BucketLowerNs(int index) {
+    if (index < kSub) return uint64_t(index);
+    int shift = (index - kSub) / kSub;
+    int sub = (index - kSub) % kSub;
+    return uint64_t(kSub + sub) << shift;
+}
+
+uint64_t LatencyHistogram::BucketUpperNs(int index) {
+    if (index < kSub) return uint64_t(index) + 1;
+    int shift = (index - kSub) / kSub;
+    return BucketLowerNs(index) + (uint64_t(1) << shift);
+}
+
+void LatencyHistogram::Record(uint64_t ns) {
+    m_buckets[BucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumNs.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t cur = m_maxNs.load(std::memory_order_relaxed);
+    while (ns > cur && !m_maxNs.compare_exchange_weak(cur, ns, std::memory_order_relaxed)) {}
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& b : m_buckets) b.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sumNs.store(0, std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+}
+
+LatencyHistogram::Summary LatencyHistogram::Summarize() const {
+    Summary s;
+    // 快照各桶；并发写入时总数以桶之和为准
+    uint64_t counts[kBucketCount];
+    uint64_t total = 0;
+    for (int i = 0; i < kBucketCount; ++i) { counts[i] = m_buckets[i].load(std::memory_order_relaxed); total += counts[i]; }
+    s.count = total;
+    s.maxUs = m_maxNs.load(std::memory_order_relaxed) / 1000.0;
+    if (total == 0) return s;
+    auto percentile = [&](double q) {
+        uint64_t rank = uint64_t(q * double(total - 1)) + 1;
+        uint64_t acc = 0;
+        for (int i = 0; i < kBucketCount; ++i) {
+            acc += counts[i];
+            if (acc >= rank) return (BucketLowerNs(i) + BucketUpperNs(i)) / 2000.0; // 桶中点，转 µs
+        }
+        return s.maxUs;
+    };
+    s.p50Us = std::min(percentile(0.50), s.maxUs);
+    s.p90Us = std::min(percentile(0.90), s.maxUs);
+    s.p99Us = std::min(percentile(0.99), s.maxUs);
+    return s;
+}
+
+LatencyHistogram& Histogram(Stage s) { return g_histograms[size_t(s)]; }
+
+void Record(Stage s, std::chrono::steady_clock::duration d) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+    g_histograms[size_t(s)].Record(ns > 0 ? uint64_t(ns) : 0);
+}
+
+void Record(Stage s, std::chrono::steady_clock::time_point t0, std::chrono::steady_clock::time_point t1) {
+    Record(s, t1 - t0);
+    if (trace::Enabled()) trace::Complete(kStageNames[size_t(s)], t0, t1);
+}
+
+void ResetAll() {
+    for (auto& h : g_histograms) h.Reset();
+}
+
+void Add(Counter c, uint64_t n) { g_counters[size_t(c)].fetch_add(n, std::memory_order_relaxed); }
+uint64_t Value(Counter c) { return g_counters[size_t(c)].load(std::memory_order_relaxed); }
+
+std::wstring FormatStatus() {
+    std::wstringstream ss;
+    ss.setf(std::ios::fixed); ss.precision(1);
+    ss << L"p50/p99 ms:";
+    for (size_t i = 0; i < size_t(Stage::Count); ++i) {
+        auto sum = g_histograms[i].Summarize();
+        if (sum.count == 0) continue;
+        ss << L" " << kStageShort[i] << L" " << sum.p50Us / 1000.0 << L"/" << sum.p99Us / 1000.0;
+    }
+    return ss.str();
+}
+
+void Dump(std::ostream& os) {
+    os << std::left << std::setw(20) << "stage" << std::right
+       << std::setw(10) << "count" << std::setw(12) << "p50(ms)" << std::setw(12) << "p90(ms)"
+       << std::setw(12) << "p99(ms)" << std::setw(12) << "max(ms)" << "\n";
+    os << std::fixed << std::setprecision(3);
+    for (size_t i = 0; i < size_t(Stage::Count); ++i) {
+        auto sum = g_histograms[i].Summarize();
+        os << std::left << std::setw(20) << kStageNames[i] << std::right
+           << std::setw(10) << sum.count
+           << std::setw(12) << sum.p50Us / 1000.0 << std::setw(12) << sum.p90Us / 1000.0
+           << std::setw(12) << sum.p99Us / 1000.0 << std::setw(12) << sum.maxUs / 1000.0 << "\n";
+    }
+}
+
+void WritePrometheus(std::ostream& os) {
+    const char* family = "";
+    for (size_t i = 0; i < size_t(Counter::Count); ++i) {
+        const CounterInfo& c = kCounters[i];
+        if (std::strcmp(c.family, family) != 0) {
+            family = c.family;
+            if (c.help) os << "# HELP " << c.family << " " << c.help << "\n";
+            os << "# TYPE " << c.family << " counter\n";
+        }
+        os << c.family;
+        if (*c.labels) os << "{" << c.labels << "}";
+        os << " " << g_counters[i].load(std::memory_order_relaxed) << "\n";
+    }
+    os << "# HELP minesweeper_frame_arena_peak_bytes Largest per-frame arena usage of any pipeline.\n"
+       << "# TYPE minesweeper_frame_arena_peak_bytes gauge\n"
+       << "minesweeper_frame_arena_peak_bytes " << FrameArena::GlobalPeakBytes() << "\n"
+       << "# HELP minesweeper_frame_arena_reserved_bytes Memory held by all frame arenas.\n"
+       << "# TYPE minesweeper_frame_arena_reserved_bytes gauge\n"
+       << "minesweeper_frame_arena_reserved_bytes " << FrameArena::GlobalReservedBytes() << "\n"
+       << "# HELP minesweeper_frame_arena_oversized_total Allocations too large for the arena, served by the heap.\n"
+       << "# TYPE minesweeper_frame_arena_oversized_total counter\n"
+       << "minesweeper_frame_arena_oversized_total " << FrameArena::GlobalOversized() << "\n";
+
+    const char* h = "minesweeper_stage_latency_seconds";
+    os << "# HELP " << h << " Pipeline stage latency.\n# TYPE " << h << " histogram\n";
+    std::ostringstream num;
+    num.imbue(std::locale::classic());
+    for (size_t s = 0; s < size_t(Stage::Count); ++s) {
+        const LatencyHistogram& hist = g_histograms[s];
+        // 先快照计数，保证各 le 单调、+Inf 与 _count 一致
+        uint64_t total = 0, cumulative = 0;
+        int bucket = 0;
+        uint64_t counts[LatencyHistogram::kBucketCount];
+        for (int i = 0; i < LatencyHistogram::kBucketCount; ++i) { counts[i] = hist.BucketCount(i); total += counts[i]; }
+        for (double le : kPromBounds) {
+            const uint64_t leNs = uint64_t(le * 1e9);
+            while (bucket < LatencyHistogram::kBucketCount && LatencyHistogram::BucketUpperNs(bucket) <= leNs)
+                cumulative += counts[bucket++];
+            num.str("");
+            num << le;
+            os << h << "_bucket{stage=\"" << kStageNames[s] << "\",le=\"" << num.str() << "\"} " << cumulative << "\n";
+        }
+        os << h << "_bucket{stage=\"" << kStageNames[s] << "\",le=\"+Inf\"} " << total << "\n";
+        num.str("");
+        num << std::setprecision(9) << hist.SumNs() / 1e9;
+        os << h << "_sum{stage=\"" << kStageNames[s] << "\"} " << num.str() << "\n";
+        os << h << "_count{stage=\"" << kStageNames[s] << "\"} " << total << "\n";
+    }
+}
+
+}
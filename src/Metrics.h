@@ -0,0 +1,130 @@
+#pragma once
+#include "Trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace metrics {
+
+// 流水线阶段（顺序即状态栏/转储中的顺序）
+enum class Stage {
+    Capture,        // CaptureGameArea 整体
+    Decode,         // 图片解码（命令行批处理）
+    Validate,       // 捕获内容采样校验
+    LocateBoards,   // LocateBoards（金字塔多棋盘定位）
+    IdentifyBounds, // IdentifyGameBounds
+    RefineBoard,    // RefineBoardArea
+    GridLayout,     // AnalyzeGridLayoutEx
+    LayoutVerify,   // 缓存布局的逐帧网格线校验
+    Recognize,      // AnalyzeGameState
+    Vote,           // 多帧投票
+    Solve,          // FindSafeMoves
+    Click,          // 点击派发
+    Render,         // 棋盘离屏渲染（增量）
+    FrameToDecision,// 帧捕获完成 → 求解完成
+    Count
+};
+
+const char* StageName(Stage s);
+
+// HDR 风格直方图：按 2 的幂分段、每段 16 个线性子桶（相对误差约 6%），
+// 记录为纳秒，覆盖到约 18 分钟；所有操作无锁，可多线程并发写入
+class LatencyHistogram {
+public:
+    static const int kSubBits = 4;
+    static const int kSub = 1 << kSubBits;
+    static const int kMaxShift = 40 - kSubBits;
+    static const int kBucketCount = kSub + (kMaxShift + 1) * kSub;
+
+    void Record(uint64_t ns);
+    void Reset();
+
+    struct Summary {
+        uint64_t count = 0;
+        double p50Us = 0, p90Us = 0, p99Us = 0, maxUs = 0;
+    };
+    Summary Summarize() const;
+
+    // 供导出：桶上界（纳秒）与计数
+    static uint64_t BucketUpperNs(int index);
+    uint64_t BucketCount(int index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t SumNs() const { return m_sumNs.load(std::memory_order_relaxed); }
+
+private:
+    static int BucketOf(uint64_t ns);
+    static uint64_t BucketLowerNs(int index);
+
+    std::atomic<uint64_t> m_buckets[kBucketCount] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sumNs{0};
+    std::atomic<uint64_t> m_maxNs{0};
+};
+
+LatencyHistogram& Histogram(Stage s);
+void Record(Stage s, std::chrono::steady_clock::duration d);
+// 记录 [t0, t1]；追踪开启时同时记为时间线区间（阶段在同一线程内完成时使用）
+void Record(Stage s, std::chrono::steady_clock::time_point t0, std::chrono::steady_clock::time_point t1);
+void ResetAll();
+
+// 状态栏用的紧凑摘要：各阶段 p50/p99（ms），仅列出有样本的阶段
+std::wstring FormatStatus();
+// 完整表格：count / p50 / p90 / p99 / max（ms）
+void Dump(std::ostream& os);
+
+// 单调递增的事件计数（所有目标合计），无锁，可多线程并发累加
+enum class Counter {
+    FramesCaptured,       // 成功捕获的帧
+    CapturePrintWindow,   // 捕获方式：PrintWindow
+    CaptureBitBlt,        // 捕获方式：回退到 BitBlt
+    CellsReclassified,    // 识别结果与上一帧不同的格子
+    SolveSafe,            // 求解推出安全格的次数
+    SolveMine,            // 只推出必雷格的次数
+    SolveGuess,           // 无任何结论、只能猜的次数
+    ClicksIssued,         // 点击派发（含重试）
+    ClicksVerified,       // 点击经后续帧确认生效
+    ClicksRetried,
+    ClicksCancelled,
+    LayoutDetections,     // 完整布局识别成功
+    LayoutInvalidations,  // 已有布局校验失败被作废
+    CellsProbed,          // 稀疏探针直接给出结论的格子
+    CellsEscalated,       // 探针结论不一、回退整格分析的格子
+    Count
+};
+
+void Add(Counter c, uint64_t n = 1);
+uint64_t Value(Counter c);
+// 一次求解的结果归类：有安全格 / 只有必雷格 / 仍有未知格却无结论（只能猜）；盘面已无未知格不计
+inline void CountSolveOutcome(size_t safe, size_t mines, bool unknownLeft) {
+    if (safe > 0) Add(Counter::SolveSafe);
+    else if (mines > 0) Add(Counter::SolveMine);
+    else if (unknownLeft) Add(Counter::SolveGuess);
+}
+
+// Prometheus 文本格式（0.0.4）：各计数器、帧内存用量与各阶段延迟直方图（秒）。
+// 只读原子量，不加锁，可在任意线程调用
+void WritePrometheus(std::ostream& os);
+
+// 作用域计时：构造时取 steady_clock，析构时写入对应阶段；追踪开启时同时记为时间线区间
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Stage s) : m_stage(s), m_t0(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        auto t1 = std::chrono::steady_clock::now();
+        Record(m_stage, t1 - m_t0);
+        if (::trace::Enabled()) ::trace::Complete(StageName(m_stage), m_t0, t1);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+private:
+    Stage m_stage;
+    std::chrono::steady_clock::time_point m_t0;
+};
+
+}
+
+#define METRICS_CONCAT_INNER(a, b) a##b
+#define METRICS_CONCAT(a, b) METRICS_CONCAT_INNER(a, b)
+#define STAGE_TIMER(stage) ::metrics::ScopedTimer METRICS_CONCAT(stageTimer_, __LINE__)(::metrics::Stage::stage)
@@ -0,0 +1,100 @@
+#include "MetricsServer.h"
+#include "Metrics.h"
+#include "Logger.h"
+#include <chrono>
+#include <locale>
+#include <sstream>
+#include <string>
+
+static const int kPollMs = 250;          // 检查停止标志的间隔
+static const int kRecvTimeoutMs = 1000;  // 单个请求的读取上限
+static const size_t kMaxRequest = 4096;
+
+static void respond(localsock::Handle client, const char* status, const char* contentType, const std::string& body) {
+    std::string r = std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + contentType
+                  + "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+    localsock::SendAll(client, r.data(), r.size());
+}
+
+bool MetricsServer::Start(uint16_t port) {
+    if (m_running.load()) return true;
+    if (!localsock::Startup()) return false;
+    m_listen = localsock::Listen(port, 8);
+    if (m_listen == localsock::kInvalid) {
+        LOGW("指标端点无法监听 127.0.0.1:{}", port);
+        localsock::Cleanup();
+        return false;
+    }
+    m_port = port;
+    m_captureFps = 0.0;
+    m_running.store(true);
+    m_thread = std::thread(&MetricsServer::Run, this);
+    LOGI("指标端点: http://127.0.0.1:{}/metrics", port);
+    return true;
+}
+
+void MetricsServer::Stop() {
+    if (!m_running.exchange(false)) return;
+    if (m_thread.joinable()) m_thread.join();
+    localsock::Close(m_listen);
+    m_listen = localsock::kInvalid;
+    localsock::Cleanup();
+}
+
+void MetricsServer::Run() {
+    using clock = std::chrono::steady_clock;
+    uint64_t lastFrames = metrics::Value(metrics::Counter::FramesCaptured);
+    auto lastTick = clock::now();
+    while (m_running.load()) {
+        localsock::Handle client = localsock::Accept(m_listen, kPollMs);
+        auto now = clock::now();
+        double sec = std::chrono::duration<double>(now - lastTick).count();
+        if (sec >= 1.0) {
+            uint64_t frames = metrics::Value(metrics::Counter::FramesCaptured);
+            m_captureFps = double(frames - lastFrames) / sec;
+            lastFrames = frames;
+            lastTick = now;
+        }
+        if (client == localsock::kInvalid) continue;
+        Serve(client);
+        localsock::Close(client);
+    }
+}
+
+void MetricsServer::Serve(localsock::Handle client) {
+    localsock::SetRecvTimeout(client, kRecvTimeoutMs);
+    // 只需请求行：读到头部结束或上限为止
+    std::string request;
+    char buf[1024];
+    while (request.size() < kMaxRequest && request.find("\r\n\r\n") == std::string::npos) {
+        int n = localsock::Recv(client, buf, sizeof(buf));
+        if (n <= 0) break;
+        request.append(buf, size_t(n));
+    }
+    const size_t lineEnd = request.find("\r\n");
+    const std::string line = request.substr(0, lineEnd);
+    const size_t sp1 = line.find(' ');
+    const size_t sp2 = sp1 == std::string::npos ? std::string::npos : line.find(' ', sp1 + 1);
+    if (sp2 == std::string::npos) {
+        respond(client, "400 Bad Request", "text/plain", "bad request\n");
+        return;
+    }
+    const std::string method = line.substr(0, sp1);
+    std::string path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    path = path.substr(0, path.find('?'));
+    if (method != "GET") {
+        respond(client, "405 Method Not Allowed", "text/plain", "method not allowed\n");
+        return;
+    }
+    if (path != "/metrics" && path != "/") {
+        respond(client, "404 Not Found", "text/plain", "not found; try /metrics\n");
+        return;
+    }
+    std::ostringstream body;
+    body.imbue(std::locale::classic());
+    metrics::WritePrometheus(body);
+    body << "# HELP minesweeper_capture_fps Frames captured per second over the last second, all targets.\n"
+         << "# TYPE minesweeper_capture_fps gauge\n"
+         << "minesweeper_capture_fps " << m_captureFps << "\n";
+    respond(client, "200 OK", "text/plain; version=0.0.4; charset=utf-8", body.str());
+}
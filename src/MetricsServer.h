@@ -0,0 +1,33 @@
+#pragma once
+#include "LocalSocket.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+// 本机指标端点：独立线程监听 127.0.0.1:port，GET /metrics 返回 Prometheus 文本
+// （metrics::WritePrometheus 的计数器与各阶段直方图，外加捕获帧率）。
+// 读取全部为原子量，不与流水线争锁；一次只服务一个连接，抓取间隔通常为秒级
+class MetricsServer {
+public:
+    MetricsServer() = default;
+    ~MetricsServer() { Stop(); }
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // 绑定并开始监听；端口被占用等失败时返回 false
+    bool Start(uint16_t port);
+    void Stop();
+    bool IsRunning() const { return m_running.load(); }
+    uint16_t Port() const { return m_port; }
+
+private:
+    void Run();
+    void Serve(localsock::Handle client);
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    localsock::Handle m_listen = localsock::kInvalid;
+    uint16_t m_port = 0;
+    // 捕获帧率：服务线程每秒对捕获帧计数取差
+    double m_captureFps = 0.0;
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include "InputSink.h"
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+// 记录型输入：不注入任何事件，只保存点击序列，供无界面运行与执行器验证
+class MockInputSink : public InputSink {
+public:
+    struct Event {
+        int x, y;
+        bool rightClick;
+        std::chrono::steady_clock::time_point at;
+    };
+
+    void Click(int x, int y, bool rightClick = false) override {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_events.push_back({ x, y, rightClick, std::chrono::steady_clock::now() });
+    }
+
+    std::vector<Event> Events() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_events;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<Event> m_events;
+};
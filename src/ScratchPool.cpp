@@ -0,0 +1,22 @@
+#include "ScratchPool.h"
+#include "FrameArena.h"
+#include <algorithm>
+
+cv::Mat ScratchPool::Take(int slot, cv::Size size, int type) {
+    if (slot >= (int)m_mats.size()) m_mats.resize(slot + 1);
+    cv::Mat& backing = m_mats[slot];
+    if (backing.type() != type || backing.rows < size.height || backing.cols < size.width) {
+        int rows = backing.type() == type ? std::max(backing.rows, size.height) : size.height;
+        int cols = backing.type() == type ? std::max(backing.cols, size.width) : size.width;
+        backing.allocator = FrameArena::HeapAllocator();
+        backing.create(std::max(1, rows), std::max(1, cols), type);
+    }
+    return backing(cv::Rect(0, 0, size.width, size.height));
+}
+
+std::vector<int>& ScratchPool::Ints(int slot, size_t n) {
+    if (slot >= (int)m_ints.size()) m_ints.resize(slot + 1);
+    std::vector<int>& v = m_ints[slot];
+    v.assign(n, 0);
+    return v;
+}
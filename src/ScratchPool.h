@@ -0,0 +1,22 @@
+#pragma once
+#include <opencv2/core.hpp>
+#include <deque>
+#include <vector>
+
+// 临时缓冲池：每个槽位保留一块只增不减的底层 Mat，Take 返回其左上角视图。
+// 视图直接作为 OpenCV 输出参数时，尺寸/类型一致则 create 为空操作，不再分配；
+// 尺寸在上限内变化（如末行/末列格子略大）也不会重新分配。
+// 不加锁，按线程使用：各模块以 thread_local 持有自己的实例与槽位编号。
+// 底层 Mat 跨帧保留，固定用堆分配器，不占 FrameArena
+class ScratchPool {
+public:
+    cv::Mat Take(int slot, cv::Size size, int type);
+    // 整数缓冲（投影直方图等）：清零到 n 个元素，保留容量。
+    // 返回的引用在再次请求同一槽位前有效；请求其他槽位不会使其失效
+    std::vector<int>& Ints(int slot, size_t n);
+
+private:
+    // deque 尾部扩容不移动已有元素：槽位增加时，先前取出的引用与底层 Mat 地址不变
+    std::deque<cv::Mat> m_mats;
+    std::deque<std::vector<int>> m_ints;
+};
@@ -0,0 +1,286 @@
+#include "SessionRecorder.h"
+#include "Logger.h"
+#include <algorithm>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+static const size_t kMaxQueuedFrames = 8;      // 后台写入跟不上时最多积压帧数
+static const uint32_t kKeyframeInterval = 120; // 每 N 帧强制一个关键帧
+static const uint32_t kFlushInterval = 30;     // 每 N 帧刷新一次文件
+
+static void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) { out.push_back(uint8_t(v) | 0x80); v >>= 7; }
+    out.push_back(uint8_t(v));
+}
+
+static bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// 编码：交替写 [零字节游程][字面量长度][XOR 字面量]；prev 为空时按关键帧处理
+static void encodeXorRle(const uint8_t* cur, const uint8_t* prev, size_t n, std::vector<uint8_t>& out) {
+    out.clear();
+    auto x = [&](size_t k) -> uint8_t { return prev ? uint8_t(cur[k] ^ prev[k]) : cur[k]; };
+    size_t i = 0;
+    while (i < n) {
+        // 8 字节一组快速跳过未变化区域（静止盘面几乎全部走这里）
+        size_t z = i;
+        while (z + 8 <= n) {
+            uint64_t a, b = 0;
+            std::memcpy(&a, cur + z, 8);
+            if (prev) std::memcpy(&b, prev + z, 8);
+            if (a != b) break;
+            z += 8;
+        }
+        while (z < n && x(z) == 0) ++z;
+        // 字面量延续到出现 4 个连续零字节为止
+        size_t end = z, zeros = 0;
+        for (size_t k = z; k < n; ++k) {
+            if (x(k) == 0) { if (++zeros >= 4) break; }
+            else { zeros = 0; end = k + 1; }
+        }
+        putVarint(out, z - i);
+        putVarint(out, end - z);
+        for (size_t k = z; k < end; ++k) out.push_back(x(k));
+        i = end;
+    }
+}
+
+// 解码：dst 事先填入上一帧（关键帧则为全零），按字面量原地 XOR
+static bool decodeXorRle(const uint8_t* in, size_t inSize, uint8_t* dst, size_t n) {
+    const uint8_t* p = in;
+    const uint8_t* end = in + inSize;
+    size_t pos = 0;
+    while (p < end) {
+        uint64_t zeroRun = 0, litLen = 0;
+        if (!getVarint(p, end, zeroRun) || !getVarint(p, end, litLen)) return false;
+        if (zeroRun > n - pos) return false;
+        pos += size_t(zeroRun);
+        if (litLen > n - pos || litLen > size_t(end - p)) return false;
+        for (size_t k = 0; k < litLen; ++k) dst[pos + k] ^= p[k];
+        pos += size_t(litLen);
+        p += litLen;
+    }
+    return true;
+}
+
+SessionRecorder::SessionRecorder() {}
+SessionRecorder::~SessionRecorder() { Stop(); }
+
+bool SessionRecorder::Start(const fs::path& base) {
+    Stop();
+    std::error_code ec;
+    if (base.has_parent_path()) fs::create_directories(base.parent_path(), ec);
+    fs::path dataPath = base; dataPath += ".msrec";
+    fs::path indexPath = base; indexPath += ".msidx";
+    m_data.open(dataPath, std::ios::binary | std::ios::trunc);
+    m_index.open(indexPath, std::ios::binary | std::ios::trunc);
+    if (!m_data || !m_index) {
+        LOGE("无法创建录制文件: " + dataPath.u8string());
+        m_data.close(); m_index.close();
+        return false;
+    }
+
+    RecFileHeader fh{};
+    std::memcpy(fh.magic, "MSREC\0\0\1", 8);
+    fh.version = 1;
+    fh.startUnixUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    m_data.write(reinterpret_cast<const char*>(&fh), sizeof(fh));
+    m_dataOffset = sizeof(fh);
+
+    m_seq = 0; m_keyIndex = 0; m_sinceKey = 0;
+    m_prev.release();
+    m_framesWritten = 0; m_framesDropped = 0; m_bytesWritten = sizeof(fh);
+    {
+        // 上一段录制结束后迟到的帧不能混进新文件（时间戳与 ROI 都属于旧录制）
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.clear();
+        m_stopRequested = false;
+        m_start = std::chrono::steady_clock::now();
+    }
+    m_recording = true;
+    m_writer = std::thread(&SessionRecorder::WriterLoop, this);
+    LOGI("开始录制: " + dataPath.u8string());
+    return true;
+}
+
+void SessionRecorder::Stop() {
+    if (!m_writer.joinable()) return;
+    m_recording = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopRequested = true;
+    }
+    m_cv.notify_all();
+    m_writer.join();
+    m_data.close();
+    m_index.close();
+    m_prev.release();
+    LOGI("录制结束: {} 帧, {} KB, 丢帧 {}", m_framesWritten.load(), m_bytesWritten.load() / 1024, m_framesDropped.load());
+}
+
+void SessionRecorder::Submit(const cv::Mat& frame, const cv::Rect& roi, const cv::Point& origin) {
+    if (!m_recording.load() || frame.empty()) return;
+    cv::Rect r = roi & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (r.width <= 0 || r.height <= 0) r = cv::Rect(0, 0, frame.cols, frame.rows);
+    const auto now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_queue.size() >= kMaxQueuedFrames) { m_framesDropped++; return; }
+    }
+    // 锁外拷贝 ROI：捕获线程只付出一次 ROI 大小的 memcpy
+    Pending p{ frame(r).clone(), cv::Rect(r.x + origin.x, r.y + origin.y, r.width, r.height), 0 };
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // 拷贝期间 Stop 可能已让写线程排空退出，甚至已开始下一段录制：锁内复查，迟到的帧丢弃
+        if (m_stopRequested || !m_recording.load() || now < m_start) return;
+        p.timestampUs = std::chrono::duration_cast<std::chrono::microseconds>(now - m_start).count();
+        m_queue.push_back(std::move(p));
+    }
+    m_cv.notify_one();
+}
+
+void SessionRecorder::WriterLoop() {
+    for (;;) {
+        Pending p;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [&]{ return m_stopRequested || !m_queue.empty(); });
+            if (m_queue.empty()) break; // 已请求停止且队列排空
+            p = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        WriteFrame(p);
+    }
+    m_data.flush();
+    m_index.flush();
+}
+
+void SessionRecorder::WriteFrame(const Pending& p) {
+    const cv::Mat& img = p.image; // clone 保证连续
+    size_t raw = img.total() * img.elemSize();
+    bool key = m_prev.empty() || m_prev.size() != img.size() || m_prev.type() != img.type()
+               || m_sinceKey >= kKeyframeInterval;
+    encodeXorRle(img.data, key ? nullptr : m_prev.data, raw, m_payload);
+
+    if (key) m_keyIndex = uint32_t(m_seq);
+    RecFrameHeader h{};
+    h.magic = kRecFrameMagic;
+    h.keyframe = key ? 1 : 0;
+    h.channels = uint16_t(img.channels());
+    h.timestampUs = p.timestampUs;
+    h.seq = m_seq;
+    h.x = p.roi.x; h.y = p.roi.y;
+    h.width = img.cols; h.height = img.rows;
+    h.rawSize = uint32_t(raw);
+    h.payloadSize = uint32_t(m_payload.size());
+
+    RecIndexEntry e{};
+    e.timestampUs = p.timestampUs;
+    e.offset = m_dataOffset;
+    e.keyIndex = m_keyIndex;
+
+    m_data.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    if (!m_payload.empty()) m_data.write(reinterpret_cast<const char*>(m_payload.data()), m_payload.size());
+    m_index.write(reinterpret_cast<const char*>(&e), sizeof(e));
+    // 先刷数据后刷索引：崩溃时索引不会指向未落盘的记录
+    if (key || (m_seq % kFlushInterval) == 0) { m_data.flush(); m_index.flush(); }
+
+    m_dataOffset += sizeof(h) + m_payload.size();
+    m_bytesWritten += sizeof(h) + m_payload.size() + sizeof(e);
+    m_framesWritten++;
+    m_seq++;
+    m_sinceKey = key ? 1 : m_sinceKey + 1;
+    m_prev = p.image;
+    m_prevRoi = p.roi;
+}
+
+SessionPlayer::SessionPlayer() {}
+SessionPlayer::~SessionPlayer() { Close(); }
+
+bool SessionPlayer::Open(const fs::path& base) {
+    Close();
+    fs::path dataPath = base; dataPath += ".msrec";
+    fs::path indexPath = base; indexPath += ".msidx";
+    if (!m_data.Open(dataPath)) return false;
+    if (m_data.Size() < sizeof(RecFileHeader) || std::memcmp(m_data.Data(), "MSREC\0\0\1", 8) != 0) {
+        Close();
+        return false;
+    }
+    if (!m_index.Open(indexPath)) { Close(); return false; }
+    m_entries = reinterpret_cast<const RecIndexEntry*>(m_index.Data());
+    m_indexCount = m_index.Size() / sizeof(RecIndexEntry);
+    // 丢弃尾部未完整落盘的记录
+    while (m_indexCount > 0 && !HeaderAt(m_indexCount - 1)) m_indexCount--;
+    return m_indexCount > 0;
+}
+
+void SessionPlayer::Close() {
+    m_data.Close();
+    m_index.Close();
+    m_entries = nullptr;
+    m_indexCount = 0;
+    m_cache.release();
+    m_cacheIndex = -1;
+}
+
+int64_t SessionPlayer::DurationUs() const {
+    if (m_indexCount == 0) return 0;
+    return m_entries[m_indexCount - 1].timestampUs - m_entries[0].timestampUs;
+}
+
+const RecFrameHeader* SessionPlayer::HeaderAt(size_t index) const {
+    if (index >= m_indexCount) return nullptr;
+    uint64_t off = m_entries[index].offset;
+    if (off + sizeof(RecFrameHeader) > m_data.Size()) return nullptr;
+    const RecFrameHeader* h = reinterpret_cast<const RecFrameHeader*>(m_data.Data() + off);
+    if (h->magic != kRecFrameMagic) return nullptr;
+    if (off + sizeof(RecFrameHeader) + h->payloadSize > m_data.Size()) return nullptr;
+    if (uint64_t(h->width) * uint64_t(h->height) * h->channels != h->rawSize) return nullptr;
+    return h;
+}
+
+bool SessionPlayer::FrameAt(int64_t timestampUs, cv::Mat& out, cv::Rect* roi) {
+    if (m_indexCount == 0) return false;
+    const RecIndexEntry* first = m_entries;
+    const RecIndexEntry* last = m_entries + m_indexCount;
+    const RecIndexEntry* it = std::upper_bound(first, last, timestampUs,
+        [](int64_t t, const RecIndexEntry& e){ return t < e.timestampUs; });
+    size_t index = (it == first) ? 0 : size_t(it - first) - 1;
+    return FrameByIndex(index, out, roi);
+}
+
+bool SessionPlayer::FrameByIndex(size_t index, cv::Mat& out, cv::Rect* roi) {
+    if (index >= m_indexCount) return false;
+    size_t key = m_entries[index].keyIndex;
+    if (key > index) return false;
+    // 缓存落在同一关键帧链上且不晚于目标帧时，从缓存继续解码
+    size_t from = key;
+    if (m_cacheIndex >= (long long)key && m_cacheIndex <= (long long)index) from = size_t(m_cacheIndex) + 1;
+    for (size_t i = from; i <= index; ++i) {
+        const RecFrameHeader* h = HeaderAt(i);
+        if (!h) { m_cacheIndex = -1; return false; }
+        int type = CV_8UC(h->channels);
+        if (h->keyframe || m_cache.rows != h->height || m_cache.cols != h->width || m_cache.type() != type) {
+            m_cache.create(h->height, h->width, type);
+            m_cache.setTo(cv::Scalar::all(0));
+        }
+        const uint8_t* payload = reinterpret_cast<const uint8_t*>(h + 1);
+        if (!decodeXorRle(payload, h->payloadSize, m_cache.data, h->rawSize)) { m_cacheIndex = -1; return false; }
+        m_cacheIndex = (long long)i;
+    }
+    out = m_cache.clone();
+    if (roi) {
+        const RecFrameHeader* h = HeaderAt(index);
+        *roi = cv::Rect(h->x, h->y, h->width, h->height);
+    }
+    return true;
+}
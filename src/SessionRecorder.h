@@ -0,0 +1,127 @@
+#pragma once
+#include "MappedFile.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 会话录制文件格式（小端，追加写入，可内存映射回放）
+//   <base>.msrec : RecFileHeader + N × (RecFrameHeader + payload)
+//   <base>.msidx : N × RecIndexEntry（按时间戳递增，用于随机定位）
+// payload 为当前帧与上一帧逐字节 XOR 后的 RLE 编码；关键帧与全零帧做 XOR（即原图 RLE）。
+#pragma pack(push, 1)
+struct RecFileHeader {
+    char magic[8];          // "MSREC\0\0\1"
+    uint32_t version;
+    uint32_t reserved;
+    int64_t startUnixUs;    // 录制开始的墙钟时间（微秒）
+};
+
+struct RecFrameHeader {
+    uint32_t magic;         // kRecFrameMagic
+    uint16_t keyframe;      // 1: 关键帧
+    uint16_t channels;
+    int64_t timestampUs;    // 相对录制开始
+    uint64_t seq;
+    int32_t x, y;           // ROI 在客户区中的位置
+    int32_t width, height;
+    uint32_t rawSize;       // 解码后字节数 = width*height*channels
+    uint32_t payloadSize;
+};
+
+struct RecIndexEntry {
+    int64_t timestampUs;
+    uint64_t offset;        // RecFrameHeader 在 .msrec 中的偏移
+    uint32_t keyIndex;      // 所属关键帧在索引中的序号
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+static const uint32_t kRecFrameMagic = 0x4D524652u; // "RFRM"
+
+class SessionRecorder {
+public:
+    SessionRecorder();
+    ~SessionRecorder();
+
+    // base 不含扩展名；目录不存在时自动创建
+    bool Start(const std::filesystem::path& base);
+    void Stop();
+    bool IsRecording() const { return m_recording.load(); }
+
+    // 捕获线程调用：仅拷贝 ROI 并入队，编码与写盘在后台线程完成；队列满时丢帧
+    // roi 相对 frame；origin 为 frame 在客户区中的位置（ROI 捕获时非零）
+    void Submit(const cv::Mat& frame, const cv::Rect& roi, const cv::Point& origin = cv::Point());
+
+    uint64_t GetFramesWritten() const { return m_framesWritten.load(); }
+    uint64_t GetFramesDropped() const { return m_framesDropped.load(); }
+    uint64_t GetBytesWritten() const { return m_bytesWritten.load(); }
+
+private:
+    struct Pending {
+        cv::Mat image;
+        cv::Rect roi;           // 客户区坐标
+        int64_t timestampUs;
+    };
+
+    void WriterLoop();
+    void WriteFrame(const Pending& p);
+
+    std::atomic<bool> m_recording{false};
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Pending> m_queue;
+    bool m_stopRequested = false;
+
+    std::ofstream m_data;
+    std::ofstream m_index;
+    uint64_t m_dataOffset = 0;
+    uint64_t m_seq = 0;
+    uint32_t m_keyIndex = 0;
+    uint32_t m_sinceKey = 0;
+    cv::Mat m_prev;             // 上一写入帧（用于差分）
+    cv::Rect m_prevRoi;
+    std::vector<uint8_t> m_payload;
+    std::chrono::steady_clock::time_point m_start;
+
+    std::atomic<uint64_t> m_framesWritten{0};
+    std::atomic<uint64_t> m_framesDropped{0};
+    std::atomic<uint64_t> m_bytesWritten{0};
+};
+
+// 回放：内存映射 .msrec/.msidx，按时间戳随机访问
+class SessionPlayer {
+public:
+    SessionPlayer();
+    ~SessionPlayer();
+
+    bool Open(const std::filesystem::path& base);
+    void Close();
+
+    size_t FrameCount() const { return m_indexCount; }
+    int64_t DurationUs() const;
+    // 取时间戳 <= timestampUs 的最后一帧；roi 输出该帧在客户区中的位置
+    bool FrameAt(int64_t timestampUs, cv::Mat& out, cv::Rect* roi = nullptr);
+    bool FrameByIndex(size_t index, cv::Mat& out, cv::Rect* roi = nullptr);
+
+private:
+    const RecFrameHeader* HeaderAt(size_t index) const;
+
+    MappedFile m_data;
+    MappedFile m_index;
+    const RecIndexEntry* m_entries = nullptr;
+    size_t m_indexCount = 0;
+
+    // 顺序回放缓存：避免每帧都从关键帧重新解码
+    cv::Mat m_cache;
+    long long m_cacheIndex = -1;
+};
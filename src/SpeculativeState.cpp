@@ -0,0 +1,81 @@
+#include "SpeculativeState.h"
+#include <algorithm>
+
+static const int kPendingTimeoutMs = 3000; // 派发被取消或一直未生效的待定格过期释放
+
+void SpeculativeState::MarkPending(const std::vector<cv::Point>& cells, Clock::time_point at) {
+    for (const cv::Point& c : cells) {
+        bool known = std::any_of(m_pending.begin(), m_pending.end(), [&](const Entry& e){ return e.cell == c; });
+        if (known) continue;
+        m_pending.push_back({ c, at });
+        m_stats.predicted++;
+    }
+}
+
+bool SpeculativeState::Reconcile(const GameState& observed, Clock::time_point now) {
+    if (observed.rows != m_rows || observed.cols != m_cols || (int)observed.grid.size() != observed.rows) {
+        // 盘面几何变化：旧推测整体作废（不算矛盾）
+        m_pending.clear();
+        m_rows = observed.rows; m_cols = observed.cols;
+        return true;
+    }
+    if (m_pending.empty()) return true;
+
+    std::vector<uint8_t> pending(size_t(m_rows) * m_cols, 0);
+    bool contradiction = false;
+    for (auto it = m_pending.begin(); it != m_pending.end(); ) {
+        const cv::Point& c = it->cell;
+        if (c.x < 0 || c.y < 0 || c.x >= m_cols || c.y >= m_rows) { it = m_pending.erase(it); continue; }
+        int v = observed.grid[c.y][c.x];
+        if (v == -1 || v == 10) { contradiction = true; break; } // 推测安全的格子是雷/被插旗
+        if (v != 9) { m_stats.confirmed++; it = m_pending.erase(it); continue; }
+        if (now - it->at > std::chrono::milliseconds(kPendingTimeoutMs)) { m_stats.expired++; it = m_pending.erase(it); continue; }
+        pending[size_t(c.y) * m_cols + c.x] = 1;
+        ++it;
+    }
+
+    // 数字约束：待定格视为非雷后，每个数字周围的 雷/旗 + 其余未知格 必须还够数
+    for (int r=0; r<m_rows && !contradiction; ++r) {
+        for (int c=0; c<m_cols && !contradiction; ++c) {
+            int n = observed.grid[r][c];
+            if (n < 1 || n > 8) continue;
+            int mines = 0, open = 0;
+            for (int dr=-1; dr<=1; ++dr) {
+                for (int dc=-1; dc<=1; ++dc) {
+                    int nr = r + dr, nc = c + dc;
+                    if ((dr == 0 && dc == 0) || nr < 0 || nr >= m_rows || nc < 0 || nc >= m_cols) continue;
+                    int v = observed.grid[nr][nc];
+                    if (v == -1 || v == 10) mines++;
+                    else if (v == 9 && !pending[size_t(nr) * m_cols + nc]) open++;
+                }
+            }
+            if (n > mines + open) contradiction = true;
+        }
+    }
+    if (contradiction) {
+        m_pending.clear();
+        m_stats.rolledBack++;
+        return false;
+    }
+    return true;
+}
+
+void SpeculativeState::Overlay(GameState& state) const {
+    for (const Entry& e : m_pending) {
+        if (e.cell.y < 0 || e.cell.y >= (int)state.grid.size()) continue;
+        auto& row = state.grid[e.cell.y];
+        if (e.cell.x < 0 || e.cell.x >= (int)row.size()) continue;
+        if (row[e.cell.x] == 9) row[e.cell.x] = 11;
+    }
+}
+
+void SpeculativeState::Clear() {
+    m_pending.clear();
+}
+
+std::vector<cv::Point> SpeculativeState::Pending() const {
+    std::vector<cv::Point> out;
+    out.reserve(m_pending.size());
+    for (const Entry& e : m_pending) out.push_back(e.cell);
+    return out;
+}
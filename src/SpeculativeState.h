@@ -0,0 +1,43 @@
+#pragma once
+#include "GameState.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// 推测叠加层：已判定安全并交给执行器的格子记为“待定”（GameState 值 11），
+// 求解器把它们当作已翻开、数字未知的格子继续推理，不必等下一次捕获与识别。
+// 新帧到达时对账：格子已翻开则确认，显示为雷或与数字约束矛盾则整体回滚。
+// 非线程安全，由分析线程独占使用
+class SpeculativeState {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 记入待定格（按加入顺序保留，重复加入忽略）
+    void MarkPending(const std::vector<cv::Point>& cells, Clock::time_point at);
+    // 与观测状态对账；返回 false 表示推测与画面矛盾，已清空全部待定格
+    bool Reconcile(const GameState& observed, Clock::time_point now);
+    // 把仍未翻开的待定格叠加到 state（9 → 11）
+    void Overlay(GameState& state) const;
+    void Clear();
+
+    // 仍待画面确认的格子（加入顺序），即应派发的点击序列
+    std::vector<cv::Point> Pending() const;
+    size_t PendingCount() const { return m_pending.size(); }
+
+    struct Stats {
+        uint64_t predicted = 0;
+        uint64_t confirmed = 0;
+        uint64_t expired = 0;
+        uint64_t rolledBack = 0;  // 回滚次数
+    };
+    const Stats& GetStats() const { return m_stats; }
+
+private:
+    struct Entry {
+        cv::Point cell;
+        Clock::time_point at;
+    };
+    std::vector<Entry> m_pending;
+    int m_rows = 0, m_cols = 0;
+    Stats m_stats;
+};
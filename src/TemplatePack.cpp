@@ -0,0 +1,225 @@
+#include "TemplatePack.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+static const char kPackMagic[8] = { 'M', 'S', 'T', 'P', 'K', '\0', '\0', '\1' };
+static const size_t kDataAlign = 16;
+
+// 源文件名 → 格值
+struct LabelName {
+    const char* name;
+    int label;
+};
+static const LabelName kLabels[] = {
+    {"1", 1}, {"2", 2}, {"3", 3}, {"4", 4}, {"5", 5}, {"6", 6}, {"7", 7}, {"8", 8},
+    {"unopened", 9}, {"flag", 10}, {"mine", -1},
+};
+
+bool TemplatePack::Open(const fs::path& path) {
+    Close();
+    if (!m_file.Open(path)) return false;
+    const uint8_t* base = m_file.Data();
+    const size_t size = m_file.Size();
+    if (size < sizeof(PackHeader)) { Close(); return false; }
+    const PackHeader* h = reinterpret_cast<const PackHeader*>(base);
+    if (std::memcmp(h->magic, kPackMagic, 8) != 0 || h->version != kVersion) { Close(); return false; }
+    const uint64_t skinEnd = sizeof(PackHeader) + uint64_t(h->skinCount) * sizeof(PackSkin);
+    const uint64_t indexEnd = h->indexOffset + uint64_t(h->entryCount) * sizeof(PackEntry);
+    if (skinEnd > size || h->indexOffset < skinEnd || indexEnd > size) { Close(); return false; }
+
+    const PackSkin* skins = reinterpret_cast<const PackSkin*>(base + sizeof(PackHeader));
+    for (uint32_t i = 0; i < h->skinCount; ++i)
+        m_skins.emplace_back(skins[i].name, strnlen(skins[i].name, sizeof(skins[i].name)));
+
+    const PackEntry* entries = reinterpret_cast<const PackEntry*>(base + h->indexOffset);
+    for (uint32_t i = 0; i < h->entryCount; ++i) {
+        const PackEntry& e = entries[i];
+        const uint64_t bytes = uint64_t(e.size) * e.size * sizeof(float);
+        // 越界、未对齐或尺寸与裁剪规则不符的条目直接丢弃
+        if (e.size == 0 || e.size != InnerSize(e.cellSize) || e.skin >= h->skinCount ||
+            e.offset % sizeof(float) != 0 || e.offset < skinEnd || e.offset + bytes > h->indexOffset) continue;
+        if (m_scales.empty() || m_scales.back().cellSize != e.cellSize) {
+            // 索引须按尺寸递增，否则视为损坏
+            if (!m_scales.empty() && m_scales.back().cellSize > e.cellSize) { Close(); return false; }
+            m_scales.push_back(Scale{ e.cellSize, e.size, {} });
+        }
+        m_scales.back().templates.push_back(
+            Template{ e.label, e.skin, reinterpret_cast<const float*>(base + e.offset) });
+        m_count++;
+    }
+    if (m_count == 0) { Close(); return false; }
+    return true;
+}
+
+void TemplatePack::Close() {
+    m_file.Close();
+    m_scales.clear();
+    m_skins.clear();
+    m_count = 0;
+}
+
+const TemplatePack::Scale* TemplatePack::Nearest(int cellSize) const {
+    if (m_scales.empty()) return nullptr;
+    auto it = std::lower_bound(m_scales.begin(), m_scales.end(), cellSize,
+        [](const Scale& s, int v){ return s.cellSize < v; });
+    if (it == m_scales.end()) return &m_scales.back();
+    if (it != m_scales.begin() && cellSize - std::prev(it)->cellSize < it->cellSize - cellSize) --it;
+    return &*it;
+}
+
+int TemplatePack::Match(const Scale& scale, const cv::Mat& gray, double* score) {
+    const int n = scale.size;
+    if (score) *score = -1.0;
+    if (gray.type() != CV_8UC1 || gray.rows != n || gray.cols != n) return 0;
+    double sum = 0.0, sumSq = 0.0;
+    for (int y = 0; y < n; ++y) {
+        const uint8_t* row = gray.ptr<uint8_t>(y);
+        for (int x = 0; x < n; ++x) { sum += row[x]; sumSq += double(row[x]) * row[x]; }
+    }
+    const double count = double(n) * n;
+    const double var = sumSq - sum * sum / count;
+    // 标准差 < 2 视为纯色块：没有可匹配的形状
+    if (var < count * 4.0) return 0;
+    const double norm = std::sqrt(var);
+
+    // 模板零均值，故 Σ T·(P − mean) = Σ T·P
+    int best = 0;
+    double bestScore = -1.0;
+    for (const Template& t : scale.templates) {
+        const float* tp = t.data;
+        double dot = 0.0;
+        for (int y = 0; y < n; ++y, tp += n) {
+            const uint8_t* row = gray.ptr<uint8_t>(y);
+            float acc = 0.f;
+            for (int x = 0; x < n; ++x) acc += tp[x] * float(row[x]);
+            dot += acc;
+        }
+        const double s = dot / norm;
+        if (s > bestScore) { bestScore = s; best = t.label; }
+    }
+    if (score) *score = bestScore;
+    return best;
+}
+
+// 源模板 → 指定格子尺寸的归一化内圈；纯色返回空
+static cv::Mat normalizedTemplate(const cv::Mat& src, int label, int cellSize) {
+    const int inset = TemplatePack::InnerInset(std::min(src.cols, src.rows));
+    cv::Rect inner(inset, inset, std::max(1, src.cols - 2 * inset), std::max(1, src.rows - 2 * inset));
+    cv::Mat roi = src(inner & cv::Rect(0, 0, src.cols, src.rows));
+    // 数字/旗子/地雷只保留形状；未打开格保留立体边框的明暗
+    cv::Mat shaped;
+    if (label != 9) cv::threshold(roi, shaped, 0, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+    else shaped = roi;
+    const int n = TemplatePack::InnerSize(cellSize);
+    cv::Mat scaled;
+    cv::resize(shaped, scaled, cv::Size(n, n), 0, 0, cv::INTER_AREA);
+    cv::Mat f;
+    scaled.convertTo(f, CV_32F);
+    f -= cv::mean(f)[0];
+    const double norm = cv::norm(f, cv::NORM_L2);
+    if (norm < 1e-3) return cv::Mat();
+    f /= norm;
+    return f;
+}
+
+static cv::Mat loadSource(const fs::path& dir, const char* name) {
+    for (const char* ext : {".png", ".bmp"}) {
+        fs::path p = dir / (std::string(name) + ext);
+        std::error_code ec;
+        if (fs::exists(p, ec)) return cv::imread(p.string(), cv::IMREAD_GRAYSCALE);
+    }
+    return cv::Mat();
+}
+
+bool TemplatePack::Build(const fs::path& srcDir, const fs::path& outPath,
+                         const BuildOptions& options, std::string& report) {
+    const int minCell = std::max(4, options.minCell);
+    const int maxCell = std::min(int(UINT16_MAX), options.maxCell);
+    if (minCell > maxCell) { report = "尺寸范围无效"; return false; }
+
+    // 皮肤目录：根目录（default）+ 各子目录，按名称排序以保证输出稳定
+    std::vector<std::pair<std::string, fs::path>> dirs;
+    dirs.emplace_back("default", srcDir);
+    std::error_code ec;
+    std::vector<fs::path> subdirs;
+    for (const auto& de : fs::directory_iterator(srcDir, ec))
+        if (de.is_directory(ec)) subdirs.push_back(de.path());
+    std::sort(subdirs.begin(), subdirs.end());
+    for (const auto& d : subdirs) dirs.emplace_back(d.filename().string(), d);
+    if (ec) { report = "无法读取目录 " + srcDir.string(); return false; }
+
+    struct Source { int label; int skin; cv::Mat image; };
+    std::vector<Source> sources;
+    std::vector<std::string> skins;
+    for (const auto& d : dirs) {
+        const int skin = int(skins.size());
+        bool any = false;
+        for (const LabelName& l : kLabels) {
+            cv::Mat img = loadSource(d.second, l.name);
+            if (img.empty()) continue;
+            sources.push_back(Source{ l.label, skin, img });
+            any = true;
+        }
+        if (any) skins.push_back(d.first.substr(0, sizeof(PackSkin::name) - 1));
+    }
+    if (sources.empty()) { report = "未找到模板：" + srcDir.string(); return false; }
+
+    std::ofstream os(outPath, std::ios::binary | std::ios::trunc);
+    if (!os) { report = "无法写入 " + outPath.string(); return false; }
+
+    PackHeader header{};
+    std::memcpy(header.magic, kPackMagic, 8);
+    header.version = kVersion;
+    header.skinCount = uint32_t(skins.size());
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& s : skins) {
+        PackSkin ps{};
+        std::memcpy(ps.name, s.data(), s.size());
+        os.write(reinterpret_cast<const char*>(&ps), sizeof(ps));
+    }
+
+    // 数据区：尺寸外层、皮肤与格值内层，即索引的排序顺序
+    std::vector<PackEntry> entries;
+    uint64_t offset = sizeof(PackHeader) + skins.size() * sizeof(PackSkin);
+    size_t flat = 0;
+    static const char kZeros[kDataAlign] = {};
+    for (int cell = minCell; cell <= maxCell; ++cell) {
+        for (const Source& src : sources) {
+            cv::Mat t = normalizedTemplate(src.image, src.label, cell);
+            if (t.empty()) { flat++; continue; }
+            const size_t pad = (kDataAlign - offset % kDataAlign) % kDataAlign;
+            os.write(kZeros, std::streamsize(pad));
+            offset += pad;
+            PackEntry e{};
+            e.label = int16_t(src.label);
+            e.skin = uint16_t(src.skin);
+            e.cellSize = uint16_t(cell);
+            e.size = uint16_t(t.rows);
+            e.offset = offset;
+            const size_t bytes = t.total() * sizeof(float);
+            os.write(reinterpret_cast<const char*>(t.ptr<float>()), std::streamsize(bytes));
+            offset += bytes;
+            entries.push_back(e);
+        }
+    }
+    if (entries.empty()) { report = "所有模板均为纯色"; return false; }
+
+    header.entryCount = uint32_t(entries.size());
+    header.indexOffset = offset;
+    os.write(reinterpret_cast<const char*>(entries.data()), std::streamsize(entries.size() * sizeof(PackEntry)));
+    os.seekp(0);
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.close();
+    if (!os) { report = "写入失败 " + outPath.string(); return false; }
+
+    report = std::to_string(skins.size()) + " 种皮肤，" + std::to_string(sources.size()) + " 个源模板，"
+           + "格子 " + std::to_string(minCell) + "–" + std::to_string(maxCell) + " px，"
+           + std::to_string(entries.size()) + " 个条目（跳过纯色 " + std::to_string(flat) + "），"
+           + std::to_string((offset + entries.size() * sizeof(PackEntry)) / 1024) + " KB";
+    return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#include "MappedFile.h"
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// 模板包格式（小端，离线生成，运行时只读内存映射）
+//   PackHeader + skinCount × PackSkin + 模板数据（各自 16 字节对齐）+ entryCount × PackEntry
+// 每个模板是某皮肤、某格子尺寸下一个格值的格子内圈图像：float32、零均值、L2 范数为 1，
+// 与同尺寸灰度块做点积再除以块的去均值范数即 TM_CCOEFF_NORMED 得分，运行时无需解码与缩放。
+// 索引按 (cellSize, skin, label) 排序
+#pragma pack(push, 1)
+struct PackHeader {
+    char magic[8];          // "MSTPK\0\0\1"
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t skinCount;
+    uint32_t reserved;
+    uint64_t indexOffset;   // PackEntry 数组的偏移
+};
+
+struct PackSkin {
+    char name[32];          // 以 0 结尾
+};
+
+struct PackEntry {
+    int16_t label;          // 格值：1–8 数字，9 未打开，10 旗子，-1 地雷（同 GameState）
+    uint16_t skin;
+    uint16_t cellSize;      // 格子边长（像素）
+    uint16_t size;          // 模板边长 = InnerSize(cellSize)
+    uint32_t reserved;
+    uint64_t offset;        // size × size 个 float
+};
+#pragma pack(pop)
+
+class TemplatePack {
+public:
+    static const uint32_t kVersion = 1;
+
+    // 与运行时裁剪一致：去掉一圈边界，避免格线干扰
+    static int InnerInset(int cellSize) { return std::max(1, cellSize / 12); }
+    static int InnerSize(int cellSize) { return std::max(1, cellSize - 2 * InnerInset(cellSize)); }
+
+    struct Template {
+        int label;
+        int skin;
+        const float* data;  // 指向映射内存
+    };
+    // 同一格子尺寸下的全部模板（各皮肤、各格值）
+    struct Scale {
+        int cellSize = 0;
+        int size = 0;
+        std::vector<Template> templates;
+    };
+
+    bool Open(const std::filesystem::path& path);
+    void Close();
+    bool IsOpen() const { return m_file.IsOpen(); }
+
+    // 与 cellSize 最接近的尺度；未加载时为 nullptr
+    const Scale* Nearest(int cellSize) const;
+    // gray 为 Scale::size 见方的 CV_8UC1 块；返回得分最高的格值，score 为其得分。
+    // 块近乎纯色（无纹理）时返回 0 且 score 为 -1，交由调用方回退
+    static int Match(const Scale& scale, const cv::Mat& gray, double* score);
+
+    const std::vector<std::string>& Skins() const { return m_skins; }
+    size_t TemplateCount() const { return m_count; }
+    size_t SizeBytes() const { return m_file.Size(); }
+
+    // 离线打包：srcDir 根目录为 "default" 皮肤，每个子目录为一种皮肤；
+    // 文件名 1–8、flag、mine、unopened（.png/.bmp），内容为整个格子的截图。
+    // 为 [minCell, maxCell] 内每个整数格子尺寸生成模板。report 输出统计或错误原因
+    struct BuildOptions {
+        int minCell = 8;
+        int maxCell = 96;
+    };
+    static bool Build(const std::filesystem::path& srcDir, const std::filesystem::path& outPath,
+                      const BuildOptions& options, std::string& report);
+
+private:
+    MappedFile m_file;
+    std::vector<Scale> m_scales;   // 按 cellSize 递增
+    std::vector<std::string> m_skins;
+    size_t m_count = 0;
+};
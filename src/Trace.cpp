@@ -0,0 +1,178 @@
+#include "Trace.h"
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace trace {
+
+std::atomic<bool> g_enabled{false};
+
+static const size_t kEventsPerThread = size_t(1) << 16; // 每线程保留最近的事件数（满后覆盖最旧）
+static const char* kFlowName = "frame";
+
+namespace {
+
+struct Event {
+    const char* name;
+    int64_t tsNs;    // 相对 origin
+    int64_t durNs;   // 仅 'X'
+    uint64_t id;     // 仅流事件
+    char ph;
+};
+
+struct ThreadBuffer {
+    int tid = 0;
+    std::string name;
+    std::mutex mutex;           // 只在导出/清空时与本线程竞争
+    std::vector<Event> events;  // 环形，首次记录时分配
+    size_t next = 0;
+    bool wrapped = false;
+    std::atomic<bool> exited{false};
+
+    void Push(const Event& e) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (events.empty()) events.resize(kEventsPerThread);
+        events[next] = e;
+        if (++next == events.size()) { next = 0; wrapped = true; }
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    int nextTid = 1;
+    const Clock::time_point origin = Clock::now();
+};
+
+// 有意不析构：退出阶段的静态析构中仍可能有埋点
+Registry& registry() {
+    static Registry* r = new Registry();
+    return *r;
+}
+
+struct ThreadHolder {
+    std::shared_ptr<ThreadBuffer> buffer;
+    ~ThreadHolder() { if (buffer) buffer->exited.store(true); }
+};
+thread_local ThreadHolder t_holder;
+
+ThreadBuffer& local() {
+    if (!t_holder.buffer) {
+        auto buf = std::make_shared<ThreadBuffer>();
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        buf->tid = r.nextTid++;
+        r.threads.push_back(buf);
+        t_holder.buffer = buf;
+    }
+    return *t_holder.buffer;
+}
+
+int64_t sinceOrigin(Clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t - registry().origin).count();
+}
+
+void writeEscaped(std::ostream& os, const std::string& s) {
+    os << '"';
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') os << '\\' << c;
+        else if (c < 0x20) { char buf[8]; std::snprintf(buf, sizeof(buf), "\\u%04x", c); os << buf; }
+        else os << c;
+    }
+    os << '"';
+}
+
+void writeUs(std::ostream& os, int64_t ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", ns / 1000.0);
+    os << buf;
+}
+
+}
+
+void Start() {
+    Registry& r = registry();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        // 丢弃已退出线程的缓冲，其余清空
+        std::vector<std::shared_ptr<ThreadBuffer>> alive;
+        for (auto& t : r.threads) {
+            if (t->exited.load()) continue;
+            std::lock_guard<std::mutex> tl(t->mutex);
+            t->next = 0;
+            t->wrapped = false;
+            alive.push_back(t);
+        }
+        r.threads.swap(alive);
+    }
+    g_enabled.store(true);
+}
+
+void Stop() {
+    g_enabled.store(false);
+}
+
+void SetThreadName(const std::string& name) {
+    ThreadBuffer& b = local();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    b.name = name;
+}
+
+void Complete(const char* name, Clock::time_point begin, Clock::time_point end) {
+    const int64_t t0 = sinceOrigin(begin);
+    local().Push(Event{ name, t0, sinceOrigin(end) - t0, 0, 'X' });
+}
+
+void Flow(char phase, uint64_t id) {
+    if (id == 0) return;
+    local().Push(Event{ kFlowName, sinceOrigin(Clock::now()), 0, id, phase });
+}
+
+bool Write(const std::string& path) {
+    std::ofstream os(path, std::ios::binary);
+    if (!os) return false;
+    Registry& r = registry();
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        threads = r.threads;
+    }
+    os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    os << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"MinesweeperAssistant\"}}";
+    std::vector<Event> events;
+    for (auto& t : threads) {
+        std::string name;
+        {
+            // 拷出后立即释放，避免导出期间阻塞该线程的埋点
+            std::lock_guard<std::mutex> lock(t->mutex);
+            name = t->name;
+            events.clear();
+            if (t->wrapped) events.insert(events.end(), t->events.begin() + t->next, t->events.end());
+            events.insert(events.end(), t->events.begin(), t->events.begin() + t->next);
+        }
+        if (events.empty() && name.empty()) continue;
+        os << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << t->tid << ",\"args\":{\"name\":";
+        writeEscaped(os, name.empty() ? "thread " + std::to_string(t->tid) : name);
+        os << "}}";
+        for (const Event& e : events) {
+            os << ",\n{\"name\":";
+            writeEscaped(os, e.name);
+            os << ",\"ph\":\"" << e.ph << "\",\"pid\":1,\"tid\":" << t->tid << ",\"ts\":";
+            writeUs(os, e.tsNs);
+            if (e.ph == 'X') {
+                os << ",\"dur\":";
+                writeUs(os, e.durNs);
+            } else {
+                // 绑定到所在区间（而非下一个区间）
+                os << ",\"cat\":\"flow\",\"id\":" << e.id << ",\"bp\":\"e\"";
+            }
+            os << "}";
+        }
+    }
+    os << "\n]}\n";
+    return bool(os);
+}
+
+}
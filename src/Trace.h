@@ -0,0 +1,55 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// 时间线追踪：各线程把完整区间（Chrome trace 的 "X" 事件）与流事件写进本线程的环形缓冲，
+// 按需导出为 Chrome trace JSON（chrome://tracing、ui.perfetto.dev 可直接打开）。
+// 未开启时每个埋点只有一次原子读 + 分支，可常驻发布构建
+namespace trace {
+
+extern std::atomic<bool> g_enabled;
+inline bool Enabled() { return g_enabled.load(std::memory_order_relaxed); }
+
+using Clock = std::chrono::steady_clock;
+
+// 清空各线程缓冲并开始记录 / 停止记录（缓冲保留，可随后导出）
+void Start();
+void Stop();
+// 写出 Chrome trace JSON；返回是否成功
+bool Write(const std::string& path);
+
+// 当前线程在时间线中的名称（捕获、分析、输入、界面等）
+void SetThreadName(const std::string& name);
+
+// name 须为静态字符串（字面量或静态表），只保存指针
+void Complete(const char* name, Clock::time_point begin, Clock::time_point end);
+// 流事件：'s' 起点、't' 中间步、'f' 终点；须落在本线程某个区间之内，查看器据此连线
+void Flow(char phase, uint64_t id);
+
+// 帧的流 id：目标编号 + 帧序号，跨目标不冲突
+inline uint64_t FlowId(int owner, uint64_t seq) {
+    return (uint64_t(uint32_t(owner)) << 40) | (seq & ((uint64_t(1) << 40) - 1));
+}
+
+class Span {
+public:
+    explicit Span(const char* name) : m_name(name), m_on(Enabled()) {
+        if (m_on) m_t0 = Clock::now();
+    }
+    ~Span() { if (m_on) Complete(m_name, m_t0, Clock::now()); }
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+private:
+    const char* m_name;
+    bool m_on;
+    Clock::time_point m_t0;
+};
+
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(name) ::trace::Span TRACE_CONCAT(traceSpan_, __LINE__)(name)
+#define TRACE_FLOW(phase, id) do { if (::trace::Enabled()) ::trace::Flow(phase, id); } while (0)
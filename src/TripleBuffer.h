@@ -0,0 +1,42 @@
+#pragma once
+#include <array>
+#include <atomic>
+
+// 单生产者/单消费者三缓冲。
+// 生产者独占 back 槽写入，Publish() 用一次原子交换把它与 middle 槽互换并打上“新帧”标记；
+// 消费者 Acquire() 在有新帧时把 front 与 middle 互换。两端都不加锁、不拷贝、互不阻塞，
+// 消费者总能拿到最新发布的一帧（中间未取走的帧被覆盖）。
+template <typename T>
+class TripleBuffer {
+public:
+    // 槽位与索引一一对应，外部可据此为每个槽预分配资源（如捕获 DIB）
+    T& Slot(int index) { return m_slots[index]; }
+
+    // —— 生产者 ——
+    int BackIndex() const { return m_back; }
+    T& Back() { return m_slots[m_back]; }
+    void Publish() {
+        int prev = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel);
+        m_back = prev & kIndexMask;
+    }
+
+    // —— 消费者 ——
+    // 有新帧则切换 front 并返回 true；否则 front 保持上一帧
+    bool Acquire() {
+        if (!(m_middle.load(std::memory_order_acquire) & kFresh)) return false;
+        int prev = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = prev & kIndexMask;
+        return true;
+    }
+    int FrontIndex() const { return m_front; }
+    T& Front() { return m_slots[m_front]; }
+
+private:
+    static const int kIndexMask = 0x3;
+    static const int kFresh = 0x4;
+
+    std::array<T, 3> m_slots;
+    int m_back = 0;                 // 仅生产者访问
+    int m_front = 1;                // 仅消费者访问
+    std::atomic<int> m_middle{2};   // 交换点：索引 | kFresh
+};
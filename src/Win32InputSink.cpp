@@ -0,0 +1,34 @@
+#include "Win32InputSink.h"
+#include <atomic>
+
+extern std::atomic<bool> g_enableMouseMove;
+extern std::atomic<bool> g_enableAutoClick;
+
+void Win32InputSink::Click(int x, int y, bool rightClick) {
+    if (!m_hwnd) return;
+    if (!g_enableMouseMove.load()) return; // 用户关闭时不控制鼠标
+    // 将客户区坐标转换为屏幕坐标并模拟点击
+    POINT pt{ x, y };
+    ClientToScreen(m_hwnd, &pt);
+
+    INPUT inputMove{};
+    inputMove.type = INPUT_MOUSE;
+    inputMove.mi.dx = LONG(pt.x * (65535.0 / GetSystemMetrics(SM_CXSCREEN)));
+    inputMove.mi.dy = LONG(pt.y * (65535.0 / GetSystemMetrics(SM_CYSCREEN)));
+    inputMove.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
+
+    SendInput(1, &inputMove, sizeof(INPUT));
+    if (!g_enableAutoClick.load()) return; // 未开启自动点击则只移动
+
+    INPUT clickDown{}; clickDown.type = INPUT_MOUSE;
+    INPUT clickUp{};   clickUp.type   = INPUT_MOUSE;
+    if (rightClick) {
+        clickDown.mi.dwFlags = MOUSEEVENTF_RIGHTDOWN;
+        clickUp.mi.dwFlags   = MOUSEEVENTF_RIGHTUP;
+    } else {
+        clickDown.mi.dwFlags = MOUSEEVENTF_LEFTDOWN;
+        clickUp.mi.dwFlags   = MOUSEEVENTF_LEFTUP;
+    }
+    SendInput(1, &clickDown, sizeof(INPUT));
+    SendInput(1, &clickUp, sizeof(INPUT));
+}
@@ -0,0 +1,14 @@
+#pragma once
+#include "InputSink.h"
+#include <windows.h>
+
+// SendInput 实现：客户区坐标转屏幕坐标后移动并点击。
+// 受全局开关约束：鼠标控制关闭时不动作，自动点击关闭时只移动不点击
+class Win32InputSink : public InputSink {
+public:
+    explicit Win32InputSink(HWND hwnd) : m_hwnd(hwnd) {}
+    void Click(int x, int y, bool rightClick = false) override;
+
+private:
+    HWND m_hwnd;
+};
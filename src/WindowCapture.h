@@ -1,46 +1,64 @@
 #ifndef WINDOW_CAPTURE_H
 #define WINDOW_CAPTURE_H
 
+#include "BoardLocator.h"
 #include <windows.h>
 #include <opencv2/opencv.hpp>
 #include <string>
 #include <atomic>
+#include <mutex>
 
-class WindowCapture {
+// Win32 窗口捕获；棋盘定位等图像处理继承自平台无关的 BoardLocator
+class WindowCapture : public BoardLocator {
 public:
     WindowCapture();
     ~WindowCapture();
 
     HWND SelectGameWindow();
-    bool CaptureGameArea(cv::Mat& output);
-    bool IdentifyGameBounds(const cv::Mat& screenCapture, cv::Rect& gameRect);
-    bool AnalyzeGridLayout(const cv::Mat& gameArea, int& rows, int& cols);
-    bool RefineBoardArea(const cv::Mat& roiImage, cv::Rect& gridRect);
-    // 新增：更精确的网格布局识别，输出行列数以及裁剪后的纯棋盘内矩形
-    bool AnalyzeGridLayoutEx(const cv::Mat& boardImage, int& rows, int& cols, cv::Rect& innerRect);
-    // 新增：提取 HUD 计时器的签名；用于检测计时器变化触发重识别
-    bool ExtractHudTimerSignature(const cv::Mat& roiImage, uint64_t& signature);
-    // 新增：比较 HUD 是否变化（内部保存上一帧签名）
-    bool HasHudChanged(const cv::Mat& roiImage);
+    // 捕获客户区；布局锁定后仅捕获棋盘区域。captureRect 输出 output 在客户区中的位置。
+    // output 直接引用第 surface 组 DIB 像素（不拷贝），在下一次以同一 surface 调用前有效；
+    // 调用方可轮换 surface（如三缓冲槽位）让消费者持有的帧不被覆盖
+    static const int kSurfaceCount = 3;
+    bool CaptureGameArea(cv::Mat& output, cv::Rect* captureRect = nullptr, int surface = 0);
 
-    void SetGameWindow(HWND hwnd) { m_gameHwnd = hwnd; }
+    void SetGameWindow(HWND hwnd) { m_gameHwnd = hwnd; SetBoardRegion(cv::Rect()); }
     HWND GetGameWindow() const { return m_gameHwnd; }
     const std::wstring& GetLastCaptureMethod() const { return m_lastCaptureMethod; }
-    const std::wstring& GetLastHudMethod() const { return m_lastHudMethod; }
-    // HUD 顶部高度比例（百分比，默认 35）
-    void SetHudTopRatioPercent(int p);
-    int GetHudTopRatioPercent() const;
+    // 已锁定的棋盘区域（客户区坐标，含 HUD），由分析线程写入，捕获线程读取；
+    // 置空或客户区尺寸变化后回退整客户区捕获
+    void SetBoardRegion(const cv::Rect& region);
+    cv::Rect GetBoardRegion() const;
 
 private:
+    // 持久化 GDI 捕获面：DIB section 像素由 cv::Mat 直接包装，仅尺寸变化时重建
+    struct DibSurface {
+        HDC dc = NULL;
+        HBITMAP bitmap = NULL;
+        HGDIOBJ oldObj = NULL;
+        void* bits = nullptr;
+        int width = 0, height = 0;
+        cv::Mat view; // 不拥有内存
+    };
+    bool EnsureSurface(DibSurface& s, int width, int height);
+    static void ReleaseSurface(DibSurface& s);
+    bool CaptureRegion(const cv::Rect& roi, int clientW, int clientH, int surface, cv::Mat& output);
+    cv::Rect GetCaptureRegion(int clientW, int clientH);
+
     HWND m_gameHwnd;
     cv::Rect m_gameRect;
     int m_rows, m_cols;
     std::wstring m_lastCaptureMethod; // "PW" or "BitBlt"
-    std::wstring m_lastHudMethod; // "red" or "edges" or "none"
-    // HUD 签名缓存
-    uint64_t m_lastHudSignature = 0;
-    bool m_hasHudSignature = false;
-    std::atomic<int> m_hudTopRatioPercent; // 35 by default
+    // 以下仅由捕获线程访问
+    HDC m_screenDC = NULL;
+    DibSurface m_fullSurface[kSurfaceCount]; // 整客户区（PrintWindow 目标）
+    DibSurface m_roiSurface[kSurfaceCount];  // ROI 模式下 BitBlt 目标
+    // ROI 模式下屏幕 BitBlt 已与 PrintWindow 比对一致：此后只按 ROI 拷贝，每隔若干帧重新比对
+    static const int kRoiBlitRecheckFrames = 120;
+    bool m_roiBlitTrusted = false;
+    int m_roiBlitFrames = 0;
+    mutable std::mutex m_regionMutex;
+    cv::Rect m_boardRegion;
+    SIZE m_regionClientSize{0, 0}; // 锁定时的客户区尺寸
 };
 
 #endif
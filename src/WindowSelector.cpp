@@ -28,7 +28,7 @@ static BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
 std::vector<WindowCandidate> WindowSelector::ScanCandidates() {
     std::vector<WindowCandidate> out;
     EnumWindows(EnumWindowsProc, reinterpret_cast<LPARAM>(&out));
-    LOGI("ScanCandidates count=" + std::to_string(out.size()));
+    LOGI("ScanCandidates count={}", out.size());
     return out;
 }
 
@@ -52,7 +52,7 @@ std::vector<WindowCandidate> WindowSelector::FilterMinesweeper(const std::vector
             }
         }
     }
-    LOGI("FilterMinesweeper matched=" + std::to_string(out.size()));
+    LOGI("FilterMinesweeper matched={}", out.size());
     return out;
 }
 
@@ -105,7 +105,7 @@ HWND WindowSelector::AutoPick() {
         const auto& w = filtered[i];
         for (const auto& m : ms) {
             if (m.hwnd == w.hwnd) {
-                LOGI("AutoPick matched by title/class at z-index=" + std::to_string(i));
+                LOGI("AutoPick matched by title/class at z-index={}", i);
                 return GetAncestor(w.hwnd, GA_ROOT);
             }
         }
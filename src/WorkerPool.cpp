@@ -0,0 +1,100 @@
+#include "WorkerPool.h"
+#include "Trace.h"
+#include <algorithm>
+
+WorkerPool::WorkerPool(int threads) {
+    if (threads <= 0) threads = std::max(1, int(std::thread::hardware_concurrency()) / 2);
+    for (int i = 0; i < threads; ++i) {
+        m_threads.emplace_back([this, i] {
+            trace::SetThreadName("worker " + std::to_string(i));
+            WorkerLoop();
+        });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto& t : m_threads) t.join();
+}
+
+WorkerPool::Owner* WorkerPool::Find(int owner) {
+    for (auto& o : m_owners) if (o.id == owner) return &o;
+    return nullptr;
+}
+
+int WorkerPool::Register() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Owner o;
+    o.id = m_nextId++;
+    o.active = true;
+    m_owners.push_back(std::move(o));
+    return m_owners.back().id;
+}
+
+void WorkerPool::Unregister(int owner) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    Owner* o = Find(owner);
+    if (!o) return;
+    o->active = false;
+    o->pending = nullptr;
+    m_idle.wait(lock, [&]{ Owner* cur = Find(owner); return !cur || !cur->running; });
+    auto it = std::find_if(m_owners.begin(), m_owners.end(), [&](const Owner& x){ return x.id == owner; });
+    if (it != m_owners.end()) {
+        size_t idx = size_t(it - m_owners.begin());
+        m_owners.erase(it);
+        if (m_cursor > idx) m_cursor--;
+        if (m_cursor >= m_owners.size()) m_cursor = 0;
+    }
+}
+
+void WorkerPool::Submit(int owner, std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Owner* o = Find(owner);
+        if (!o || !o->active) return;
+        if (o->pending) m_coalesced++;
+        o->pending = std::move(job);
+    }
+    m_cv.notify_one();
+}
+
+void WorkerPool::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        // 从游标开始轮转查找：有待办任务且当前没有任务在执行的 owner
+        Owner* next = nullptr;
+        const size_t n = m_owners.size();
+        for (size_t k = 0; k < n; ++k) {
+            Owner& o = m_owners[(m_cursor + k) % n];
+            if (o.active && o.pending && !o.running) {
+                next = &o;
+                m_cursor = (m_cursor + k + 1) % n;
+                break;
+            }
+        }
+        if (!next) {
+            if (m_stop) return;
+            m_cv.wait(lock);
+            continue;
+        }
+        const int id = next->id;
+        std::function<void()> job = std::move(next->pending);
+        next->pending = nullptr;
+        next->running = true;
+        lock.unlock();
+        job();
+        m_executed++;
+        lock.lock();
+        // 执行期间 m_owners 可能增删，按 id 重新查找
+        if (Owner* o = Find(id)) {
+            o->running = false;
+            // 执行期间又有新任务：唤醒其它线程（本线程也会在下一轮看到）
+            if (o->pending) m_cv.notify_one();
+        }
+        m_idle.notify_all();
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 多目标共享的工作线程池。
+// 每个提交者（owner，对应一个棋盘流水线）同一时刻最多一个任务在执行、最多一个在排队：
+// 新提交会替换尚未开始的旧任务（只分析最新帧），因此同一 owner 的任务天然串行、无需加锁。
+// 空闲线程从轮转游标开始挑选下一个有待办任务的 owner，各 owner 轮流获得执行机会；
+// 画面静止的棋盘不提交任务，不占用线程
+class WorkerPool {
+public:
+    // threads <= 0：取硬件线程数的一半（至少 1）
+    explicit WorkerPool(int threads = 0);
+    ~WorkerPool();
+
+    int Register();
+    // 丢弃该 owner 未开始的任务，并等待其正在执行的任务结束
+    void Unregister(int owner);
+    void Submit(int owner, std::function<void()> job);
+
+    int ThreadCount() const { return (int)m_threads.size(); }
+    uint64_t Executed() const { return m_executed.load(); }
+    uint64_t Coalesced() const { return m_coalesced.load(); }
+
+private:
+    struct Owner {
+        int id = 0;
+        bool active = false;
+        bool running = false;
+        std::function<void()> pending;
+    };
+
+    void WorkerLoop();
+    Owner* Find(int owner);
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;     // 有新任务 / 停止
+    std::condition_variable m_idle;   // 某 owner 的任务结束（Unregister 等待）
+    std::vector<Owner> m_owners;      // 轮转顺序
+    size_t m_cursor = 0;
+    int m_nextId = 1;
+    bool m_stop = false;
+    std::vector<std::thread> m_threads;
+    std::atomic<uint64_t> m_executed{0};
+    std::atomic<uint64_t> m_coalesced{0};
+};
@@ -0,0 +1,452 @@
+// 无界面命令行：对图片 / 目录 / 视频 / 会话录制逐帧执行
+// 定位 → 细化 → 布局 → 识别 → 求解，输出每帧结果与各阶段延迟分布。
+// 不依赖 Win32，可在 Linux 上用于性能分析、基准与压测。
+#include "FramePipeline.h"
+#include "ControlServer.h"
+#include "InputExecutor.h"
+#include "MockInputSink.h"
+#include "BoardRenderer.h"
+#include "SessionRecorder.h"
+#include "Metrics.h"
+#include "MetricsServer.h"
+#include "Trace.h"
+#include "AllocCounter.h"
+#include "FrameArena.h"
+#include "BoundedQueue.h"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct CliOptions {
+    std::vector<std::string> inputs;
+    int repeat = 1;           // 每个输入重复次数（基准用）
+    bool lockLayout = false;  // 首帧布局成功后沿用，模拟实时模式
+    bool quiet = false;       // 不逐帧输出
+    bool mockInput = false;   // 安全格交给输入执行器派发到记录型输入（不注入真实事件）
+    std::string renderDir;    // 非空时逐帧离屏渲染棋盘并导出 PNG
+    std::string tracePath;    // 非空时记录时间线并在结束时写出 Chrome trace JSON
+    std::string batchOut;     // 非空时为批处理模式：每张图一行 JSON 记录写到该文件（"-" 为标准输出）
+    int jobs = 0;             // 批处理每个阶段的线程数，0 取硬件线程数
+    int metricsPort = 0;      // 非 0 时运行期间在 127.0.0.1 上提供 Prometheus 指标
+    int servePort = 0;        // 非 0 时不处理输入，在 127.0.0.1 上提供控制/识别接口直到收到 quit
+    bool fullCells = false;   // 关闭稀疏探针，逐格整格分析（对照准确率与耗时）
+    int board = 0;            // 一张图里有多块棋盘时识别第几块（阅读顺序）
+};
+
+static void printUsage() {
+    std::cout <<
+        "用法: MinesweeperCli [选项] <图片|目录|视频|录制基名>...\n"
+        "  --repeat N       每个输入重复 N 次\n"
+        "  --lock-layout    布局成功后沿用（同一输入内），逐帧校验网格线，不符时重新识别\n"
+        "  --quiet          只输出汇总\n"
+        "  --mock-input     安全格经输入执行器派发到记录型输入，并用后续帧核对\n"
+        "  --render DIR     逐帧增量渲染棋盘，导出 DIR/frame_NNNNNN.png\n"
+        "  --trace FILE     记录各阶段时间线，结束时写出 Chrome trace JSON\n"
+        "  --batch OUT      批处理：图片/目录/@列表文件 经解码、识别两级线程并行处理，\n"
+        "                   每张图一行 JSON 写到 OUT（- 为标准输出），按完成顺序输出\n"
+        "  --jobs N         批处理每级线程数 / --serve 识别线程数（默认硬件线程数）\n"
+        "  --metrics-port N 运行期间在 http://127.0.0.1:N/metrics 提供 Prometheus 指标\n"
+        "  --serve PORT     不处理输入，在 127.0.0.1:PORT 提供识别接口（协议见 README），quit 命令退出\n"
+        "  --full-cells     关闭稀疏探针，每格都做整格分析\n"
+        "  --board N        图中有多块棋盘时识别第 N 块（自上而下、自左向右，从 0 起）\n"
+        "录制基名指不带扩展名的 recordings/session_xxx（需存在 .msrec/.msidx）\n"
+        "@列表文件每行一个图片路径或目录\n";
+}
+
+static bool parseArgs(int argc, char** argv, CliOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--repeat" && i + 1 < argc) opt.repeat = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--lock-layout") opt.lockLayout = true;
+        else if (a == "--quiet") opt.quiet = true;
+        else if (a == "--mock-input") opt.mockInput = true;
+        else if (a == "--render" && i + 1 < argc) opt.renderDir = argv[++i];
+        else if (a == "--trace" && i + 1 < argc) opt.tracePath = argv[++i];
+        else if (a == "--batch" && i + 1 < argc) opt.batchOut = argv[++i];
+        else if (a == "--jobs" && i + 1 < argc) opt.jobs = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--metrics-port" && i + 1 < argc) opt.metricsPort = std::atoi(argv[++i]);
+        else if (a == "--serve" && i + 1 < argc) opt.servePort = std::atoi(argv[++i]);
+        else if (a == "--full-cells") opt.fullCells = true;
+        else if (a == "--board" && i + 1 < argc) opt.board = std::max(0, std::atoi(argv[++i]));
+        else if (a == "-h" || a == "--help") return false;
+        else if (!a.empty() && a[0] == '-') { std::cerr << "未知选项: " << a << "\n"; return false; }
+        else opt.inputs.push_back(a);
+    }
+    if (!opt.batchOut.empty() && (opt.mockInput || !opt.renderDir.empty())) {
+        std::cerr << "--batch 不能与 --mock-input / --render 同时使用\n";
+        return false;
+    }
+    if (opt.servePort != 0) {
+        if (opt.servePort < 0 || opt.servePort > 65535) { std::cerr << "--serve 端口无效\n"; return false; }
+        return opt.inputs.empty() && opt.batchOut.empty();
+    }
+    return !opt.inputs.empty();
+}
+
+static bool hasExt(const fs::path& p, std::initializer_list<const char*> exts) {
+    std::string e = p.extension().string();
+    std::transform(e.begin(), e.end(), e.begin(), [](unsigned char c){ return char(std::tolower(c)); });
+    for (const char* x : exts) if (e == x) return true;
+    return false;
+}
+
+static bool isImage(const fs::path& p) { return hasExt(p, {".png", ".jpg", ".jpeg", ".bmp"}); }
+static bool isVideo(const fs::path& p) { return hasExt(p, {".mp4", ".avi", ".mkv", ".mov"}); }
+
+struct RunTotals {
+    uint64_t frames = 0;
+    uint64_t failed = 0;
+};
+
+static void reportFrame(const CliOptions& opt, const std::string& label, bool ok,
+                        const GameState& state, const cv::Rect& board) {
+    if (opt.quiet) return;
+    if (!ok) { std::cout << label << "\tFAIL\n"; return; }
+    std::cout << label << "\tboard=" << board.x << "," << board.y << " " << board.width << "x" << board.height
+              << "\tgrid=" << state.rows << "x" << state.cols
+              << "\texplored=" << state.exploredPercent << "%"
+              << "\tsafe=" << state.safeCells.size() << "\n";
+}
+
+// 识别成功后的下游：输入执行器与离屏渲染均可选
+struct FrameOutputs {
+    InputExecutor* executor = nullptr;
+    BoardRenderer* renderer = nullptr;
+    fs::path renderDir;
+};
+
+// 先核对已派发的点击，再提交本帧安全格；渲染只重绘变化格子，PNG 写盘不计入渲染耗时
+static void emitFrame(FrameOutputs& out, const GameState& state, const cv::Rect& board, uint64_t frameIndex) {
+    if (out.executor) {
+        TRACE_SPAN("submit");
+        const uint64_t flow = trace::FlowId(0, frameIndex + 1);
+        TRACE_FLOW('s', flow);
+        out.executor->OnState(state, InputExecutor::Clock::now());
+        out.executor->Submit(board, state.rows, state.cols, state.safeCells, false, flow);
+    }
+    if (out.renderer) {
+        {
+            STAGE_TIMER(Render);
+            out.renderer->Update(state);
+        }
+        char name[32];
+        std::snprintf(name, sizeof(name), "frame_%06llu.png", (unsigned long long)frameIndex);
+        if (!out.renderer->SavePng((out.renderDir / name).string()))
+            std::cerr << "无法写入: " << (out.renderDir / name).string() << "\n";
+    }
+}
+
+// 逐帧驱动：next 返回 false 表示流结束
+static void runStream(const CliOptions& opt, GameAnalyzer& analyzer, FrameOutputs& out, const std::string& name,
+                      const std::function<bool(cv::Mat&)>& next, RunTotals& totals) {
+    FramePipeline pipeline(analyzer, opt.lockLayout);
+    pipeline.SetBoardIndex(opt.board);
+    GameState state;
+    cv::Mat frame;
+    for (uint64_t i = 0; next(frame); ++i) {
+        cv::Rect board;
+        bool ok = pipeline.Process(frame, state, board);
+        totals.frames++;
+        if (!ok) totals.failed++;
+        else emitFrame(out, state, board, totals.frames - 1);
+        reportFrame(opt, name + "#" + std::to_string(i), ok, state, board);
+    }
+}
+
+static void runInput(const CliOptions& opt, GameAnalyzer& analyzer, FrameOutputs& out, const fs::path& input,
+                     RunTotals& totals) {
+    std::error_code ec;
+    if (fs::is_directory(input, ec)) {
+        std::vector<fs::path> files;
+        for (auto& e : fs::directory_iterator(input, ec))
+            if (e.is_regular_file() && isImage(e.path())) files.push_back(e.path());
+        std::sort(files.begin(), files.end());
+        for (auto& f : files) runInput(opt, analyzer, out, f, totals);
+        return;
+    }
+    fs::path msrec = input; msrec += ".msrec";
+    if (fs::exists(msrec, ec)) {
+        SessionPlayer player;
+        if (!player.Open(input)) { std::cerr << "无法打开录制: " << input.string() << "\n"; return; }
+        size_t index = 0;
+        runStream(opt, analyzer, out, input.filename().string(), [&](cv::Mat& frame) {
+            return index < player.FrameCount() && player.FrameByIndex(index++, frame);
+        }, totals);
+        return;
+    }
+    if (isVideo(input)) {
+        cv::VideoCapture vc(input.string());
+        if (!vc.isOpened()) { std::cerr << "无法打开视频: " << input.string() << "\n"; return; }
+        runStream(opt, analyzer, out, input.filename().string(), [&](cv::Mat& frame) { return vc.read(frame); }, totals);
+        return;
+    }
+    cv::Mat img = cv::imread(input.string(), cv::IMREAD_COLOR);
+    if (img.empty()) { std::cerr << "无法读取: " << input.string() << "\n"; totals.failed++; return; }
+    // 单张图片：每次重复都是独立的一帧，不沿用布局
+    FramePipeline pipeline(analyzer, false);
+    pipeline.SetBoardIndex(opt.board);
+    GameState state;
+    cv::Rect board;
+    bool ok = pipeline.Process(img, state, board);
+    totals.frames++;
+    if (!ok) totals.failed++;
+    else emitFrame(out, state, board, totals.frames - 1);
+    reportFrame(opt, input.string(), ok, state, board);
+}
+
+// ---- 批处理 ----
+// 列举 → 解码（jobs 线程）→ 定位/细化/布局/识别/求解（jobs 线程）→ 写出（主线程），
+// 各级之间是有界队列：在途的解码图像至多约 4 × jobs 张，与输入规模无关；
+// 目录与列表文件边遍历边入队，不预先收集路径
+
+struct BatchItem {
+    uint64_t index = 0;
+    std::string path;
+    cv::Mat image;       // 解码失败时为空
+};
+
+struct BatchRecord {
+    bool ok = false;
+    std::string line;
+};
+
+static std::string batchRecord(const BatchItem& item, bool ok, const GameState& state, const cv::Rect& board,
+                               double ms) {
+    std::string r = "{\"i\":" + std::to_string(item.index) + ",\"file\":";
+    AppendJsonString(r, item.path);
+    if (item.image.empty()) return r + ",\"ok\":0,\"error\":\"decode\"}";
+    if (!ok) return r + ",\"ok\":0,\"error\":\"analyze\"}";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), ",\"ok\":1,\"ms\":%.2f,", ms);
+    r += buf;
+    AppendBoardJson(r, state, board);
+    return r + "}";
+}
+
+// 展开输入（目录、@列表文件、图片）并逐个交给 emit；emit 返回 false（下游已关闭）时停止
+static bool listBatchInput(const std::string& input, const std::function<bool(const std::string&)>& emit) {
+    if (!input.empty() && input[0] == '@') {
+        std::ifstream list(input.substr(1));
+        if (!list) { std::cerr << "无法读取列表: " << input.substr(1) << "\n"; return true; }
+        std::string line;
+        while (std::getline(list, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+            if (!listBatchInput(line, emit)) return false;
+        }
+        return true;
+    }
+    std::error_code ec;
+    if (fs::is_directory(input, ec)) {
+        for (auto& e : fs::directory_iterator(input, ec))
+            if (e.is_regular_file() && isImage(e.path()) && !emit(e.path().string())) return false;
+        return true;
+    }
+    return emit(input);
+}
+
+static void runBatch(const CliOptions& opt, GameAnalyzer& analyzer, RunTotals& totals) {
+    std::ofstream file;
+    std::ostream* os = &std::cout;
+    if (opt.batchOut != "-") {
+        file.open(opt.batchOut, std::ios::binary | std::ios::trunc);
+        if (!file) { std::cerr << "无法写入: " << opt.batchOut << "\n"; totals.failed++; return; }
+        os = &file;
+    }
+    const int jobs = opt.jobs > 0 ? opt.jobs : std::max(1, int(std::thread::hardware_concurrency()));
+    // 并行放在图片级：关掉 OpenCV 内部的线程，避免 jobs × 内部线程的超额订阅
+    cv::setNumThreads(1);
+
+    BoundedQueue<BatchItem> paths(size_t(jobs) * 4);
+    BoundedQueue<BatchItem> frames(size_t(jobs) * 2);
+    BoundedQueue<BatchRecord> records(size_t(jobs) * 4);
+
+    std::thread lister([&] {
+        trace::SetThreadName("list");
+        uint64_t index = 0;
+        for (int r = 0; r < opt.repeat; ++r) {
+            bool more = true;
+            for (auto& in : opt.inputs) {
+                more = listBatchInput(in, [&](const std::string& p) {
+                    BatchItem item;
+                    item.index = index++;
+                    item.path = p;
+                    return paths.Push(std::move(item));
+                });
+                if (!more) break;
+            }
+            if (!more) break;
+        }
+        paths.Close();
+    });
+
+    // 每级最后一个退出的线程关闭下游队列
+    std::atomic<int> decodersLeft{jobs}, analyzersLeft{jobs};
+    std::vector<std::thread> workers;
+    for (int i = 0; i < jobs; ++i) {
+        workers.emplace_back([&, i] {
+            trace::SetThreadName("decode " + std::to_string(i));
+            BatchItem item;
+            while (paths.Pop(item)) {
+                {
+                    STAGE_TIMER(Decode);
+                    item.image = cv::imread(item.path, cv::IMREAD_COLOR);
+                }
+                if (!frames.Push(std::move(item))) break;
+            }
+            if (--decodersLeft == 0) frames.Close();
+        });
+    }
+    for (int i = 0; i < jobs; ++i) {
+        workers.emplace_back([&, i] {
+            trace::SetThreadName("analyze " + std::to_string(i));
+            // 每个线程一条流水线，帧级缓冲跨图片复用；图片之间互不沿用布局
+            FramePipeline pipeline(analyzer, false);
+            pipeline.SetBoardIndex(opt.board);
+            GameState state;
+            BatchItem item;
+            while (frames.Pop(item)) {
+                bool ok = false;
+                cv::Rect board;
+                auto t0 = std::chrono::steady_clock::now();
+                if (!item.image.empty()) {
+                    TRACE_SPAN("batch_item");
+                    pipeline.Reset();
+                    state = GameState();
+                    ok = pipeline.Process(item.image, state, board);
+                }
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                BatchRecord rec;
+                rec.ok = ok;
+                rec.line = batchRecord(item, ok, state, board, ms);
+                item.image.release();
+                if (!records.Push(std::move(rec))) break;
+            }
+            if (--analyzersLeft == 0) records.Close();
+        });
+    }
+
+    BatchRecord rec;
+    auto lastReport = std::chrono::steady_clock::now();
+    while (records.Pop(rec)) {
+        *os << rec.line << '\n';
+        totals.frames++;
+        if (!rec.ok) totals.failed++;
+        auto now = std::chrono::steady_clock::now();
+        if (!opt.quiet && now - lastReport >= std::chrono::seconds(2)) {
+            std::cerr << "已处理 " << totals.frames << "（失败 " << totals.failed << "）\n";
+            lastReport = now;
+        }
+    }
+    lister.join();
+    for (auto& t : workers) t.join();
+    os->flush();
+}
+
+// 无界面识别服务：供本机客户端提交截图做识别/求解压测，quit 命令结束
+static int runServe(const CliOptions& opt, GameAnalyzer& analyzer) {
+    cv::setNumThreads(1); // 并行度由识别线程数决定
+    ControlServer server(analyzer);
+    std::atomic<bool> quit(false);
+    server.Register("quit", [&](const std::vector<std::string>&, std::string& out) {
+        quit.store(true);
+        out = "\"bye\"";
+        return true;
+    });
+    if (!server.Start(uint16_t(opt.servePort), opt.jobs)) {
+        std::cerr << "无法监听控制端口: " << opt.servePort << "\n";
+        return 1;
+    }
+    std::cerr << "识别接口: 127.0.0.1:" << opt.servePort << "（quit 命令退出）\n";
+    while (!quit.load()) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    server.Stop();
+    if (!opt.tracePath.empty()) {
+        trace::Stop();
+        if (!trace::Write(opt.tracePath)) std::cerr << "无法写入时间线: " << opt.tracePath << "\n";
+    }
+    metrics::Dump(std::cout);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    CliOptions opt;
+    if (!parseArgs(argc, argv, opt)) { printUsage(); return 2; }
+    alloccount::Install();
+    FrameArena::Install();
+    trace::SetThreadName("main");
+    if (!opt.tracePath.empty()) trace::Start();
+    MetricsServer metricsServer;
+    if (opt.metricsPort > 0 && opt.metricsPort <= 65535 && !metricsServer.Start(uint16_t(opt.metricsPort)))
+        std::cerr << "无法监听指标端口: " << opt.metricsPort << "\n";
+
+    GameAnalyzer analyzer;
+    analyzer.SetSparseProbes(!opt.fullCells);
+    if (opt.servePort > 0) return runServe(opt, analyzer);
+    MockInputSink mockSink;
+    InputExecutor executor(mockSink);
+    if (opt.mockInput) {
+        InputPacing pacing;
+        pacing.intervalMs = 0; pacing.randomMs = 0; pacing.posJitterPx = 0; // 无界面：不限速
+        executor.SetPacing(pacing);
+        executor.Start();
+    }
+    BoardRenderer renderer;
+    FrameOutputs out;
+    if (opt.mockInput) out.executor = &executor;
+    if (!opt.renderDir.empty()) {
+        std::error_code ec;
+        fs::create_directories(opt.renderDir, ec);
+        out.renderer = &renderer;
+        out.renderDir = opt.renderDir;
+    }
+    RunTotals totals;
+    auto t0 = std::chrono::steady_clock::now();
+    if (!opt.batchOut.empty()) {
+        runBatch(opt, analyzer, totals);
+    } else {
+        for (int r = 0; r < opt.repeat; ++r)
+            for (auto& in : opt.inputs) runInput(opt, analyzer, out, fs::path(in), totals);
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    executor.Stop();
+    if (!opt.tracePath.empty()) {
+        trace::Stop();
+        if (!trace::Write(opt.tracePath)) std::cerr << "无法写入时间线: " << opt.tracePath << "\n";
+    }
+
+    // 批处理记录写到标准输出时，汇总改走标准错误，保持输出为纯 JSON 行
+    std::ostream& summary = opt.batchOut == "-" ? std::cerr : std::cout;
+    summary << "\nframes=" << totals.frames << " failed=" << totals.failed
+            << " elapsed=" << sec << "s fps=" << (sec > 0 ? totals.frames / sec : 0.0);
+    if (alloccount::Enabled() && opt.batchOut.empty())
+        summary << " mat_allocs/frame=" << (totals.frames ? double(alloccount::ThreadMatAllocs()) / totals.frames : 0.0);
+    summary << " arena_peak_kb=" << FrameArena::GlobalPeakBytes() / 1024
+            << " arena_reserved_kb=" << FrameArena::GlobalReservedBytes() / 1024 << "\n";
+    if (opt.mockInput) {
+        InputExecutor::Stats is = executor.GetStats();
+        summary << "clicks=" << mockSink.Events().size() << " dispatched=" << is.dispatched
+                << " confirmed=" << is.confirmed << " retried=" << is.retried
+                << " cancelled=" << is.cancelled << " dropped=" << is.dropped << "\n";
+    }
+    if (out.renderer) {
+        BoardRenderer::Stats rs = renderer.GetStats();
+        summary << "render updates=" << rs.updates << " full=" << rs.fullRedraws
+                << " cells/update=" << (rs.updates ? double(rs.cellsRedrawn) / rs.updates : 0.0) << "\n";
+    }
+    summary << "\n";
+    metrics::Dump(summary);
+    return totals.frames > 0 && totals.failed < totals.frames ? 0 : 1;
+}
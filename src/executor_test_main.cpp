@@ -0,0 +1,174 @@
+// 输入执行器回归测试：以 MockInputSink 代替真实鼠标，验证未派发动作被新一轮结果替换、
+// 画面确认、稳定时间后重试一次再放弃，以及盘面几何变化或出现地雷时整体作废。
+// 不依赖桌面与截图，任一检查失败时退出码为 1（ctest --test-dir build）
+#include "InputExecutor.h"
+#include "MockInputSink.h"
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using Clock = InputExecutor::Clock;
+
+static int g_failures = 0;
+
+#define EXPECT(cond) do { \
+        if (!(cond)) { std::cerr << __FILE__ << ":" << __LINE__ << ": 检查失败: " #cond "\n"; g_failures++; } \
+    } while (0)
+
+// 8×8 棋盘，每格 20 px
+static const cv::Rect kBoard(0, 0, 160, 160);
+static const int kRows = 8, kCols = 8;
+
+static GameState makeState(int fill = 9) {
+    GameState s;
+    s.rows = kRows; s.cols = kCols;
+    s.grid.assign(kRows, std::vector<int>(kCols, fill));
+    return s;
+}
+
+// 点击落点是否在 (列, 行) 格内
+static bool inCell(const MockInputSink::Event& e, const cv::Point& cell) {
+    return e.x >= cell.x * 20 && e.x < (cell.x + 1) * 20 && e.y >= cell.y * 20 && e.y < (cell.y + 1) * 20;
+}
+
+// 等执行线程派发到 n 次（最多 2 秒）
+static bool waitDispatched(const InputExecutor& ex, uint64_t n) {
+    const auto deadline = Clock::now() + std::chrono::seconds(2);
+    while (ex.GetStats().dispatched < n) {
+        if (Clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+static InputPacing noPacing() {
+    InputPacing p;
+    p.intervalMs = 0; p.randomMs = 0; p.posJitterPx = 0;
+    return p;
+}
+
+// 尚未派发的动作由下一轮求解结果整体替换
+static void testReplaceUndispatched() {
+    MockInputSink sink;
+    InputExecutor ex(sink);
+    ex.SetPacing(noPacing());
+    ex.Submit(kBoard, kRows, kCols, { cv::Point(0, 0), cv::Point(1, 0) });
+    EXPECT(ex.Outstanding() == 2);
+    ex.Submit(kBoard, kRows, kCols, { cv::Point(5, 3) });
+    EXPECT(ex.Outstanding() == 1);
+    ex.Start();
+    EXPECT(waitDispatched(ex, 1));
+    ex.Stop();
+    auto events = sink.Events();
+    EXPECT(events.size() == 1);
+    if (!events.empty()) EXPECT(inCell(events[0], cv::Point(5, 3)) && !events[0].rightClick);
+}
+
+// 画面上格子已翻开即确认，不再重试
+static void testConfirmOnState() {
+    MockInputSink sink;
+    InputExecutor ex(sink);
+    ex.SetPacing(noPacing());
+    ex.Start();
+    ex.Submit(kBoard, kRows, kCols, { cv::Point(2, 4) });
+    EXPECT(waitDispatched(ex, 1));
+    GameState s = makeState();
+    s.grid[4][2] = 1;
+    ex.OnState(s, Clock::now() + std::chrono::seconds(1));
+    ex.Stop();
+    auto stats = ex.GetStats();
+    EXPECT(stats.confirmed == 1);
+    EXPECT(stats.retried == 0 && stats.cancelled == 0);
+    EXPECT(ex.Outstanding() == 0);
+    EXPECT(sink.Events().size() == 1);
+}
+
+// 稳定时间之前的画面不参与核对；之后仍未生效则重试一次，再不生效即取消
+static void testRetryOnceAfterSettle() {
+    MockInputSink sink;
+    InputExecutor ex(sink);
+    ex.SetPacing(noPacing());
+    ex.Start();
+    ex.Submit(kBoard, kRows, kCols, { cv::Point(6, 1) });
+    EXPECT(waitDispatched(ex, 1));
+    const GameState s = makeState();
+    // 刚派发完的画面（距点击不足 100 ms 稳定时间）
+    ex.OnState(s, Clock::now());
+    EXPECT(ex.GetStats().retried == 0);
+    EXPECT(ex.Outstanding() == 1);
+
+    ex.OnState(s, Clock::now() + std::chrono::seconds(1));
+    EXPECT(ex.GetStats().retried == 1);
+    EXPECT(waitDispatched(ex, 2));
+    ex.OnState(s, Clock::now() + std::chrono::seconds(1));
+    ex.Stop();
+    auto stats = ex.GetStats();
+    EXPECT(stats.dispatched == 2);
+    EXPECT(stats.retried == 1);
+    EXPECT(stats.cancelled == 1);
+    EXPECT(ex.Outstanding() == 0);
+    auto events = sink.Events();
+    EXPECT(events.size() == 2);
+    for (const auto& e : events) EXPECT(inCell(e, cv::Point(6, 1)));
+}
+
+// 盘面几何变化（新区域或行列不符）作废全部动作
+static void testCancelOnGeometryChange() {
+    MockInputSink sink;
+    InputExecutor ex(sink);
+    ex.Submit(kBoard, kRows, kCols, { cv::Point(0, 0), cv::Point(1, 1), cv::Point(2, 2) });
+    ex.Submit(cv::Rect(40, 0, 160, 160), kRows, kCols, { cv::Point(3, 3) });
+    EXPECT(ex.GetStats().cancelled == 3);
+    EXPECT(ex.Outstanding() == 1);
+
+    GameState s = makeState();
+    s.rows = 9; s.cols = 9;
+    s.grid.assign(9, std::vector<int>(9, 9));
+    ex.OnState(s, Clock::now());
+    EXPECT(ex.GetStats().cancelled == 4);
+    EXPECT(ex.Outstanding() == 0);
+    EXPECT(sink.Events().empty());
+}
+
+// 画面上出现地雷（游戏结束）作废全部动作，包括已派发待核对的
+static void testCancelOnVisibleMine() {
+    MockInputSink sink;
+    InputExecutor ex(sink);
+    ex.SetPacing(noPacing());
+    ex.Start();
+    ex.Submit(kBoard, kRows, kCols, { cv::Point(7, 7) });
+    EXPECT(waitDispatched(ex, 1));
+    ex.Stop();
+    ex.Submit(kBoard, kRows, kCols, { cv::Point(0, 7) });
+    EXPECT(ex.Outstanding() == 2);
+    GameState s = makeState();
+    s.grid[7][7] = -1;
+    ex.OnState(s, Clock::now() + std::chrono::seconds(1));
+    auto stats = ex.GetStats();
+    EXPECT(stats.cancelled == 2);
+    EXPECT(stats.confirmed == 0 && stats.retried == 0);
+    EXPECT(ex.Outstanding() == 0);
+    EXPECT(sink.Events().size() == 1);
+}
+
+int main() {
+    const std::vector<std::pair<const char*, std::function<void()>>> tests = {
+        { "replace_undispatched", testReplaceUndispatched },
+        { "confirm_on_state", testConfirmOnState },
+        { "retry_once_after_settle", testRetryOnceAfterSettle },
+        { "cancel_on_geometry_change", testCancelOnGeometryChange },
+        { "cancel_on_visible_mine", testCancelOnVisibleMine },
+    };
+    for (const auto& t : tests) {
+        const int before = g_failures;
+        t.second();
+        std::cout << (g_failures == before ? "[ok]   " : "[FAIL] ") << t.first << "\n";
+    }
+    if (g_failures > 0) {
+        std::cerr << g_failures << " 项检查失败\n";
+        return 1;
+    }
+    return 0;
+}
@@ -1,224 +1,199 @@
-#include "WindowCapture.h"
+#include "BoardPipeline.h"
 #include "GameAnalyzer.h"
 #include "DisplayWindow.h"
 #include "WindowSelector.h"
 #include "OverlayWindow.h"
 #include "Logger.h"
-#include <thread>
+#include "SessionRecorder.h"
+#include "WorkerPool.h"
+#include "LayoutCache.h"
+#include "Metrics.h"
+#include "MetricsServer.h"
+#include "ControlServer.h"
+#include "FramePipeline.h"
+#include "Trace.h"
+#include "AllocCounter.h"
+#include "FrameArena.h"
 #include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <sstream>
+#include <memory>
 #include <mutex>
+#include <vector>
 #include <opencv2/opencv.hpp>
 #include <windows.h>
-#include <random>
 #include <algorithm>
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <cwchar>
+#include <fstream>
+#include <filesystem>
 
-std::atomic<bool> g_running(false);
+// 以下用户设置对所有目标生效，BoardPipeline 以 extern 引用
 std::atomic<bool> g_enableMouseMove(false); // 默认不控制鼠标
-std::atomic<double> g_captureFps(0.0);
-std::atomic<double> g_analyzeMs(0.0);
-std::atomic<DWORD> g_lastRelayoutTick(0);
-const DWORD kRelayoutMinIntervalMs = 600; // 节流最小间隔
 // 自动点击控制
 std::atomic<bool> g_enableAutoClick(false);
 std::atomic<int> g_clickIntervalMs(200);      // 基础间隔 ms
 std::atomic<int> g_clickRandomMs(50);         // 间隔随机抖动 ±ms
 std::atomic<int> g_clickPosJitterPx(1);       // 点击坐标抖动 ±px
-std::atomic<DWORD> g_lastClickTick(0);
+std::atomic<bool> g_showLatency(false);       // 状态栏显示各阶段延迟分位数
 
-void CaptureThread(WindowCapture& capture, cv::Mat& gameImage, std::mutex& imageMutex) {
-    using clock = std::chrono::steady_clock;
-    auto lastReport = clock::now();
-    int frames = 0;
-    while (g_running) {
-        cv::Mat frame;
-        if (capture.CaptureGameArea(frame)) {
-            std::lock_guard<std::mutex> lock(imageMutex);
-            gameImage = frame.clone();
-            frames++;
-        }
-        auto now = clock::now();
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastReport).count();
-        if (ms >= 1000) {
-            g_captureFps.store(frames * 1000.0 / ms);
-            frames = 0;
-            lastReport = now;
-        }
-        std::this_thread::sleep_for(std::chrono::milliseconds(200));
-    }
+// 录制文件名：recordings/session_YYYYMMDD_HHMMSS
+static std::string MakeRecordingBase() {
+    std::time_t t = std::time(nullptr);
+    std::tm tmv{};
+    localtime_s(&tmv, &t);
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "recordings/session_%Y%m%d_%H%M%S", &tmv);
+    return buf;
 }
 
-void AnalysisThread(WindowCapture& capture, GameAnalyzer& analyzer,
-                   DisplayWindow& display, cv::Mat& gameImage, std::mutex& imageMutex) {
-    GameState state;
-    state.rows = 16;
-    state.cols = 16;
-    state.mineCount = 40;
-    // 上一帧识别结果用于投票
-    GameState prevState = state;
-
-    bool snapped = false;
-    cv::Rect lastRegion;
-    SIZE lastClientSize{0,0};
-
-    while (g_running) {
-        cv::Mat currentImage;
-        {
-            std::lock_guard<std::mutex> lock(imageMutex);
-            if (!gameImage.empty()) {
-                currentImage = gameImage.clone();
-            }
-        }
-
-        if (!currentImage.empty()) {
-            // 尝试识别操作区域并吸附（仅首次或区域变化较大时）
-            if (!snapped) {
-                cv::Rect region;
-                if (capture.IdentifyGameBounds(currentImage, region)) {
-                    // 将 region 转为屏幕坐标：当前 CaptureGameArea 获取的是客户区图像，坐标相对客户区
-                    POINT clientTopLeft{0,0}; ClientToScreen(capture.GetGameWindow(), &clientTopLeft);
-                    RECT screenRect{ clientTopLeft.x + region.x, clientTopLeft.y + region.y,
-                                     clientTopLeft.x + region.x + region.width,
-                                     clientTopLeft.y + region.y + region.height };
-                    display.SnapNear(screenRect);
-                    snapped = true;
-                    lastRegion = region;
-                }
-            }
-            // 选择 ROI（如有）
-            cv::Rect roiToUse(0, 0, currentImage.cols, currentImage.rows);
-            if (lastRegion.width > 0 && lastRegion.height > 0) {
-                // 防越界
-                cv::Rect imgRect(0,0,currentImage.cols,currentImage.rows);
-                roiToUse = lastRegion & imgRect;
-            }
+// 转储各阶段延迟直方图到 metrics/latency_YYYYMMDD_HHMMSS.txt，同时写日志
+static std::string DumpLatency() {
+    std::time_t t = std::time(nullptr);
+    std::tm tmv{};
+    localtime_s(&tmv, &t);
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "metrics/latency_%Y%m%d_%H%M%S.txt", &tmv);
+    std::error_code ec;
+    std::filesystem::create_directories("metrics", ec);
+    std::ofstream ofs(buf);
+    if (!ofs) { LOGE("无法写入延迟转储: {}", buf); return std::string(); }
+    std::ostringstream os;
+    metrics::Dump(os);
+    ofs << os.str();
+    LOGI("阶段延迟:\n" + os.str());
+    return buf;
+}
 
-            cv::Mat imgForAnalysis = currentImage(roiToUse).clone();
-            // 细化棋盘区域，剔除顶部 HUD（雷数/计时器）
-            cv::Rect gridRect;
-            bool refined = capture.RefineBoardArea(imgForAnalysis, gridRect);
-            if (refined) {
-                // 叠加到客户区坐标
-                gridRect.x += roiToUse.x;
-                gridRect.y += roiToUse.y;
-                // 用细化后的区域替代 roiToUse
-                cv::Rect imgRect2(0,0,currentImage.cols,currentImage.rows);
-                roiToUse = (gridRect & imgRect2);
-                imgForAnalysis = currentImage(roiToUse).clone();
-            }
+// 写出时间线到 traces/trace_YYYYMMDD_HHMMSS.json（Chrome trace 格式）
+static std::string DumpTrace() {
+    std::time_t t = std::time(nullptr);
+    std::tm tmv{};
+    localtime_s(&tmv, &t);
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "traces/trace_%Y%m%d_%H%M%S.json", &tmv);
+    std::error_code ec;
+    std::filesystem::create_directories("traces", ec);
+    if (!trace::Write(buf)) { LOGE("无法写入时间线: {}", buf); return std::string(); }
+    LOGI("时间线已写入: {}", buf);
+    return buf;
+}
 
-            // 触发：HUD 变化 或 窗口客户区尺寸变化，且满足节流
-            static bool firstLayout = true;
-            bool hudChanged = capture.HasHudChanged(currentImage);
-            // 窗口尺寸变化监测
-            HWND hw = capture.GetGameWindow();
-            RECT crc{}; GetClientRect(hw, &crc);
-            SIZE curSize{ crc.right-crc.left, crc.bottom-crc.top };
-            bool sizeChanged = (curSize.cx != lastClientSize.cx || curSize.cy != lastClientSize.cy);
-            if (sizeChanged) lastClientSize = curSize;
+// 目标窗口的简要描述，用于切换/增删目标时的提示
+static std::wstring DescribeTarget(HWND hwnd, int board, size_t index, size_t count) {
+    wchar_t title[256]{}; GetWindowTextW(hwnd, title, 255);
+    wchar_t cls[128]{}; GetClassNameW(hwnd, cls, 127);
+    RECT rc{}; GetClientRect(hwnd, &rc);
+    std::wstringstream ss;
+    ss << L"目标 " << (index + 1) << L"/" << count << L"  窗口: " << title << L"  类: " << cls;
+    if (board > 0) ss << L"  棋盘: #" << board;
+    ss << L"  客户区: " << (rc.right-rc.left) << L"x" << (rc.bottom-rc.top)
+       << L"  (F8 重新选择 | Shift+F8 添加 | Ctrl+F8 切换)";
+    return ss.str();
+}
 
-            DWORD now = GetTickCount();
-            DWORD lastTick = g_lastRelayoutTick.load();
-            bool throttled = (now - lastTick < kRelayoutMinIntervalMs);
+// 命令行 --metrics-port N / --control-port N：启用本机指标端点 / 控制接口（默认关闭）
+static int ParsePortOption(const wchar_t* cmdLine, const wchar_t* name) {
+    if (!cmdLine) return 0;
+    const wchar_t* p = wcsstr(cmdLine, name);
+    if (!p) return 0;
+    p += wcslen(name);
+    while (*p == L' ' || *p == L'=') ++p;
+    long port = wcstol(p, nullptr, 10);
+    return (port > 0 && port <= 65535) ? int(port) : 0;
+}
 
-            if (!throttled && (firstLayout || hudChanged || sizeChanged)) {
-                int rows=0, cols=0; cv::Rect inner;
-                if (capture.AnalyzeGridLayoutEx(imgForAnalysis, rows, cols, inner) && rows>0 && cols>0) {
-                    // 转回客户区坐标
-                    inner.x += roiToUse.x;
-                    inner.y += roiToUse.y;
-                    // 更新 ROI 与 state 行列
-                    cv::Rect imgRect2(0,0,currentImage.cols,currentImage.rows);
-                    roiToUse = (inner & imgRect2);
-                    imgForAnalysis = currentImage(roiToUse).clone();
-                    state.rows = rows; state.cols = cols;
-                    firstLayout = false;
-                    g_lastRelayoutTick.store(now);
-                }
-            }
+// 控制接口投递给 UI 线程的任务通知；连接线程至多等待 kControlWaitMs
+static const UINT WM_CONTROL_TASK = WM_APP + 1;
+static const int kControlWaitMs = 5000;
 
-            auto t0 = std::chrono::steady_clock::now();
-            if (analyzer.AnalyzeGameState(imgForAnalysis, state)) {
-                // 多帧投票：若本帧识别为未知(9)，上一帧非未知，则沿用上一帧；若两帧不一致且都非未知，保留上一帧（保守）
-                if (prevState.rows == state.rows && prevState.cols == state.cols) {
-                    for (int r=0;r<state.rows;++r){
-                        for (int c=0;c<state.cols;++c){
-                            int cur = state.grid[r][c];
-                            int prv = prevState.grid[r][c];
-                            if (cur == 9 && prv != 9) state.grid[r][c] = prv;
-                            else if (cur != 9 && prv != 9 && cur != prv) state.grid[r][c] = prv; // 稳定优先
-                        }
-                    }
-                }
-                prevState = state;
-                auto t1 = std::chrono::steady_clock::now();
-                g_analyzeMs.store(std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count());
-                display.Update(state);
+static std::string ToUtf8(const wchar_t* s) {
+    int n = WideCharToMultiByte(CP_UTF8, 0, s, -1, nullptr, 0, nullptr, nullptr);
+    std::string out(n > 1 ? n - 1 : 0, '\0');
+    if (n > 1) WideCharToMultiByte(CP_UTF8, 0, s, -1, &out[0], n, nullptr, nullptr);
+    return out;
+}
 
-                auto safeMoves = analyzer.FindSafeMoves(state);
-                state.safeCells = safeMoves; // 供渲染高亮
-                // 自动点击：每个周期最多点击一个安全格；遵守间隔与随机抖动
-                if (!safeMoves.empty() && g_enableAutoClick.load()) {
-                    DWORD now = GetTickCount();
-                    int base = std::max(0, g_clickIntervalMs.load());
-                    int jitter = std::max(0, g_clickRandomMs.load());
-                    static thread_local std::mt19937 rng{ std::random_device{}() };
-                    std::uniform_int_distribution<int> dj(-jitter, jitter);
-                    int eff = base + (jitter>0 ? dj(rng) : 0);
-                    if (now - g_lastClickTick.load() >= (DWORD)std::max(0, eff)) {
-                        cv::Point move = safeMoves.front();
-                        int cellW = imgForAnalysis.cols / state.cols;
-                        int cellH = imgForAnalysis.rows / state.rows;
-                        int localX = move.x * cellW + cellW / 2;
-                        int localY = move.y * cellH + cellH / 2;
-                        int posJ = std::max(0, g_clickPosJitterPx.load());
-                        if (posJ > 0) {
-                            std::uniform_int_distribution<int> jp(-posJ, posJ);
-                            localX = std::clamp(localX + jp(rng), move.x*cellW + 1, (move.x+1)*cellW - 1);
-                            localY = std::clamp(localY + jp(rng), move.y*cellH + 1, (move.y+1)*cellH - 1);
-                        }
-                        int x = roiToUse.x + localX;
-                        int y = roiToUse.y + localY;
-                        analyzer.PerformClick(capture.GetGameWindow(), x, y);
-                        g_lastClickTick.store(now);
-                    }
-                }
+// 控制接口参数：on/off、true/false、1/0
+static bool ParseSwitch(const std::string& s, bool& v) {
+    if (s == "on" || s == "true" || s == "1") { v = true; return true; }
+    if (s == "off" || s == "false" || s == "0") { v = false; return true; }
+    return false;
+}
 
-                // 更新状态栏：窗口信息 + FPS/耗时 + 网格信息
-                HWND h = capture.GetGameWindow();
-                wchar_t title[256]{}; GetWindowTextW(h, title, 255);
-                wchar_t cls[128]{}; GetClassNameW(h, cls, 127);
-                RECT rcClient{}; GetClientRect(h, &rcClient);
-                int cellW = (state.cols>0)? (imgForAnalysis.cols / state.cols) : 0;
-                int cellH = (state.rows>0)? (imgForAnalysis.rows / state.rows) : 0;
-                std::wstringstream ss;
-                ss.setf(std::ios::fixed); ss.precision(1);
-                             ss << L"窗口: " << title << L"  类: " << cls
-                   << L"  客户区: " << (rcClient.right-rcClient.left) << L"x" << (rcClient.bottom-rcClient.top)
-                                 << L"\nROI: " << roiToUse.width << L"x" << roiToUse.height
-                             << L"  Capture: " << capture.GetLastCaptureMethod()
-                                 << L"  HUD: " << capture.GetLastHudMethod()
-                             << L"  Grid: " << state.rows << L"x" << state.cols
-                             << L"  Cell: " << cellW << L"x" << cellH
-                              << L"  Auto: " << (g_enableAutoClick.load()? L"ON" : L"OFF")
-                              << L"  Intv: " << g_clickIntervalMs.load() << L"±" << g_clickRandomMs.load() << L"ms"
-                              << L"  Jit: ±" << g_clickPosJitterPx.load() << L"px"
-                             << L"  Mouse: " << (g_enableMouseMove.load()? L"ON" : L"OFF")
-                             << L"  FPS: " << g_captureFps.load() << L"  分析: " << g_analyzeMs.load() << L" ms  (F8 选择 | F9 鼠标 | F10 自动 | F11/F12 间隔 | F6/F7 随机 | F3/F4 坐标抖动 | +/- HUD%)";
-                display.SetStatusText(ss.str());
-            }
-        }
+static bool ParseRange(const std::string& s, int lo, int hi, int& v) {
+    char* end = nullptr;
+    long x = std::strtol(s.c_str(), &end, 10);
+    if (s.empty() || *end != '\0' || x < lo || x > hi) return false;
+    v = int(x);
+    return true;
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(500));
-    }
+// 窗口参数：auto（自动识别）、foreground（前台窗口）或十六进制句柄
+static HWND ResolveWindowArg(const std::string& arg) {
+    if (arg == "auto") return WindowSelector::AutoPick();
+    if (arg == "foreground") return WindowSelector::PickForeground();
+    char* end = nullptr;
+    unsigned long long v = std::strtoull(arg.c_str(), &end, 16);
+    if (arg.empty() || *end != '\0') return NULL;
+    HWND hwnd = reinterpret_cast<HWND>(uintptr_t(v));
+    return IsWindow(hwnd) ? hwnd : NULL;
 }
 
-int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
+int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR cmdLine, int) {
+    alloccount::Install();
+    FrameArena::Install();
+    trace::SetThreadName("ui");
 
-    WindowCapture capture;
     GameAnalyzer analyzer;
     DisplayWindow display;
+    SessionRecorder recorder;
+    // 所有目标共享：分析线程池、布局缓存文件、点击互斥
+    WorkerPool pool;
+    LayoutCache layoutCache("cache/layouts.txt");
+    std::mutex clickLock;
+    std::vector<std::unique_ptr<BoardPipeline>> pipelines;
+    size_t focus = 0; // 显示目标下标
+    MetricsServer metricsServer;
+    if (int port = ParsePortOption(cmdLine, L"--metrics-port")) metricsServer.Start(uint16_t(port));
+
+    if (!display.Create()) {
+        // 未能创建显示窗口
+        return 1;
+    }
+    display.SetTopMost(true);
+
+    auto setFocus = [&](size_t index) {
+        focus = index;
+        for (size_t i = 0; i < pipelines.size(); ++i) pipelines[i]->SetFocused(i == focus);
+        if (!pipelines.empty())
+            display.SetStatusText(DescribeTarget(pipelines[focus]->GetWindow(), pipelines[focus]->BoardIndex(),
+                                                 focus, pipelines.size()));
+        else
+            display.SetStatusText(L"状态: 未绑定窗口 (F8 选择窗口)");
+    };
+    // 同一窗口的同一块棋盘不重复添加，已存在则切换为显示目标；
+    // board > 0 绑定窗口里的第 board 块棋盘（阅读顺序），每块一条流水线
+    auto addTarget = [&](HWND hwnd, int board) {
+        for (size_t i = 0; i < pipelines.size(); ++i) {
+            if (pipelines[i]->GetWindow() == hwnd && pipelines[i]->BoardIndex() == board) { setFocus(i); return; }
+        }
+        pipelines.push_back(std::make_unique<BoardPipeline>(hwnd, analyzer, pool, layoutCache,
+                                                            display, recorder, clickLock, board));
+        pipelines.back()->Start();
+        setFocus(pipelines.size() - 1);
+    };
+    auto removeTarget = [&](size_t index) {
+        pipelines[index]->Stop();
+        pipelines.erase(pipelines.begin() + index);
+        setFocus(pipelines.empty() ? 0 : std::min(index, pipelines.size() - 1));
+    };
 
     // 里程碑1：启动自动识别，失败则前台窗口作为候选
     HWND gameHwnd = WindowSelector::AutoPick();
@@ -226,44 +201,179 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
         LOGI("AutoPick 未命中，使用前台窗口作为候选");
         gameHwnd = WindowSelector::PickForeground();
     }
-    if (!gameHwnd) {
-    // 未能选择游戏窗口
-        // 仍然展示辅助窗口，便于验证 UI
-        if (!display.Create()) {
-            return 1;
-        }
-        display.SetTopMost(true);
-        display.SetStatusText(L"状态: 未绑定窗口 (F8 选择窗口)");
-    } else {
-        capture.SetGameWindow(gameHwnd);
-        if (!display.Create()) {
-            // 未能创建显示窗口
-            return 1;
-        }
-        display.SetTopMost(true);
+    if (gameHwnd) addTarget(gameHwnd, 0);
+    else setFocus(0); // 未能选择游戏窗口：仍然展示辅助窗口，便于验证 UI
 
-        // 显示目标窗口信息
-        wchar_t title[256]{}; GetWindowTextW(gameHwnd, title, 255);
-        wchar_t cls[128]{}; GetClassNameW(gameHwnd, cls, 127);
-        RECT rcClient{}; GetClientRect(gameHwnd, &rcClient);
-        std::wstringstream ss;
-        ss << L"窗口: " << title << L"  类: " << cls
-           << L"  客户区: " << (rcClient.right-rcClient.left) << L"x" << (rcClient.bottom-rcClient.top)
-           << L"  (F8 重新选择)";
-        display.SetStatusText(ss.str());
+    // 不再根据目标窗口尺寸自动调整显示窗口；保持小窗模式
 
-    cv::Mat gameImage;
-        std::mutex imageMutex;
-
-        g_running = true;
-        std::thread captureThread(CaptureThread, std::ref(capture), std::ref(gameImage), std::ref(imageMutex));
-        std::thread analysisThread(AnalysisThread, std::ref(capture), std::ref(analyzer),
-                                  std::ref(display), std::ref(gameImage), std::ref(imageMutex));
+    // 控制接口：设置项直接写原子量；涉及目标列表的命令投递到 UI 线程执行，连接线程等待结果。
+    // 任务可能在等待超时后才执行，故只按值捕获请求参数
+    std::mutex uiTaskMutex;
+    std::deque<std::function<void()>> uiTasks;
+    const DWORD uiThread = GetCurrentThreadId();
+    auto runOnUi = [&](std::function<bool(std::string&)> fn, std::string& out) {
+        auto result = std::make_shared<std::promise<std::pair<bool, std::string>>>();
+        std::future<std::pair<bool, std::string>> done = result->get_future();
+        {
+            std::lock_guard<std::mutex> lock(uiTaskMutex);
+            uiTasks.push_back([fn, result] {
+                std::string o;
+                bool ok = fn(o);
+                result->set_value({ ok, std::move(o) });
+            });
+        }
+        PostThreadMessageW(uiThread, WM_CONTROL_TASK, 0, 0);
+        // 覆盖层选择窗口等模态期间 UI 线程不取任务：超时报错而不是一直占住连接
+        if (done.wait_for(std::chrono::milliseconds(kControlWaitMs)) != std::future_status::ready) {
+            out = "ui thread busy";
+            return false;
+        }
+        std::pair<bool, std::string> r = done.get();
+        out = std::move(r.second);
+        return r.first;
+    };
+    auto drainUiTasks = [&] {
+        std::deque<std::function<void()>> tasks;
+        {
+            std::lock_guard<std::mutex> lock(uiTaskMutex);
+            tasks.swap(uiTasks);
+        }
+        for (auto& t : tasks) t();
+    };
+    // 以下在 UI 线程调用
+    auto targetsJson = [&] {
+        std::string r = "[";
+        for (size_t i = 0; i < pipelines.size(); ++i) {
+            HWND hwnd = pipelines[i]->GetWindow();
+            wchar_t title[256]{}; GetWindowTextW(hwnd, title, 255);
+            wchar_t cls[128]{}; GetClassNameW(hwnd, cls, 127);
+            char handle[32];
+            std::snprintf(handle, sizeof(handle), "0x%llX", (unsigned long long)uintptr_t(hwnd));
+            if (i) r += ',';
+            r += "{\"index\":" + std::to_string(i) + ",\"hwnd\":\"" + handle + "\",\"title\":";
+            AppendJsonString(r, ToUtf8(title));
+            r += ",\"class\":";
+            AppendJsonString(r, ToUtf8(cls));
+            r += ",\"board\":" + std::to_string(pipelines[i]->BoardIndex());
+            r += ",\"boards\":" + std::to_string(pipelines[i]->BoardsSeen());
+            r += ",\"hud\":" + std::to_string(pipelines[i]->Capture().GetHudTopRatioPercent());
+            r += std::string(",\"focused\":") + (i == focus ? "true" : "false") + "}";
+        }
+        return r + "]";
+    };
+    auto settingsJson = [&] {
+        std::string r = std::string("{\"autoclick\":") + (g_enableAutoClick.load() ? "true" : "false")
+                      + ",\"mousemove\":" + (g_enableMouseMove.load() ? "true" : "false")
+                      + ",\"interval\":" + std::to_string(g_clickIntervalMs.load())
+                      + ",\"random\":" + std::to_string(g_clickRandomMs.load())
+                      + ",\"jitter\":" + std::to_string(g_clickPosJitterPx.load())
+                      + ",\"latency\":" + (g_showLatency.load() ? "true" : "false")
+                      + ",\"recording\":" + (recorder.IsRecording() ? "true" : "false")
+                      + ",\"focus\":" + std::to_string(focus) + ",\"targets\":";
+        return r + targetsJson() + "}";
+    };
 
-        // 不再根据目标窗口尺寸自动调整显示窗口；保持小窗模式
+    ControlServer controlServer(analyzer);
+    controlServer.Register("get", [&](const std::vector<std::string>&, std::string& out) {
+        return runOnUi([&](std::string& o) { o = settingsJson(); return true; }, out);
+    });
+    controlServer.Register("targets", [&](const std::vector<std::string>&, std::string& out) {
+        return runOnUi([&](std::string& o) { o = targetsJson(); return true; }, out);
+    });
+    controlServer.Register("set", [&](const std::vector<std::string>& args, std::string& out) {
+        if (args.size() != 2) { out = "usage: set <key> <value>"; return false; }
+        const std::string& key = args[0];
+        bool on = false;
+        int v = 0;
+        if (key == "autoclick" || key == "mousemove" || key == "latency") {
+            if (!ParseSwitch(args[1], on)) { out = key + " expects on|off"; return false; }
+            (key == "autoclick" ? g_enableAutoClick : key == "mousemove" ? g_enableMouseMove : g_showLatency).store(on);
+            out = "{\"" + key + "\":" + (on ? "true" : "false") + "}";
+            return true;
+        }
+        // 取值范围与热键调整一致
+        struct IntSetting { const char* name; std::atomic<int>* value; int lo, hi; };
+        const IntSetting ints[] = {
+            { "interval", &g_clickIntervalMs, 50, 2000 },
+            { "random", &g_clickRandomMs, 0, 1000 },
+            { "jitter", &g_clickPosJitterPx, 0, 10 },
+        };
+        for (const IntSetting& s : ints) {
+            if (key != s.name) continue;
+            if (!ParseRange(args[1], s.lo, s.hi, v)) {
+                out = key + " expects " + std::to_string(s.lo) + ".." + std::to_string(s.hi);
+                return false;
+            }
+            s.value->store(v);
+            out = "{\"" + key + "\":" + std::to_string(v) + "}";
+            return true;
+        }
+        if (key == "hud") {
+            if (!ParseRange(args[1], 10, 70, v)) { out = "hud expects 10..70"; return false; }
+            return runOnUi([&, v](std::string& o) {
+                if (pipelines.empty()) { o = "no target"; return false; }
+                pipelines[focus]->Capture().SetHudTopRatioPercent(v);
+                o = "{\"hud\":" + std::to_string(v) + "}";
+                return true;
+            }, out);
+        }
+        out = "unknown setting '" + key + "'";
+        return false;
+    });
+    controlServer.Register("select", [&](const std::vector<std::string>& args, std::string& out) {
+        return runOnUi([&, args](std::string& o) {
+            int i = 0;
+            if (pipelines.empty()) { o = "no target"; return false; }
+            if (args.size() != 1 || !ParseRange(args[0], 0, int(pipelines.size()) - 1, i)) {
+                o = "usage: select <index> (0.." + std::to_string(pipelines.size() - 1) + ")";
+                return false;
+            }
+            setFocus(size_t(i));
+            o = targetsJson();
+            return true;
+        }, out);
+    });
+    // bind 追加目标（已存在则切换显示），replace 替换显示目标（同 F8 / Shift+F8）；
+    // 可选的棋盘序号用于同一窗口里的多块棋盘
+    auto bindCommand = [&](bool replace) {
+        return [&, replace](const std::vector<std::string>& args, std::string& out) {
+            int board = 0;
+            if (args.empty() || args.size() > 2 || (args.size() == 2 && !ParseRange(args[1], 0, 15, board))) {
+                out = "usage: <hwnd hex|auto|foreground> [board 0..15]";
+                return false;
+            }
+            return runOnUi([&, args, replace, board](std::string& o) {
+                HWND hwnd = ResolveWindowArg(args[0]);
+                if (!hwnd) { o = "no such window: " + args[0]; return false; }
+                if (replace && !pipelines.empty()) {
+                    pipelines[focus]->Stop();
+                    pipelines.erase(pipelines.begin() + focus);
+                }
+                addTarget(hwnd, board);
+                o = targetsJson();
+                return true;
+            }, out);
+        };
+    };
+    controlServer.Register("bind", bindCommand(false));
+    controlServer.Register("replace", bindCommand(true));
+    controlServer.Register("remove", [&](const std::vector<std::string>& args, std::string& out) {
+        return runOnUi([&, args](std::string& o) {
+            int i = int(focus);
+            if (pipelines.empty() || args.size() > 1 ||
+                (args.size() == 1 && !ParseRange(args[0], 0, int(pipelines.size()) - 1, i))) {
+                o = pipelines.empty() ? "no target" : "usage: remove [index]";
+                return false;
+            }
+            removeTarget(size_t(i));
+            o = targetsJson();
+            return true;
+        }, out);
+    });
+    if (int port = ParsePortOption(cmdLine, L"--control-port")) controlServer.Start(uint16_t(port));
 
     // 注册热键 F8：手动拖拽选择游戏窗口；F9：切换鼠标控制
-        RegisterHotKey(NULL, 1, 0, VK_F8);
+    RegisterHotKey(NULL, 1, 0, VK_F8);
     RegisterHotKey(NULL, 2, 0, VK_F9);
     // 注册 + / - 用于调整 HUD 顶部高度比例
     RegisterHotKey(NULL, 3, 0, VK_OEM_PLUS);
@@ -276,110 +386,118 @@ int WINAPI wWinMain(HINSTANCE, HINSTANCE, PWSTR, int) {
     RegisterHotKey(NULL, 9, 0, VK_F7);  // 随机 +
     RegisterHotKey(NULL, 10, 0, VK_F3); // 坐标抖动 -
     RegisterHotKey(NULL, 11, 0, VK_F4); // 坐标抖动 +
+    RegisterHotKey(NULL, 12, 0, VK_F5); // 会话录制开关
+    RegisterHotKey(NULL, 13, 0, VK_F2); // 状态栏延迟分位数开关
+    RegisterHotKey(NULL, 14, MOD_CONTROL, VK_F2); // 转储延迟直方图
+    RegisterHotKey(NULL, 18, MOD_SHIFT, VK_F2);   // 时间线追踪开/关（关闭时写出）
+    // 多目标
+    RegisterHotKey(NULL, 15, MOD_SHIFT, VK_F8);                 // 添加目标窗口
+    RegisterHotKey(NULL, 16, MOD_CONTROL, VK_F8);               // 切换显示目标
+    RegisterHotKey(NULL, 17, MOD_CONTROL | MOD_SHIFT, VK_F8);   // 移除显示目标
 
-        // 消息循环
-        MSG msg;
-        while (GetMessage(&msg, NULL, 0, 0)) {
-            if (msg.message == WM_HOTKEY && msg.wParam == 1) {
-                // 暂停抓取，弹出覆盖层
-                g_running = false;
-                captureThread.join();
-                analysisThread.join();
-
-                OverlayWindow overlay;
-                HWND selected = overlay.SelectBlocking();
-                if (selected) {
-                    capture.SetGameWindow(selected);
-                    wchar_t t[256]{}; GetWindowTextW(selected, t, 255);
-                    wchar_t c[128]{}; GetClassNameW(selected, c, 127);
-                    RECT cr{}; GetClientRect(selected, &cr);
-                    std::wstringstream s2;
-                    s2 << L"窗口: " << t << L"  类: " << c
-                       << L"  客户区: " << (cr.right-cr.left) << L"x" << (cr.bottom-cr.top)
-                       << L"  (F8 重新选择)";
-                    display.SetStatusText(s2.str());
-                    // 重新启动线程
-                    g_running = true;
-                    captureThread = std::thread(CaptureThread, std::ref(capture), std::ref(gameImage), std::ref(imageMutex));
-                    analysisThread = std::thread(AnalysisThread, std::ref(capture), std::ref(analyzer),
-                                                std::ref(display), std::ref(gameImage), std::ref(imageMutex));
-                } else {
-                    // 未选择则恢复线程继续
-                    g_running = true;
-                    captureThread = std::thread(CaptureThread, std::ref(capture), std::ref(gameImage), std::ref(imageMutex));
-                    analysisThread = std::thread(AnalysisThread, std::ref(capture), std::ref(analyzer),
-                                                std::ref(display), std::ref(gameImage), std::ref(imageMutex));
-                }
-            } else if (msg.message == WM_HOTKEY && msg.wParam == 2) {
-                // 切换鼠标控制
-                bool now = !g_enableMouseMove.load();
-                g_enableMouseMove.store(now);
-                // 触发状态栏更新（AnalysisThread 周期性刷新会覆盖，但这里也可轻触）
-                display.SetStatusText(L"鼠标控制已切换，等待刷新...");
-            } else if (msg.message == WM_HOTKEY && (msg.wParam == 3 || msg.wParam == 4)) {
-                // HUD 顶部高度比例调整
-                int cur = capture.GetHudTopRatioPercent();
-                if (msg.wParam == 3) cur = std::min(70, cur + 5);
-                else cur = std::max(10, cur - 5);
-                capture.SetHudTopRatioPercent(cur);
-                // 轻触状态提示
-                std::wstringstream s;
-                s << L"HUD 顶部比例: " << cur << L"% (等待刷新)";
-                display.SetStatusText(s.str());
-            } else if (msg.message == WM_HOTKEY && msg.wParam == 5) {
-                // 自动点击开关
-                bool v = !g_enableAutoClick.load(); g_enableAutoClick.store(v);
-                std::wstringstream s; s << L"自动点击: " << (v? L"ON" : L"OFF");
-                display.SetStatusText(s.str());
-            } else if (msg.message == WM_HOTKEY && (msg.wParam == 6 || msg.wParam == 7)) {
-                int cur = g_clickIntervalMs.load();
-                if (msg.wParam == 6) cur = std::max(50, cur - 50);
-                else cur = std::min(2000, cur + 50);
-                g_clickIntervalMs.store(cur);
-                std::wstringstream s; s << L"点击间隔: " << cur << L" ms"; display.SetStatusText(s.str());
-            } else if (msg.message == WM_HOTKEY && (msg.wParam == 8 || msg.wParam == 9)) {
-                int cur = g_clickRandomMs.load();
-                if (msg.wParam == 8) cur = std::max(0, cur - 10);
-                else cur = std::min(1000, cur + 10);
-                g_clickRandomMs.store(cur);
-                std::wstringstream s; s << L"随机间隔: ±" << cur << L" ms"; display.SetStatusText(s.str());
-            } else if (msg.message == WM_HOTKEY && (msg.wParam == 10 || msg.wParam == 11)) {
-                int cur = g_clickPosJitterPx.load();
-                if (msg.wParam == 10) cur = std::max(0, cur - 1);
-                else cur = std::min(10, cur + 1);
-                g_clickPosJitterPx.store(cur);
-                std::wstringstream s; s << L"坐标抖动: ±" << cur << L" px"; display.SetStatusText(s.str());
+    // 消息循环
+    MSG msg;
+    while (GetMessage(&msg, NULL, 0, 0)) {
+        // 每次取到消息都处理控制任务：模态期间丢失的线程消息不至于让任务滞留
+        drainUiTasks();
+        if (msg.message == WM_CONTROL_TASK && msg.hwnd == NULL) {
+            continue;
+        } else if (msg.message == WM_HOTKEY && (msg.wParam == 1 || msg.wParam == 15)) {
+            // 暂停所有目标，弹出覆盖层；F8 替换显示目标，Shift+F8 追加新目标
+            for (auto& p : pipelines) p->Stop();
+            OverlayWindow overlay;
+            HWND selected = overlay.SelectBlocking();
+            if (selected && msg.wParam == 1 && !pipelines.empty()) pipelines.erase(pipelines.begin() + focus);
+            for (auto& p : pipelines) p->Start();
+            if (selected) addTarget(selected, 0);
+            else setFocus(std::min(focus, pipelines.empty() ? 0 : pipelines.size() - 1));
+        } else if (msg.message == WM_HOTKEY && msg.wParam == 16) {
+            if (!pipelines.empty()) setFocus((focus + 1) % pipelines.size());
+        } else if (msg.message == WM_HOTKEY && msg.wParam == 17) {
+            if (!pipelines.empty()) removeTarget(focus);
+        } else if (msg.message == WM_HOTKEY && msg.wParam == 2) {
+            // 切换鼠标控制
+            bool now = !g_enableMouseMove.load();
+            g_enableMouseMove.store(now);
+            // 触发状态栏更新（分析任务周期性刷新会覆盖，但这里也可轻触）
+            display.SetStatusText(L"鼠标控制已切换，等待刷新...");
+        } else if (msg.message == WM_HOTKEY && (msg.wParam == 3 || msg.wParam == 4)) {
+            // HUD 顶部高度比例调整：仅作用于显示目标
+            if (pipelines.empty()) continue;
+            WindowCapture& capture = pipelines[focus]->Capture();
+            int cur = capture.GetHudTopRatioPercent();
+            if (msg.wParam == 3) cur = std::min(70, cur + 5);
+            else cur = std::max(10, cur - 5);
+            capture.SetHudTopRatioPercent(cur);
+            // 轻触状态提示
+            std::wstringstream s;
+            s << L"HUD 顶部比例: " << cur << L"% (等待刷新)";
+            display.SetStatusText(s.str());
+        } else if (msg.message == WM_HOTKEY && msg.wParam == 5) {
+            // 自动点击开关
+            bool v = !g_enableAutoClick.load(); g_enableAutoClick.store(v);
+            std::wstringstream s; s << L"自动点击: " << (v? L"ON" : L"OFF");
+            display.SetStatusText(s.str());
+        } else if (msg.message == WM_HOTKEY && (msg.wParam == 6 || msg.wParam == 7)) {
+            int cur = g_clickIntervalMs.load();
+            if (msg.wParam == 6) cur = std::max(50, cur - 50);
+            else cur = std::min(2000, cur + 50);
+            g_clickIntervalMs.store(cur);
+            std::wstringstream s; s << L"点击间隔: " << cur << L" ms"; display.SetStatusText(s.str());
+        } else if (msg.message == WM_HOTKEY && (msg.wParam == 8 || msg.wParam == 9)) {
+            int cur = g_clickRandomMs.load();
+            if (msg.wParam == 8) cur = std::max(0, cur - 10);
+            else cur = std::min(1000, cur + 10);
+            g_clickRandomMs.store(cur);
+            std::wstringstream s; s << L"随机间隔: ±" << cur << L" ms"; display.SetStatusText(s.str());
+        } else if (msg.message == WM_HOTKEY && (msg.wParam == 10 || msg.wParam == 11)) {
+            int cur = g_clickPosJitterPx.load();
+            if (msg.wParam == 10) cur = std::max(0, cur - 1);
+            else cur = std::min(10, cur + 1);
+            g_clickPosJitterPx.store(cur);
+            std::wstringstream s; s << L"坐标抖动: ±" << cur << L" px"; display.SetStatusText(s.str());
+        } else if (msg.message == WM_HOTKEY && msg.wParam == 12) {
+            // 会话录制开关：写入 recordings/ 下的 .msrec/.msidx（只录显示目标）
+            if (recorder.IsRecording()) {
+                recorder.Stop();
+                display.SetStatusText(L"录制已停止");
+            } else {
+                bool ok = recorder.Start(MakeRecordingBase());
+                display.SetStatusText(ok ? L"录制中..." : L"录制启动失败");
+            }
+        } else if (msg.message == WM_HOTKEY && msg.wParam == 13) {
+            bool v = !g_showLatency.load(); g_showLatency.store(v);
+            display.SetStatusText(v ? L"延迟分位数: 显示" : L"延迟分位数: 隐藏");
+        } else if (msg.message == WM_HOTKEY && msg.wParam == 18) {
+            if (trace::Enabled()) {
+                trace::Stop();
+                std::string path = DumpTrace();
+                display.SetStatusText(path.empty() ? L"时间线写出失败" : L"时间线已写入 traces/");
             } else {
-                TranslateMessage(&msg);
-                DispatchMessage(&msg);
+                trace::Start();
+                display.SetStatusText(L"时间线追踪中... (Shift+F2 停止并写出)");
             }
+        } else if (msg.message == WM_HOTKEY && msg.wParam == 14) {
+            std::string path = DumpLatency();
+            display.SetStatusText(path.empty() ? L"延迟转储失败" : L"延迟已转储到 metrics/");
+        } else {
+            TranslateMessage(&msg);
+            DispatchMessage(&msg);
         }
-
-    // 清理
-        g_running = false;
-        captureThread.join();
-        analysisThread.join();
-    UnregisterHotKey(NULL, 1);
-    UnregisterHotKey(NULL, 2);
-    UnregisterHotKey(NULL, 3);
-    UnregisterHotKey(NULL, 4);
-    UnregisterHotKey(NULL, 5);
-    UnregisterHotKey(NULL, 6);
-    UnregisterHotKey(NULL, 7);
-    UnregisterHotKey(NULL, 8);
-    UnregisterHotKey(NULL, 9);
-    UnregisterHotKey(NULL, 10);
-    UnregisterHotKey(NULL, 11);
-
-        return 0;
     }
 
-    // 简单消息循环（未启动线程情况下）
-    MSG msg;
-    while (GetMessage(&msg, NULL, 0, 0)) {
-        TranslateMessage(&msg);
-        DispatchMessage(&msg);
+    // 清理：控制接口的处理函数引用目标列表，先于目标停止
+    controlServer.Stop();
+    for (auto& p : pipelines) p->Stop();
+    pipelines.clear();
+    recorder.Stop();
+    metricsServer.Stop();
+    // 追踪未手动停止：退出时写出
+    if (trace::Enabled()) {
+        trace::Stop();
+        DumpTrace();
     }
+    for (int id = 1; id <= 18; ++id) UnregisterHotKey(NULL, id);
 
     return 0;
 }
@@ -0,0 +1,348 @@
+// 合成截图基准：按随机（或固定）的棋盘尺寸、皮肤、格子大小、DPI 缩放、HUD、窗口外框与
+// 压缩噪声即时生成带真值的截图，可写出 PNG + truth.jsonl，或直接交给识别流水线统计
+// 定位/布局/逐格识别的准确率与吞吐。每帧参数只由 --seed 与帧序号决定，与线程数无关。
+#include "BoardSynthesizer.h"
+#include "FrameArena.h"
+#include "FramePipeline.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct SynthCliOptions {
+    long long count = 1000;
+    int rows = 0, cols = 0, mines = -1; // rows/cols 为 0 时每帧随机
+    int maxSize = 60;                   // 随机尺寸的行列上限
+    int skin = -1;                      // -1 时各皮肤轮换
+    int cell = 0;                       // 0 时每帧在 12–32 之间随机
+    std::vector<double> dpis = { 1.0, 1.25, 1.5, 2.0 };
+    bool stretch = false;
+    bool chrome = false;
+    int jpeg = 0;
+    double noise = 0.0;
+    uint64_t seed = 1;
+    std::string outDir;
+    bool bench = true;
+    bool fullCells = false;
+    int jobs = 0;
+    double minLocated = -1, minLayout = -1, minCells = -1; // 百分比下限，负数不检查
+};
+
+static void printUsage() {
+    std::cout <<
+        "用法: MinesweeperSynth [选项]\n"
+        "  --count N        生成帧数（默认 1000）\n"
+        "  --size R C [M]   固定行列（与雷数，默认约 15% 密度）；默认每帧随机：标准三档或 8–--max-size 的任意尺寸\n"
+        "  --max-size N     随机尺寸的行列上限（默认 60）\n"
+        "  --skin NAME      xp | win7 | web | webclassic（默认四种轮换）\n"
+        "  --cell N         100% 缩放下的格子像素（默认每帧 12–32 随机）\n"
+        "  --dpi LIST       逗号分隔的缩放比例，每帧随机取一个（默认 1,1.25,1.5,2）\n"
+        "  --stretch        DPI 缩放按位图拉伸模拟（未声明 DPI 感知的程序）\n"
+        "  --chrome         加窗口边框（xp/win7）或浏览器外框（网页皮肤）并放到桌面背景上\n"
+        "  --jpeg Q         JPEG 编解码往返（质量 Q，默认关闭）\n"
+        "  --noise S        高斯噪声标准差（灰度级）\n"
+        "  --seed N         随机种子（默认 1）\n"
+        "  --out DIR        写出 DIR/synth_NNNNNNNN.png 与 DIR/truth.jsonl\n"
+        "  --no-bench       只生成，不跑识别\n"
+        "  --full-cells     关闭稀疏探针，每格都做整格分析（与默认对照逐格准确率）\n"
+        "  --jobs N         线程数（默认硬件线程数）\n"
+        "  --min-accuracy L,Y,C  定位成功率、行列正确率、逐格准确率（%）的下限，任一低于下限时退出码为 1\n";
+}
+
+static bool parseArgs(int argc, char** argv, SynthCliOptions& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--count" && i + 1 < argc) opt.count = std::max(1LL, std::atoll(argv[++i]));
+        else if (a == "--size" && i + 2 < argc) {
+            opt.rows = std::max(1, std::atoi(argv[++i]));
+            opt.cols = std::max(1, std::atoi(argv[++i]));
+            if (i + 1 < argc && argv[i + 1][0] != '-') opt.mines = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (a == "--max-size" && i + 1 < argc) opt.maxSize = std::max(8, std::atoi(argv[++i]));
+        else if (a == "--skin" && i + 1 < argc) {
+            BoardSynthesizer::Skin s;
+            if (!BoardSynthesizer::ParseSkin(argv[++i], s)) { std::cerr << "未知皮肤: " << argv[i] << "\n"; return false; }
+            opt.skin = int(s);
+        }
+        else if (a == "--cell" && i + 1 < argc) opt.cell = std::max(4, std::atoi(argv[++i]));
+        else if (a == "--dpi" && i + 1 < argc) {
+            opt.dpis.clear();
+            std::stringstream ss(argv[++i]);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                double d = std::atof(item.c_str());
+                if (d >= 0.5 && d <= 4.0) opt.dpis.push_back(d);
+            }
+            if (opt.dpis.empty()) { std::cerr << "--dpi 无有效比例\n"; return false; }
+        }
+        else if (a == "--stretch") opt.stretch = true;
+        else if (a == "--chrome") opt.chrome = true;
+        else if (a == "--jpeg" && i + 1 < argc) opt.jpeg = std::min(100, std::max(0, std::atoi(argv[++i])));
+        else if (a == "--noise" && i + 1 < argc) opt.noise = std::max(0.0, std::atof(argv[++i]));
+        else if (a == "--seed" && i + 1 < argc) opt.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--out" && i + 1 < argc) opt.outDir = argv[++i];
+        else if (a == "--no-bench") opt.bench = false;
+        else if (a == "--full-cells") opt.fullCells = true;
+        else if (a == "--jobs" && i + 1 < argc) opt.jobs = std::max(1, std::atoi(argv[++i]));
+        else if (a == "--min-accuracy" && i + 1 < argc) {
+            if (std::sscanf(argv[++i], "%lf,%lf,%lf", &opt.minLocated, &opt.minLayout, &opt.minCells) != 3) {
+                std::cerr << "--min-accuracy 需要三个以逗号分隔的百分比\n";
+                return false;
+            }
+        }
+        else if (a == "-h" || a == "--help") return false;
+        else { std::cerr << "未知选项: " << a << "\n"; return false; }
+    }
+    if (!opt.bench && opt.outDir.empty()) { std::cerr << "--no-bench 需要 --out\n"; return false; }
+    if (!opt.bench && opt.minLocated >= 0) { std::cerr << "--min-accuracy 不能与 --no-bench 同用\n"; return false; }
+    return true;
+}
+
+// 第 index 帧的参数：只由种子与序号决定
+static BoardSynthesizer::Options frameOptions(const SynthCliOptions& opt, long long index, std::mt19937_64& rng) {
+    BoardSynthesizer::Options o;
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    if (opt.rows > 0) {
+        o.rows = opt.rows;
+        o.cols = opt.cols;
+        o.mines = opt.mines >= 0 ? opt.mines : int(o.rows * o.cols * 0.15);
+    } else if (unit(rng) < 0.5) {
+        static const int kStandard[3][3] = { {9, 9, 10}, {16, 16, 40}, {16, 30, 99} };
+        const int* s = kStandard[rng() % 3];
+        o.rows = s[0]; o.cols = s[1]; o.mines = s[2];
+    } else {
+        std::uniform_int_distribution<int> dim(8, opt.maxSize);
+        o.rows = dim(rng);
+        o.cols = dim(rng);
+        o.mines = int(o.rows * o.cols * (0.12 + 0.08 * unit(rng)));
+    }
+    o.skin = BoardSynthesizer::Skin(opt.skin >= 0 ? opt.skin : int(index % BoardSynthesizer::kSkinCount));
+    o.cellSize = opt.cell > 0 ? opt.cell : std::uniform_int_distribution<int>(12, 32)(rng);
+    o.dpiScale = opt.dpis[rng() % opt.dpis.size()];
+    o.bitmapStretch = opt.stretch;
+    if (opt.chrome) {
+        switch (o.skin) {
+        case BoardSynthesizer::Skin::ClassicXp: o.chrome = BoardSynthesizer::Chrome::Xp; break;
+        case BoardSynthesizer::Skin::Win7: o.chrome = BoardSynthesizer::Chrome::Aero; break;
+        default: o.chrome = BoardSynthesizer::Chrome::Browser; break;
+        }
+    }
+    o.revealed = 0.9 * unit(rng);
+    o.flagged = 0.6 * unit(rng);
+    o.lost = unit(rng) < 0.1;
+    o.jpegQuality = opt.jpeg;
+    o.noiseSigma = opt.noise;
+    return o;
+}
+
+// 格值 -1..10 → 类别下标 0..11；识别器的其它输出（如 11）计入最后一类
+static const int kClasses = 13;
+static int classIndex(int v) { return (v >= -1 && v <= 10) ? v + 1 : kClasses - 1; }
+static const char* className(int k) {
+    static const char* names[kClasses] = { "mine", "0", "1", "2", "3", "4", "5", "6", "7", "8", "unopened", "flag", "other" };
+    return names[k];
+}
+
+struct BenchStats {
+    long long frames = 0;
+    long long located = 0;          // 流水线返回成功
+    long long layoutOk = 0;         // 行列与真值一致
+    double iouSum = 0.0;            // 网格区域与真值的 IoU
+    long long boardsPerfect = 0;    // 行列一致且全部格子正确
+    long long cells = 0, cellsOk = 0;
+    double ms = 0.0;
+    std::array<std::array<long long, kClasses>, kClasses> confusion{}; // [真值][识别]
+
+    void Merge(const BenchStats& o) {
+        frames += o.frames; located += o.located; layoutOk += o.layoutOk; iouSum += o.iouSum;
+        boardsPerfect += o.boardsPerfect; cells += o.cells; cellsOk += o.cellsOk; ms += o.ms;
+        for (int i = 0; i < kClasses; ++i)
+            for (int j = 0; j < kClasses; ++j) confusion[i][j] += o.confusion[i][j];
+    }
+};
+
+static double iou(const cv::Rect& a, const cv::Rect& b) {
+    const double inter = (a & b).area();
+    const double uni = double(a.area()) + b.area() - inter;
+    return uni > 0 ? inter / uni : 0.0;
+}
+
+static void score(const BoardSynthesizer::Frame& f, bool ok, const GameState& state, const cv::Rect& board,
+                  double ms, BenchStats& s) {
+    s.frames++;
+    s.ms += ms;
+    if (!ok) return;
+    s.located++;
+    s.iouSum += iou(board, f.board);
+    if (state.rows != f.truth.rows || state.cols != f.truth.cols) return;
+    s.layoutOk++;
+    long long wrong = 0;
+    for (int r = 0; r < state.rows; ++r) {
+        for (int c = 0; c < state.cols; ++c) {
+            const int t = f.truth.grid[r][c], p = state.grid[r][c];
+            s.confusion[classIndex(t)][classIndex(p)]++;
+            if (t != p) wrong++;
+        }
+    }
+    s.cells += (long long)state.rows * state.cols;
+    s.cellsOk += (long long)state.rows * state.cols - wrong;
+    if (wrong == 0) s.boardsPerfect++;
+}
+
+static void printStats(const std::string& label, const BenchStats& s) {
+    char buf[256];
+    const double n = double(std::max(1LL, s.frames));
+    std::snprintf(buf, sizeof(buf), "%-11s frames=%lld located=%.1f%% layout=%.1f%% iou=%.3f cells=%.2f%% perfect=%.1f%% ms/frame=%.2f",
+                  label.c_str(), s.frames, 100.0 * s.located / n, 100.0 * s.layoutOk / n,
+                  s.located ? s.iouSum / s.located : 0.0, s.cells ? 100.0 * s.cellsOk / s.cells : 0.0,
+                  100.0 * s.boardsPerfect / n, s.ms / n);
+    std::cout << buf << "\n";
+}
+
+// 与下限比较，逐项报告未达标的指标；供 ctest 判定
+static bool checkFloors(const SynthCliOptions& opt, const BenchStats& s) {
+    if (opt.minLocated < 0) return true;
+    const double n = double(std::max(1LL, s.frames));
+    const double got[3] = { 100.0 * s.located / n, 100.0 * s.layoutOk / n, s.cells ? 100.0 * s.cellsOk / s.cells : 0.0 };
+    const double want[3] = { opt.minLocated, opt.minLayout, opt.minCells };
+    static const char* names[3] = { "located", "layout", "cells" };
+    bool ok = true;
+    for (int k = 0; k < 3; ++k) {
+        if (got[k] >= want[k]) continue;
+        std::fprintf(stderr, "FAIL %s=%.2f%% < %.2f%%\n", names[k], got[k], want[k]);
+        ok = false;
+    }
+    return ok;
+}
+
+static void printConfusion(const BenchStats& s) {
+    // 按类召回率，以及最常见的错认
+    std::cout << "per-class recall (layout-correct boards):\n";
+    for (int t = 0; t < kClasses; ++t) {
+        long long total = 0;
+        for (int p = 0; p < kClasses; ++p) total += s.confusion[t][p];
+        if (!total) continue;
+        std::cout << "  " << className(t) << ": " << (100.0 * s.confusion[t][t] / total) << "% of " << total << "\n";
+    }
+    std::vector<std::pair<long long, std::pair<int, int>>> errors;
+    for (int t = 0; t < kClasses; ++t)
+        for (int p = 0; p < kClasses; ++p)
+            if (t != p && s.confusion[t][p]) errors.push_back({ s.confusion[t][p], { t, p } });
+    std::sort(errors.rbegin(), errors.rend());
+    if (errors.size() > 8) errors.resize(8);
+    if (!errors.empty()) std::cout << "top confusions (truth -> recognized):\n";
+    for (const auto& e : errors)
+        std::cout << "  " << className(e.second.first) << " -> " << className(e.second.second) << ": " << e.first << "\n";
+}
+
+int main(int argc, char** argv) {
+    SynthCliOptions opt;
+    if (!parseArgs(argc, argv, opt)) { printUsage(); return 2; }
+    trace::SetThreadName("main");
+    cv::setNumThreads(1); // 并行度由 --jobs 决定
+    FrameArena::Install();
+    const int jobs = opt.jobs > 0 ? opt.jobs : int(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::ofstream truthOut;
+    if (!opt.outDir.empty()) {
+        std::error_code ec;
+        fs::create_directories(opt.outDir, ec);
+        truthOut.open(fs::path(opt.outDir) / "truth.jsonl");
+        if (!truthOut) { std::cerr << "无法写入 " << opt.outDir << "\n"; return 1; }
+    }
+
+    std::unique_ptr<GameAnalyzer> analyzer;
+    if (opt.bench) {
+        analyzer = std::make_unique<GameAnalyzer>();
+        analyzer->SetSparseProbes(!opt.fullCells);
+    }
+    std::atomic<long long> next(0);
+    std::mutex mutex; // 保护 truthOut 与汇总
+    std::array<BenchStats, BoardSynthesizer::kSkinCount> perSkin{};
+    const auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (int w = 0; w < jobs; ++w) {
+        workers.emplace_back([&, w] {
+            trace::SetThreadName("synth " + std::to_string(w));
+            BoardSynthesizer synth;
+            std::unique_ptr<FramePipeline> pipeline;
+            if (analyzer) pipeline = std::make_unique<FramePipeline>(*analyzer, false);
+            std::array<BenchStats, BoardSynthesizer::kSkinCount> local{};
+            BoardSynthesizer::Frame frame;
+            GameState state;
+            cv::Rect board;
+            std::string record;
+            for (long long i = next++; i < opt.count; i = next++) {
+                synth.Seed(opt.seed * 0x9E3779B97F4A7C15ull + uint64_t(i));
+                const BoardSynthesizer::Options o = frameOptions(opt, i, synth.Rng());
+                synth.Next(o, frame);
+                if (pipeline) {
+                    const auto a = std::chrono::steady_clock::now();
+                    pipeline->Reset();
+                    state = GameState();
+                    const bool ok = pipeline->Process(frame.image, state, board);
+                    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - a).count();
+                    score(frame, ok, state, board, ms, local[int(o.skin)]);
+                }
+                if (truthOut.is_open()) {
+                    char name[32];
+                    std::snprintf(name, sizeof(name), "synth_%08lld.png", i);
+                    cv::imwrite((fs::path(opt.outDir) / name).string(), frame.image);
+                    char buf[160];
+                    std::snprintf(buf, sizeof(buf), ",\"skin\":\"%s\",\"cell\":%d,\"dpi\":%.2f,\"stretch\":%d,\"pitch\":%.3f,"
+                                  "\"mines\":%d,\"minesLeft\":%d,\"seconds\":%d,",
+                                  BoardSynthesizer::SkinName(o.skin), o.cellSize, o.dpiScale, o.bitmapStretch ? 1 : 0,
+                                  frame.cellPitch, frame.truth.mineCount, frame.minesLeft, frame.seconds);
+                    record = "{\"i\":" + std::to_string(i) + ",\"file\":";
+                    AppendJsonString(record, name);
+                    record += buf;
+                    record += "\"client\":[" + std::to_string(frame.client.x) + "," + std::to_string(frame.client.y) + ","
+                            + std::to_string(frame.client.width) + "," + std::to_string(frame.client.height) + "],";
+                    AppendBoardJson(record, frame.truth, frame.board);
+                    record += "}\n";
+                    std::lock_guard<std::mutex> lock(mutex);
+                    truthOut << record;
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int k = 0; k < BoardSynthesizer::kSkinCount; ++k) perSkin[k].Merge(local[k]);
+        });
+    }
+    for (auto& t : workers) t.join();
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "frames=" << opt.count << " jobs=" << jobs << " elapsed=" << sec << "s fps=" << (sec > 0 ? opt.count / sec : 0.0)
+              << " arena_peak_kb=" << FrameArena::GlobalPeakBytes() / 1024 << "\n";
+    bool passed = true;
+    if (opt.bench) {
+        BenchStats all;
+        for (int k = 0; k < BoardSynthesizer::kSkinCount; ++k) {
+            if (!perSkin[k].frames) continue;
+            printStats(BoardSynthesizer::SkinName(BoardSynthesizer::Skin(k)), perSkin[k]);
+            all.Merge(perSkin[k]);
+        }
+        printStats("all", all);
+        printConfusion(all);
+        std::cout << "\n";
+        metrics::Dump(std::cout);
+        passed = checkFloors(opt, all);
+    }
+    return passed ? 0 : 1;
+}
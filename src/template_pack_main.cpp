@@ -0,0 +1,50 @@
+// 离线模板打包：把 resources/templates/ 下各皮肤的格子截图预处理为多尺寸、
+// 已归一化的模板，写成单个可内存映射的模板包（默认 resources/templates.mstpk）。
+// 模板有增改后重新运行即可；分析器启动时只映射该文件，不再解码与缩放。
+#include "TemplatePack.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static void printUsage() {
+    std::cout <<
+        "用法: MinesweeperTemplatePack [选项] [模板目录] [输出文件]\n"
+        "  模板目录默认 resources/templates，输出默认 resources/templates.mstpk\n"
+        "  --min N   最小格子尺寸（像素，默认 8）\n"
+        "  --max N   最大格子尺寸（像素，默认 96）\n"
+        "模板目录根为 default 皮肤，每个子目录为一种皮肤；\n"
+        "文件名 1–8、flag、mine、unopened（.png/.bmp），内容为整个格子的截图\n";
+}
+
+int main(int argc, char** argv) {
+    TemplatePack::BuildOptions options;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--min" && i + 1 < argc) options.minCell = std::atoi(argv[++i]);
+        else if (a == "--max" && i + 1 < argc) options.maxCell = std::atoi(argv[++i]);
+        else if (a == "-h" || a == "--help") { printUsage(); return 0; }
+        else if (!a.empty() && a[0] == '-') { std::cerr << "未知选项: " << a << "\n"; printUsage(); return 2; }
+        else paths.push_back(a);
+    }
+    if (paths.size() > 2) { printUsage(); return 2; }
+    fs::path src = paths.size() > 0 ? fs::path(paths[0]) : fs::path("resources/templates");
+    fs::path out = paths.size() > 1 ? fs::path(paths[1]) : fs::path("resources/templates.mstpk");
+
+    std::string report;
+    if (!TemplatePack::Build(src, out, options, report)) {
+        std::cerr << "打包失败: " << report << "\n";
+        return 1;
+    }
+    // 回读校验：与运行时走同一加载路径
+    TemplatePack pack;
+    if (!pack.Open(out)) {
+        std::cerr << "打包结果无法加载: " << out.string() << "\n";
+        return 1;
+    }
+    std::cout << out.string() << ": " << report << "\n";
+    return 0;
+}